@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../DSP/ParameterGenerator.h"
+#include "../DSP/ParameterSnapshot.h"
 #include "../DSP/ReferenceProfile.h"
 #include <juce_core/juce_core.h>
 #include <map>
@@ -78,6 +79,15 @@ public:
         isDirty = true;
     }
 
+    // Same, from full parameter snapshots
+    void recordUserAdjustment(
+        const ParameterSnapshot& suggested,
+        const ParameterSnapshot& userFinal,
+        ReferenceProfile::Genre genre = ReferenceProfile::Genre::Auto)
+    {
+        recordUserAdjustment(suggested.toGeneratedParameters(), userFinal.toGeneratedParameters(), genre);
+    }
+
     // Apply learned biases to generated parameters
     ParameterGenerator::GeneratedParameters applyLearning(
         const ParameterGenerator::GeneratedParameters& params,
@@ -1,14 +1,20 @@
 #pragma once
 
 #include "SpectralAnalyzer.h"
+#include "ConstantQAnalyzer.h"
 #include "DynamicsAnalyzer.h"
 #include "StereoAnalyzer.h"
 #include "ReferenceProfile.h"
 #include "LoudnessMeter.h"
+#include "InputCapture.h"
+#include "FeatureTimeline.h"
+#include <juce_audio_formats/juce_audio_formats.h>
 #include <mutex>
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include <functional>
+#include <vector>
 
 class AnalysisEngine
 {
@@ -22,7 +28,7 @@ public:
         float avgWidth = 1.0f;
         float avgCorrelation = 1.0f;
         float avgCrestFactor = 12.0f;
-        int sampleCount = 0;
+        int readingCount = 0;  // One per FeatureTimeline frame (100 ms of audio)
         bool isValid = false;
 
         // Running sums for averaging
@@ -31,6 +37,24 @@ public:
         double widthSum = 0.0;
         double correlationSum = 0.0;
         double crestSum = 0.0;
+
+        uint32_t generation = 0;  // The startAccumulation() these sums belong to
+    };
+
+    // Consumers that need the detailed (spectral/stereo/dynamics/reference)
+    // analysis. Loudness and true peak always run because auto-gain needs them.
+    enum class Consumer
+    {
+        Editor               = 1 << 0,
+        ContinuousAutoMaster = 1 << 1
+    };
+
+    // Where the 32-band energy profile comes from: the display FFT, or the
+    // octave-decimated filterbank with equal relative resolution per band
+    enum class BandAnalysis
+    {
+        FFT,
+        ConstantQ
     };
 
     AnalysisEngine() = default;
@@ -40,15 +64,47 @@ public:
         stopAnalysis();
     }
 
-    void prepare(double sampleRate, int samplesPerBlock)
+    void prepare(double sampleRate, int samplesPerBlock,
+                 const juce::AudioChannelSet& layout = juce::AudioChannelSet::stereo())
     {
+        // A re-prepare with the same settings keeps the meters and history
+        // running rather than restarting integration
+        if (isPrepared && sampleRate == currentSampleRate && samplesPerBlock == currentBlockSize)
+        {
+            if (layout != currentLayout)
+            {
+                currentLayout = layout;
+                ownLoudnessMeter.setChannelLayout(layout);
+            }
+
+            if (captureSeconds != preparedCaptureSeconds || captureCompressed != preparedCaptureCompressed)
+                prepareCapture();
+            return;
+        }
+
         currentSampleRate = sampleRate;
         currentBlockSize = samplesPerBlock;
+        currentLayout = layout;
+        isPrepared = true;
 
+        // Spectral/dynamics/stereo analysis looks at the front L/R pair;
+        // loudness covers every channel with BS.1770 weighting
         spectralAnalyzer.prepare(sampleRate, samplesPerBlock);
+        constantQAnalyzer.prepare(sampleRate);
         dynamicsAnalyzer.prepare(sampleRate, samplesPerBlock);
         stereoAnalyzer.prepare(sampleRate, samplesPerBlock);
-        loudnessMeter.prepare(sampleRate, samplesPerBlock);
+        ownLoudnessMeter.prepare(sampleRate, samplesPerBlock, layout);
+        prepareCapture();
+
+        // Analyzer history plus a float copy of the L/R pair for double-precision hosts
+        stateArena.build([this] (DSPUtils::StateArena& arena)
+        {
+            dynamicsAnalyzer.allocateState(arena);
+            stereoAnalyzer.allocateState(arena);
+            featureTimeline.allocateState(arena);
+            conversionLeft = arena.allocate<float>(std::max(1, currentBlockSize));
+            conversionRight = arena.allocate<float>(std::max(1, currentBlockSize));
+        });
 
         reset();
     }
@@ -56,16 +112,21 @@ public:
     void reset()
     {
         spectralAnalyzer.reset();
+        constantQAnalyzer.reset();
         dynamicsAnalyzer.reset();
         stereoAnalyzer.reset();
-        loudnessMeter.reset();
+        ownLoudnessMeter.reset();
+        featureTimeline.reset();
+        samplesSinceFrame = 0;
 
         analysisValid.store(false);
         referenceMatchScore.store(0.0f);
+        detailedAnalysisRunning = false;
     }
 
     // Process audio for analysis (called from audio thread)
-    void process(juce::AudioBuffer<float>& buffer)
+    template <typename SampleType>
+    void process(const juce::AudioBuffer<SampleType>& buffer)
     {
         const int numSamples = buffer.getNumSamples();
         const int numChannels = buffer.getNumChannels();
@@ -73,26 +134,91 @@ public:
         if (numChannels < 1)
             return;
 
-        // Loudness metering (non-destructive copy)
-        juce::AudioBuffer<float> meterCopy(buffer);
-        loudnessMeter.process(meterCopy);
+        // Loudness metering (reads the buffer, never modifies it); a shared
+        // meter is fed by its owner
+        if (loudnessMeter == &ownLoudnessMeter)
+            ownLoudnessMeter.process(buffer);
 
-        // Get pointers for analysis
-        const float* left = buffer.getReadPointer(0);
-        const float* right = numChannels > 1 ? buffer.getReadPointer(1) : left;
+        // Always captured, so auto-master can look back without a replay
+        inputCapture.write(buffer.getReadPointer(0), buffer.getReadPointer(numChannels > 1 ? 1 : 0), numSamples);
 
-        // Feed analyzers
-        spectralAnalyzer.pushStereoSamples(left, right, numSamples);
-        dynamicsAnalyzer.process(left, right, numSamples);
-        stereoAnalyzer.process(left, right, numSamples);
+        // Skip the detailed analyzers when nobody is going to read them
+        if (!isDetailedAnalysisDemanded())
+        {
+            // Both restart from clean history when analysis resumes
+            detailedAnalysisRunning = false;
+            constantQRunning = false;
+            publishResults();
+            return;
+        }
+
+        // Resuming after a pause: drop stale filter/FFT history so the first
+        // results don't mix audio from before the pause
+        if (!detailedAnalysisRunning)
+        {
+            spectralAnalyzer.reset();
+            dynamicsAnalyzer.reset();
+            stereoAnalyzer.reset();
+            detailedAnalysisRunning = true;
+        }
+
+        // The filterbank only runs while selected; start it from clean history
+        const bool useConstantQ = getBandAnalysis() == BandAnalysis::ConstantQ;
+        if (useConstantQ && !constantQRunning)
+            constantQAnalyzer.reset();
+        constantQRunning = useConstantQ;
+
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            const float* left = buffer.getReadPointer(0);
+            const float* right = numChannels > 1 ? buffer.getReadPointer(1) : left;
+            analyzeStereo(left, right, numSamples);
+        }
+        else
+        {
+            // The analyzers are float-only; convert the pair in chunks that fit
+            // the buffer sized in prepare()
+            const int chunkSize = conversionLeft.size;
+            float* left = conversionLeft.data;
+            float* right = conversionRight.data;
+
+            for (int start = 0; start < numSamples; start += chunkSize)
+            {
+                const int count = std::min(chunkSize, numSamples - start);
+                const SampleType* srcL = buffer.getReadPointer(0, start);
+                const SampleType* srcR = numChannels > 1 ? buffer.getReadPointer(1, start) : srcL;
+
+                for (int i = 0; i < count; ++i)
+                {
+                    left[i] = static_cast<float>(srcL[i]);
+                    right[i] = static_cast<float>(srcR[i]);
+                }
+
+                analyzeStereo(left, right, count);
+            }
+        }
 
         // Update reference match if we have a reference
         updateReferenceMatch();
 
-        // Accumulate data if in accumulation mode
-        if (isAccumulating.load())
-            accumulateData();
+        // One timeline frame, and one accumulation reading, per 100 ms of
+        // audio whatever the block size
+        if (timelineResetRequested.exchange(false))
+            featureTimeline.reset();
 
+        const int frameLength = std::max(1, static_cast<int>(currentSampleRate * FeatureTimeline::FRAME_SECONDS));
+        for (samplesSinceFrame += numSamples; samplesSinceFrame >= frameLength; samplesSinceFrame -= frameLength)
+        {
+            const auto frame = makeFrame(getBandEnergies(), loudnessMeter->getShortTermLUFS(),
+                                         dynamicsAnalyzer.getAverageCrestFactor(),
+                                         stereoAnalyzer.getWidth(), stereoAnalyzer.getCorrelation());
+            featureTimeline.push(frame);
+
+            if (isAccumulating.load())
+                accumulateData(frame);
+        }
+
+        publishResults();
         analysisValid.store(true);
     }
 
@@ -113,12 +239,27 @@ public:
 
     bool hasReferenceProfile() const { return hasReference; }
 
+    // Mix loudness a reference match compares against the reference's
+    // integrated LUFS: integrated once the meter has gated any, short-term
+    // until then
+    static float getMatchLoudness(float integratedLUFS, float shortTermLUFS)
+    {
+        return integratedLUFS > -70.0f ? integratedLUFS : shortTermLUFS;
+    }
+
+    // Reads loudness from a meter that already sees the same input (the
+    // plugin's MeteringService input tap) instead of running a second one
+    void useSharedLoudnessMeter(LoudnessMeter& meter)
+    {
+        loudnessMeter = &meter;
+    }
+
     // Get aggregated analysis results
     struct AnalysisResults
     {
         // Spectral
         DSPUtils::SpectralFeatures spectral;
-        std::array<float, 32> bandEnergies;
+        std::array<float, 32> bandEnergies = {};
 
         // Dynamics
         DynamicsAnalyzer::DynamicsFeatures dynamics;
@@ -127,47 +268,51 @@ public:
         StereoAnalyzer::StereoFeatures stereo;
 
         // Loudness
-        float momentaryLUFS;
-        float shortTermLUFS;
-        float integratedLUFS;
-        float truePeak;
-        float loudnessRange;
+        float momentaryLUFS = DSPUtils::MINUS_INFINITY_DB;
+        float shortTermLUFS = DSPUtils::MINUS_INFINITY_DB;
+        float integratedLUFS = DSPUtils::MINUS_INFINITY_DB;
+        float truePeak = DSPUtils::MINUS_INFINITY_DB;
+        float loudnessRange = 0.0f;
 
         // Reference match
-        float referenceMatchScore;
-        bool hasReference;
+        float referenceMatchScore = 0.0f;
+        bool hasReference = false;
     };
 
+    // Every field from the same processed block; safe from any thread
     AnalysisResults getResults() const
     {
-        AnalysisResults results;
+        return publishedResults.read();
+    }
 
-        results.spectral = spectralAnalyzer.getSpectralFeatures();
-        results.bandEnergies = spectralAnalyzer.getBandEnergies();
-        results.dynamics = dynamicsAnalyzer.getFeatures();
-        results.stereo = stereoAnalyzer.getFeatures();
+    // Bumps once per processed block
+    uint32_t getResultsVersion() const { return publishedResults.getVersion(); }
 
-        results.momentaryLUFS = loudnessMeter.getMomentaryLUFS();
-        results.shortTermLUFS = loudnessMeter.getShortTermLUFS();
-        results.integratedLUFS = loudnessMeter.getIntegratedLUFS();
-        results.truePeak = loudnessMeter.getMaxTruePeak();
-        results.loudnessRange = loudnessMeter.getLoudnessRange();
+    // Selects the source of bandEnergies in the results (thread-safe)
+    void setBandAnalysis(BandAnalysis analysis)
+    {
+        bandAnalysis.store(static_cast<int>(analysis));
+    }
 
-        results.referenceMatchScore = referenceMatchScore.load();
-        results.hasReference = hasReference;
+    BandAnalysis getBandAnalysis() const { return static_cast<BandAnalysis>(bandAnalysis.load()); }
 
-        return results;
+    // 32-band energy profile from the selected analyzer
+    std::array<float, 32> getBandEnergies() const
+    {
+        return getBandAnalysis() == BandAnalysis::ConstantQ ? constantQAnalyzer.getBandEnergies()
+                                                            : spectralAnalyzer.getBandEnergies();
     }
 
     // Individual analyzer access
     const SpectralAnalyzer& getSpectralAnalyzer() const { return spectralAnalyzer; }
+    const ConstantQAnalyzer& getConstantQAnalyzer() const { return constantQAnalyzer; }
     const DynamicsAnalyzer& getDynamicsAnalyzer() const { return dynamicsAnalyzer; }
     const StereoAnalyzer& getStereoAnalyzer() const { return stereoAnalyzer; }
-    const LoudnessMeter& getLoudnessMeter() const { return loudnessMeter; }
+    const LoudnessMeter& getLoudnessMeter() const { return *loudnessMeter; }
 
     // Quick access to common values
-    float getShortTermLUFS() const { return loudnessMeter.getShortTermLUFS(); }
-    float getTruePeak() const { return loudnessMeter.getMaxTruePeak(); }
+    float getShortTermLUFS() const { return loudnessMeter->getShortTermLUFS(); }
+    float getTruePeak() const { return loudnessMeter->getMaxTruePeak(); }
     float getCorrelation() const { return stereoAnalyzer.getCorrelation(); }
     float getWidth() const { return stereoAnalyzer.getWidth(); }
     float getCrestFactor() const { return dynamicsAnalyzer.getAverageCrestFactor(); }
@@ -176,54 +321,71 @@ public:
 
     bool isAnalysisValid() const { return analysisValid.load(); }
 
+    // =========================================================================
+    // ANALYSIS DEMAND
+    // =========================================================================
+
+    // Register/unregister a consumer of the detailed analysis (thread-safe)
+    void addConsumer(Consumer consumer)
+    {
+        consumerMask.fetch_or(static_cast<int>(consumer));
+    }
+
+    void removeConsumer(Consumer consumer)
+    {
+        consumerMask.fetch_and(~static_cast<int>(consumer));
+    }
+
+    void setConsumerActive(Consumer consumer, bool active)
+    {
+        if (active)
+            addConsumer(consumer);
+        else
+            removeConsumer(consumer);
+    }
+
+    bool isDetailedAnalysisDemanded() const
+    {
+        return consumerMask.load() != 0 || isAccumulating.load();
+    }
+
     void resetIntegratedLoudness()
     {
-        loudnessMeter.resetIntegratedLoudness();
+        loudnessMeter->resetIntegratedLoudness();
     }
 
     // =========================================================================
     // ACCUMULATION METHODS (Ozone-style workflow)
     // =========================================================================
 
+    // The audio thread owns the running sums and publishes them after every
+    // reading; these calls only flip flags, and readers finalise the
+    // averages from the latest published sums.
     void startAccumulation()
     {
-        std::lock_guard<std::mutex> lock(accumulationMutex);
-        accumulatedAnalysis = AccumulatedAnalysis{};  // Reset
-        accumulationStartTime = std::chrono::steady_clock::now();
+        cancelOfflineAnalysis();
+        accumulationStartTicks.store(std::chrono::steady_clock::now().time_since_epoch().count());
+        accumulationGeneration.fetch_add(1);
         isAccumulating.store(true);
     }
 
     void stopAccumulation()
     {
-        std::lock_guard<std::mutex> lock(accumulationMutex);
         isAccumulating.store(false);
-
-        if (accumulatedAnalysis.sampleCount > 0)
-        {
-            // Finalize averages
-            float count = static_cast<float>(accumulatedAnalysis.sampleCount);
-            for (int i = 0; i < 32; ++i)
-                accumulatedAnalysis.avgSpectrum[i] = static_cast<float>(accumulatedAnalysis.spectrumSum[i] / count);
-
-            accumulatedAnalysis.avgLUFS = static_cast<float>(accumulatedAnalysis.lufsSum / count);
-            accumulatedAnalysis.avgWidth = static_cast<float>(accumulatedAnalysis.widthSum / count);
-            accumulatedAnalysis.avgCorrelation = static_cast<float>(accumulatedAnalysis.correlationSum / count);
-            accumulatedAnalysis.avgCrestFactor = static_cast<float>(accumulatedAnalysis.crestSum / count);
-            accumulatedAnalysis.isValid = true;
-        }
     }
 
     bool isAccumulationActive() const { return isAccumulating.load(); }
-    bool hasValidAccumulation() const { return accumulatedAnalysis.isValid; }
+    bool hasValidAccumulation() const { return getAccumulatedAnalysis().isValid; }
 
     float getAccumulationProgress() const
     {
+        if (offlineAnalysisRunning.load())
+            return offlineAnalysisProgress.load();
+
         if (!isAccumulating.load())
-            return accumulatedAnalysis.isValid ? 1.0f : 0.0f;
+            return hasValidAccumulation() ? 1.0f : 0.0f;
 
-        auto now = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - accumulationStartTime).count();
-        return juce::jlimit(0.0f, 1.0f, static_cast<float>(elapsed) / (accumulationDurationMs));
+        return juce::jlimit(0.0f, 1.0f, static_cast<float>(getAccumulationElapsedMs()) / accumulationDurationMs.load());
     }
 
     float getAccumulationTimeSeconds() const
@@ -231,132 +393,681 @@ public:
         if (!isAccumulating.load())
             return 0.0f;
 
-        auto now = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - accumulationStartTime).count();
-        return static_cast<float>(elapsed) / 1000.0f;
+        return static_cast<float>(getAccumulationElapsedMs()) / 1000.0f;
     }
 
     void setAccumulationDuration(float seconds)
     {
-        accumulationDurationMs = static_cast<int>(seconds * 1000.0f);
+        accumulationDurationMs.store(static_cast<int>(seconds * 1000.0f));
     }
 
     float getAccumulationDuration() const
     {
-        return static_cast<float>(accumulationDurationMs) / 1000.0f;
+        return static_cast<float>(accumulationDurationMs.load()) / 1000.0f;
     }
 
     void resetAccumulation()
     {
-        std::lock_guard<std::mutex> lock(accumulationMutex);
+        cancelOfflineAnalysis();
         isAccumulating.store(false);
-        accumulatedAnalysis = AccumulatedAnalysis{};
+        accumulationGeneration.fetch_add(1);
     }
 
     // Get accumulated results converted to AnalysisResults format
     AnalysisResults getAccumulatedResults() const
     {
-        std::lock_guard<std::mutex> lock(accumulationMutex);
+        return getResultsFor(getAccumulatedAnalysis());
+    }
+
+    // Averages from the accumulation or a timeline section as results, the
+    // rest from the real-time analysis; just the latter if not valid
+    AnalysisResults getResultsFor(const AccumulatedAnalysis& accumulated) const
+    {
+        // Return current real-time results as fallback
+        if (!accumulated.isValid)
+            return getResults();
 
-        AnalysisResults results;
+        AnalysisResults results = getResults();
+
+        results.bandEnergies = accumulated.avgSpectrum;
+        results.shortTermLUFS = accumulated.avgLUFS;
+        results.momentaryLUFS = accumulated.avgLUFS;
+        results.integratedLUFS = accumulated.avgLUFS;
+        results.truePeak = accumulated.peakLUFS + 3.0f;  // Rough estimate
+        results.loudnessRange = 6.0f;  // Default
+
+        results.stereo.width = accumulated.avgWidth;
+        results.stereo.correlation = accumulated.avgCorrelation;
+
+        // Fill crest factors array with the average value
+        for (auto& cf : results.dynamics.crestFactors)
+            cf = accumulated.avgCrestFactor;
+
+        return results;
+    }
+
+    // The latest published sums with their averages; valid once accumulation
+    // has stopped with at least one reading
+    AccumulatedAnalysis getAccumulatedAnalysis() const
+    {
+        const uint32_t generation = accumulationGeneration.load();
+
+        // A finished offline analysis, else the playback sums
+        AccumulatedAnalysis accumulated = publishedOfflineAccumulation.read();
+        if (accumulated.generation != generation)
+            accumulated = publishedAccumulation.read();
+
+        // Nothing published yet since the last start or reset
+        if (accumulated.generation != generation)
+            return AccumulatedAnalysis{};
 
-        if (accumulatedAnalysis.isValid)
+        if (accumulated.readingCount > 0)
         {
-            results.bandEnergies = accumulatedAnalysis.avgSpectrum;
-            results.shortTermLUFS = accumulatedAnalysis.avgLUFS;
-            results.momentaryLUFS = accumulatedAnalysis.avgLUFS;
-            results.integratedLUFS = accumulatedAnalysis.avgLUFS;
-            results.truePeak = accumulatedAnalysis.peakLUFS + 3.0f;  // Rough estimate
-            results.loudnessRange = 6.0f;  // Default
-
-            results.stereo.width = accumulatedAnalysis.avgWidth;
-            results.stereo.correlation = accumulatedAnalysis.avgCorrelation;
-
-            // Fill crest factors array with the average value
-            for (auto& cf : results.dynamics.crestFactors)
-                cf = accumulatedAnalysis.avgCrestFactor;
-
-            results.referenceMatchScore = referenceMatchScore.load();
-            results.hasReference = hasReference;
+            finalizeAverages(accumulated);
+            accumulated.isValid = !isAccumulating.load();
         }
-        else
+
+        return accumulated;
+    }
+
+    // =========================================================================
+    // FEATURE TIMELINE
+    // Every 100 ms of audio the detailed analysis runs over becomes a
+    // timeline frame, so the last album side or so can be split into
+    // sections and the rules pointed at the loudest one.
+    // =========================================================================
+
+    const FeatureTimeline& getFeatureTimeline() const { return featureTimeline; }
+
+    // Clears the timeline at the start of the next processed block
+    void resetFeatureTimeline() { timelineResetRequested.store(true); }
+
+    // Sections of the recorded timeline, oldest first. Copies the frames,
+    // so call from the message or a worker thread.
+    std::vector<FeatureTimeline::Section> getTimelineSections() const
+    {
+        return FeatureTimeline::findSections(featureTimeline.getFrames());
+    }
+
+    // Averages over the loudest section of the timeline (the chorus or drop,
+    // usually); not valid if the timeline holds nothing above the gate
+    AccumulatedAnalysis getLoudestSectionAnalysis() const
+    {
+        const auto frames = featureTimeline.getFrames();
+        const auto sections = FeatureTimeline::findSections(frames);
+
+        AccumulatedAnalysis analysis;
+        if (sections.empty())
+            return analysis;
+
+        const auto loudest = std::max_element(sections.begin(), sections.end(),
+                                              [] (const auto& a, const auto& b) { return a.loudness < b.loudness; });
+
+        for (int f = loudest->startFrame; f < loudest->endFrame; ++f)
+            addReading(analysis, frames[static_cast<size_t>(f)]);
+
+        if (analysis.readingCount > 0)
         {
-            // Return current real-time results as fallback
-            return getResults();
+            finalizeAverages(analysis);
+            analysis.isValid = true;
         }
 
-        return results;
+        return analysis;
+    }
+
+    // =========================================================================
+    // OFFLINE ANALYSIS
+    // Fills the accumulation from a file, or from the input captured over
+    // the last minute or so, instead of from playback. A background thread
+    // runs its own set of analyzers over the audio as fast as it can, so
+    // the realtime analysis carries on undisturbed. The result replaces any
+    // accumulation in progress and reads back through
+    // getAccumulatedAnalysis() once the thread finishes.
+    // =========================================================================
+
+    static constexpr int OFFLINE_BLOCK_SIZE = 4096;
+    static constexpr int MAX_SCAN_THREADS = 8;
+
+    // Called on the analysis thread when an offline analysis has published
+    // its result (not when cancelled). Set before starting one.
+    std::function<void()> onOfflineAnalysisComplete;
+
+    // Analyzes the given range of the file in seconds, or all of it if the
+    // range is empty. Returns false if the file can't be read.
+    bool analyzeFile(const juce::File& file, juce::Range<double> rangeSeconds = {})
+    {
+        return startFileAnalysis(file, rangeSeconds, 0.0);
     }
 
-    const AccumulatedAnalysis& getAccumulatedAnalysis() const { return accumulatedAnalysis; }
+    // Finds the loudest stretch of the given length first, then analyzes it
+    bool analyzeLoudestSection(const juce::File& file, double seconds)
+    {
+        return startFileAnalysis(file, {}, seconds);
+    }
+
+    // Analyzes the newest captured input, up to the given length (0 = all
+    // of it). Returns false if nothing has been captured yet.
+    bool analyzeCapturedInput(double seconds = 0.0)
+    {
+        cancelOfflineAnalysis();
+
+        if (inputCapture.getNumAvailable() < OFFLINE_BLOCK_SIZE)
+            return false;
+
+        startOfflineJob(std::make_unique<OfflineAnalysisJob>(*this, seconds, getBandAnalysis()));
+        return true;
+    }
+
+    // Input capture length (MIN_SECONDS-MAX_SECONDS) and whether it is
+    // stored as 16-bit; takes effect at the next prepare()
+    void setCaptureSettings(double seconds, bool compressed)
+    {
+        captureSeconds = juce::jlimit(InputCapture::MIN_SECONDS, InputCapture::MAX_SECONDS, seconds);
+        captureCompressed = compressed;
+    }
+
+    double getCapturedSeconds() const { return inputCapture.getAvailableSeconds(); }
+
+    void cancelOfflineAnalysis()
+    {
+        if (offlineAnalysisJob != nullptr)
+        {
+            offlineAnalysisJob->stopThread(2000);
+            offlineAnalysisJob.reset();
+        }
+
+        offlineAnalysisRunning.store(false);
+        offlineAnalysisCompleted.store(false);
+    }
+
+    bool isOfflineAnalysisRunning() const { return offlineAnalysisRunning.load(); }
+
+    // True once after an offline analysis publishes its result; a cancelled,
+    // superseded or failed one never sets it
+    bool takeOfflineAnalysisCompleted() { return offlineAnalysisCompleted.exchange(false); }
+    float getOfflineAnalysisProgress() const { return offlineAnalysisProgress.load(); }
+
+    // The part of the file the last analysis covered, in seconds
+    juce::Range<double> getFileAnalysisRange() const
+    {
+        return { fileAnalysisRangeStart.load(), fileAnalysisRangeEnd.load() };
+    }
+
+    // Start and end in seconds of the loudest stretch of the given length,
+    // by K-weighted energy in 100 ms blocks. The file is split across up to
+    // MAX_SCAN_THREADS threads, each with its own reader; onProgress (0-1)
+    // is called from those threads. Returns an empty range if the file
+    // can't be read or the scan was stopped.
+    static juce::Range<double> findLoudestSection(const juce::File& file, double seconds,
+                                                  const std::function<bool()>& shouldStop = {},
+                                                  const std::function<void(float)>& onProgress = {})
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        if (!reader || reader->sampleRate <= 0.0)
+            return {};
+
+        const double sampleRate = reader->sampleRate;
+        const int64_t length = reader->lengthInSamples;
+        const int64_t blockLength = std::max(int64_t { 1 }, static_cast<int64_t>(sampleRate * 0.1));
+        const int64_t numBlocks = length / blockLength;
+        const int64_t windowBlocks = std::max(int64_t { 1 }, static_cast<int64_t>(std::round(seconds * 10.0)));
+
+        if (numBlocks <= windowBlocks)
+            return { 0.0, static_cast<double>(length) / sampleRate };
+
+        std::vector<float> blockPower(static_cast<size_t>(numBlocks), 0.0f);
+
+        // At least a minute of audio per thread
+        const int64_t minBlocksPerThread = 600;
+        const int numThreads = static_cast<int>(juce::jlimit(int64_t { 1 }, static_cast<int64_t>(MAX_SCAN_THREADS),
+                                                             std::min(static_cast<int64_t>(juce::SystemStats::getNumCpus()),
+                                                                      numBlocks / minBlocksPerThread)));
+        std::vector<std::thread> threads;
+        std::atomic<int64_t> blocksScanned { 0 };
+
+        const auto onBlockScanned = [&]
+        {
+            const int64_t scanned = blocksScanned.fetch_add(1) + 1;
+            if (onProgress)
+                onProgress(static_cast<float>(scanned) / static_cast<float>(numBlocks));
+        };
+
+        for (int t = 0; t < numThreads; ++t)
+        {
+            const int64_t firstBlock = numBlocks * t / numThreads;
+            const int64_t endBlock = numBlocks * (t + 1) / numThreads;
+
+            threads.emplace_back([&, firstBlock, endBlock]
+            {
+                scanBlockPower(file, blockLength, firstBlock, endBlock, blockPower.data(), shouldStop, onBlockScanned);
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        if (shouldStop && shouldStop())
+            return {};
+
+        // Slide the window along the blocks
+        double windowPower = 0.0;
+        for (int64_t b = 0; b < windowBlocks; ++b)
+            windowPower += blockPower[static_cast<size_t>(b)];
+
+        double loudestPower = windowPower;
+        int64_t loudestStart = 0;
+
+        for (int64_t b = windowBlocks; b < numBlocks; ++b)
+        {
+            windowPower += blockPower[static_cast<size_t>(b)] - blockPower[static_cast<size_t>(b - windowBlocks)];
+            if (windowPower > loudestPower)
+            {
+                loudestPower = windowPower;
+                loudestStart = b - windowBlocks + 1;
+            }
+        }
+
+        return { static_cast<double>(loudestStart * blockLength) / sampleRate,
+                 static_cast<double>((loudestStart + windowBlocks) * blockLength) / sampleRate };
+    }
 
 private:
-    void accumulateData()
+    // The background thread behind the offline analysis, with its own
+    // analyzers. Reads a file, or a copy of the captured input.
+    class OfflineAnalysisJob : public juce::Thread
     {
-        if (!isAccumulating.load())
-            return;
+    public:
+        OfflineAnalysisJob(AnalysisEngine& o, const juce::File& f, std::unique_ptr<juce::AudioFormatReader> r,
+                           juce::Range<double> range, double loudest, BandAnalysis bands)
+            : juce::Thread("Offline analysis"), owner(o), file(f), reader(std::move(r)),
+              rangeSeconds(range), loudestSeconds(loudest), bandAnalysis(bands)
+        {
+        }
 
-        std::lock_guard<std::mutex> lock(accumulationMutex);
+        OfflineAnalysisJob(AnalysisEngine& o, double seconds, BandAnalysis bands)
+            : juce::Thread("Offline analysis"), owner(o), captureSeconds(seconds), bandAnalysis(bands)
+        {
+        }
 
-        // Get current analysis values
-        auto spectrum = spectralAnalyzer.getBandEnergies();
-        float lufs = loudnessMeter.getShortTermLUFS();
-        float width = stereoAnalyzer.getWidth();
-        float correlation = stereoAnalyzer.getCorrelation();
-        float crest = dynamicsAnalyzer.getAverageCrestFactor();
+        void run() override
+        {
+            owner.runOfflineAnalysis(*this);
+            owner.offlineAnalysisRunning.store(false);
+        }
 
-        // Skip invalid readings
-        if (lufs < -70.0f)
+        AnalysisEngine& owner;
+        uint32_t generation = 0;
+
+        // File source
+        const juce::File file;
+        std::unique_ptr<juce::AudioFormatReader> reader;
+        juce::Range<double> rangeSeconds;
+        const double loudestSeconds = 0.0;
+
+        // Capture source, copied out at the start of the run
+        const double captureSeconds = 0.0;
+        juce::AudioBuffer<float> captured;
+
+        const BandAnalysis bandAnalysis;
+
+        SpectralAnalyzer spectralAnalyzer;
+        ConstantQAnalyzer constantQAnalyzer;
+        DynamicsAnalyzer dynamicsAnalyzer;
+        StereoAnalyzer stereoAnalyzer;
+        LoudnessMeter loudnessMeter;
+        DSPUtils::StateArena stateArena;
+    };
+
+    bool startFileAnalysis(const juce::File& file, juce::Range<double> rangeSeconds, double loudestSeconds)
+    {
+        cancelOfflineAnalysis();
+
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        if (!reader || reader->sampleRate <= 0.0 || reader->lengthInSamples < 1)
+            return false;
+
+        startOfflineJob(std::make_unique<OfflineAnalysisJob>(*this, file, std::move(reader), rangeSeconds,
+                                                             loudestSeconds, getBandAnalysis()));
+        return true;
+    }
+
+    void startOfflineJob(std::unique_ptr<OfflineAnalysisJob> job)
+    {
+        // Supersede whatever accumulation was under way
+        isAccumulating.store(false);
+        job->generation = accumulationGeneration.fetch_add(1) + 1;
+
+        offlineAnalysisProgress.store(0.0f);
+        offlineAnalysisRunning.store(true);
+        offlineAnalysisJob = std::move(job);
+        offlineAnalysisJob->startThread(juce::Thread::Priority::normal);
+    }
+
+    // Analysis thread: every analyzer over the chosen audio with one
+    // reading per 100 ms, as in playback
+    void runOfflineAnalysis(OfflineAnalysisJob& job)
+    {
+        if (job.reader != nullptr)
+        {
+            if (!chooseFileRange(job))
+                return;
+        }
+        else
+        {
+            // Copy the capture out first; the audio thread keeps writing to it
+            const int64_t wanted = job.captureSeconds > 0.0
+                                 ? static_cast<int64_t>(job.captureSeconds * inputCapture.getSampleRate())
+                                 : inputCapture.getCapacity();
+            const int64_t numFrames = std::min(wanted, inputCapture.getNumAvailable());
+
+            job.captured.setSize(2, static_cast<int>(std::max(int64_t { 1 }, numFrames)));
+            const int64_t numCaptured = inputCapture.readLatest(job.captured.getWritePointer(0),
+                                                                job.captured.getWritePointer(1), numFrames);
+            if (numCaptured < 1)
+                return;
+
+            job.captured.setSize(2, static_cast<int>(numCaptured), true);
+        }
+
+        const double sampleRate = job.reader != nullptr ? job.reader->sampleRate : inputCapture.getSampleRate();
+        const int64_t startSample = job.reader != nullptr ? static_cast<int64_t>(job.rangeSeconds.getStart() * sampleRate) : 0;
+        const int64_t endSample = job.reader != nullptr
+                                ? std::min(static_cast<int64_t>(job.reader->lengthInSamples), static_cast<int64_t>(job.rangeSeconds.getEnd() * sampleRate))
+                                : static_cast<int64_t>(job.captured.getNumSamples());
+        const float analysisProgressStart = offlineAnalysisProgress.load();
+
+        if (endSample <= startSample)
             return;
 
-        // Accumulate
-        for (int i = 0; i < 32; ++i)
-            accumulatedAnalysis.spectrumSum[i] += spectrum[i];
+        // Half overlap is plenty for an average and halves the FFT work
+        job.spectralAnalyzer.setOverlap(0.5f);
+        job.spectralAnalyzer.prepare(sampleRate, OFFLINE_BLOCK_SIZE);
+        job.constantQAnalyzer.prepare(sampleRate);
+        job.dynamicsAnalyzer.prepare(sampleRate, OFFLINE_BLOCK_SIZE);
+        job.stereoAnalyzer.prepare(sampleRate, OFFLINE_BLOCK_SIZE);
+        job.loudnessMeter.prepare(sampleRate, OFFLINE_BLOCK_SIZE);
 
-        accumulatedAnalysis.lufsSum += lufs;
-        accumulatedAnalysis.widthSum += width;
-        accumulatedAnalysis.correlationSum += correlation;
-        accumulatedAnalysis.crestSum += crest;
+        job.stateArena.build([&job] (DSPUtils::StateArena& arena)
+        {
+            job.dynamicsAnalyzer.allocateState(arena);
+            job.stereoAnalyzer.allocateState(arena);
+        });
 
-        // Track peak
-        if (lufs > accumulatedAnalysis.peakLUFS)
-            accumulatedAnalysis.peakLUFS = lufs;
+        job.dynamicsAnalyzer.reset();
+        job.stereoAnalyzer.reset();
+
+        const bool useConstantQ = job.bandAnalysis == BandAnalysis::ConstantQ;
+        juce::AudioBuffer<float> buffer(2, OFFLINE_BLOCK_SIZE);
+
+        AccumulatedAnalysis offlineAccumulation;
+        offlineAccumulation.generation = job.generation;
 
-        accumulatedAnalysis.sampleCount++;
+        const int frameLength = std::max(1, static_cast<int>(sampleRate * FeatureTimeline::FRAME_SECONDS));
+        int samplesSinceReading = 0;
 
-        // Auto-stop after duration
-        auto now = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - accumulationStartTime).count();
-        if (elapsed >= accumulationDurationMs)
+        for (int64_t position = startSample; position < endSample; position += OFFLINE_BLOCK_SIZE)
         {
-            // Stop without lock (we already have it)
-            isAccumulating.store(false);
+            if (job.threadShouldExit())
+                return;
+
+            const int numSamples = static_cast<int>(std::min(static_cast<int64_t>(OFFLINE_BLOCK_SIZE), endSample - position));
+
+            // Mono files come back in both channels
+            if (job.reader != nullptr)
+                job.reader->read(&buffer, 0, numSamples, position, true, true);
+            else
+                for (int ch = 0; ch < 2; ++ch)
+                    buffer.copyFrom(ch, 0, job.captured, ch, static_cast<int>(position), numSamples);
+
+            const float* left = buffer.getReadPointer(0);
+            const float* right = buffer.getReadPointer(1);
+
+            job.loudnessMeter.process(juce::AudioBuffer<float>(buffer.getArrayOfWritePointers(), 2, numSamples));
+            job.spectralAnalyzer.pushStereoSamples(left, right, numSamples);
+            if (useConstantQ)
+                job.constantQAnalyzer.pushStereoSamples(left, right, numSamples);
+            job.dynamicsAnalyzer.process(left, right, numSamples);
+            job.stereoAnalyzer.process(left, right, numSamples);
+
+            for (samplesSinceReading += numSamples; samplesSinceReading >= frameLength; samplesSinceReading -= frameLength)
+                addReading(offlineAccumulation,
+                           makeFrame(useConstantQ ? job.constantQAnalyzer.getBandEnergies() : job.spectralAnalyzer.getBandEnergies(),
+                                     job.loudnessMeter.getShortTermLUFS(),
+                                     job.dynamicsAnalyzer.getAverageCrestFactor(),
+                                     job.stereoAnalyzer.getWidth(),
+                                     job.stereoAnalyzer.getCorrelation()));
+
+            offlineAnalysisProgress.store(analysisProgressStart + (1.0f - analysisProgressStart)
+                                          * static_cast<float>(position + numSamples - startSample)
+                                          / static_cast<float>(endSample - startSample));
+        }
+
+        publishedOfflineAccumulation.publish(offlineAccumulation);
+        offlineAnalysisProgress.store(1.0f);
+
+        // Finished before anyone is told, so the callback's reader sees it done
+        offlineAnalysisCompleted.store(true);
+        offlineAnalysisRunning.store(false);
+
+        if (onOfflineAnalysisComplete)
+            onOfflineAnalysisComplete();
+    }
+
+    // Analysis thread: the optional loudest-section scan, then the range
+    // clipped to the file. Returns false if stopped or nothing is left.
+    bool chooseFileRange(OfflineAnalysisJob& job)
+    {
+        const auto shouldStop = [&job] { return job.threadShouldExit(); };
+
+        // The scan gets the first half of the progress bar
+        if (job.loudestSeconds > 0.0)
+        {
+            job.rangeSeconds = findLoudestSection(job.file, job.loudestSeconds, shouldStop,
+                                                  [this] (float progress) { offlineAnalysisProgress.store(0.5f * progress); });
+
+            if (job.threadShouldExit() || job.rangeSeconds.isEmpty())
+                return false;
+
+            offlineAnalysisProgress.store(0.5f);
+        }
+
+        const double lengthSeconds = static_cast<double>(job.reader->lengthInSamples) / job.reader->sampleRate;
+        job.rangeSeconds = job.rangeSeconds.isEmpty() ? juce::Range<double>(0.0, lengthSeconds)
+                                                      : job.rangeSeconds.getIntersectionWith({ 0.0, lengthSeconds });
+
+        fileAnalysisRangeStart.store(job.rangeSeconds.getStart());
+        fileAnalysisRangeEnd.store(job.rangeSeconds.getEnd());
+        return !job.rangeSeconds.isEmpty();
+    }
+
+    // One pre-scan thread: K-weighted mean square (channels summed) of each
+    // 100 ms block in [firstBlock, endBlock)
+    template <typename BlockCallback>
+    static void scanBlockPower(const juce::File& file, int64_t blockLength, int64_t firstBlock, int64_t endBlock,
+                               float* blockPower, const std::function<bool()>& shouldStop, BlockCallback&& onBlockScanned)
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        if (!reader)
+            return;
+
+        DSPUtils::BiquadCoeffs shelf, highPass;
+        LoudnessMeter::designKWeighting(reader->sampleRate, shelf, highPass);
+        std::array<DSPUtils::BiquadState, 2> shelfState, highPassState;
+
+        juce::AudioBuffer<float> buffer(2, static_cast<int>(blockLength));
+
+        // One block before the range settles the filters; it isn't counted
+        const int64_t warmupBlock = std::max(int64_t { 0 }, firstBlock - 1);
+
+        for (int64_t block = warmupBlock; block < endBlock; ++block)
+        {
+            if (shouldStop && shouldStop())
+                return;
 
-            if (accumulatedAnalysis.sampleCount > 0)
+            reader->read(&buffer, 0, static_cast<int>(blockLength), block * blockLength, true, true);
+
+            double power = 0.0;
+            for (int ch = 0; ch < 2; ++ch)
             {
-                float count = static_cast<float>(accumulatedAnalysis.sampleCount);
-                for (int i = 0; i < 32; ++i)
-                    accumulatedAnalysis.avgSpectrum[i] = static_cast<float>(accumulatedAnalysis.spectrumSum[i] / count);
-
-                accumulatedAnalysis.avgLUFS = static_cast<float>(accumulatedAnalysis.lufsSum / count);
-                accumulatedAnalysis.avgWidth = static_cast<float>(accumulatedAnalysis.widthSum / count);
-                accumulatedAnalysis.avgCorrelation = static_cast<float>(accumulatedAnalysis.correlationSum / count);
-                accumulatedAnalysis.avgCrestFactor = static_cast<float>(accumulatedAnalysis.crestSum / count);
-                accumulatedAnalysis.isValid = true;
+                const float* samples = buffer.getReadPointer(ch);
+                for (int i = 0; i < static_cast<int>(blockLength); ++i)
+                {
+                    const float weighted = highPassState[static_cast<size_t>(ch)].process(
+                        shelfState[static_cast<size_t>(ch)].process(samples[i], shelf), highPass);
+                    power += static_cast<double>(weighted * weighted);
+                }
+            }
+
+            if (block >= firstBlock)
+            {
+                blockPower[block] = static_cast<float>(power / static_cast<double>(blockLength));
+                onBlockScanned();
             }
         }
     }
 
+    // Reallocates the capture ring; the audio thread must not be running
+    void prepareCapture()
+    {
+        cancelOfflineAnalysis();
+        inputCapture.prepare(currentSampleRate, captureSeconds, captureCompressed);
+        preparedCaptureSeconds = captureSeconds;
+        preparedCaptureCompressed = captureCompressed;
+    }
+
+    int64_t getAccumulationElapsedMs() const
+    {
+        const std::chrono::steady_clock::time_point start { std::chrono::steady_clock::duration { accumulationStartTicks.load() } };
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Audio thread: adds one frame to the running sums and publishes them
+    void accumulateData(const FeatureTimeline::Frame& frame)
+    {
+        const uint32_t generation = accumulationGeneration.load();
+
+        // First reading since a start or reset
+        if (accumulation.generation != generation)
+        {
+            accumulation = AccumulatedAnalysis{};
+            accumulation.generation = generation;
+        }
+
+        if (!addReading(accumulation, frame))
+            return;
+
+        publishedAccumulation.publish(accumulation);
+
+        // Auto-stop after duration, unless a new accumulation has just started
+        if (getAccumulationElapsedMs() >= accumulationDurationMs.load()
+            && accumulationGeneration.load() == generation)
+            isAccumulating.store(false);
+    }
+
+    static FeatureTimeline::Frame makeFrame(const std::array<float, 32>& spectrum, float lufs,
+                                            float crest, float width, float correlation)
+    {
+        FeatureTimeline::Frame frame;
+        frame.bandEnergies = spectrum;
+        frame.shortTermLUFS = lufs;
+        frame.crestFactor = crest;
+        frame.width = width;
+        frame.correlation = correlation;
+        return frame;
+    }
+
+    // Adds one frame to the running sums; returns false for frames too
+    // quiet to count
+    static bool addReading(AccumulatedAnalysis& sums, const FeatureTimeline::Frame& frame)
+    {
+        const float lufs = frame.shortTermLUFS;
+
+        // Skip invalid readings
+        if (lufs < FeatureTimeline::SILENCE_LUFS)
+            return false;
+
+        // Accumulate
+        for (int i = 0; i < 32; ++i)
+            sums.spectrumSum[i] += frame.bandEnergies[i];
+
+        sums.lufsSum += lufs;
+        sums.widthSum += frame.width;
+        sums.correlationSum += frame.correlation;
+        sums.crestSum += frame.crestFactor;
+
+        // Track peak
+        if (lufs > sums.peakLUFS)
+            sums.peakLUFS = lufs;
+
+        sums.readingCount++;
+        return true;
+    }
+
+    static void finalizeAverages(AccumulatedAnalysis& sums)
+    {
+        const double count = static_cast<double>(sums.readingCount);
+        for (int i = 0; i < 32; ++i)
+            sums.avgSpectrum[i] = static_cast<float>(sums.spectrumSum[i] / count);
+
+        sums.avgLUFS = static_cast<float>(sums.lufsSum / count);
+        sums.avgWidth = static_cast<float>(sums.widthSum / count);
+        sums.avgCorrelation = static_cast<float>(sums.correlationSum / count);
+        sums.avgCrestFactor = static_cast<float>(sums.crestSum / count);
+    }
+
+    // Audio thread: one consistent set of everything getResults() returns
+    void publishResults()
+    {
+        AnalysisResults results;
+
+        results.spectral = spectralAnalyzer.getSpectralFeatures();
+        results.bandEnergies = getBandEnergies();
+        results.dynamics = dynamicsAnalyzer.getFeatures();
+        results.stereo = stereoAnalyzer.getFeatures();
+
+        results.momentaryLUFS = loudnessMeter->getMomentaryLUFS();
+        results.shortTermLUFS = loudnessMeter->getShortTermLUFS();
+        results.integratedLUFS = loudnessMeter->getIntegratedLUFS();
+        results.truePeak = loudnessMeter->getMaxTruePeak();
+        results.loudnessRange = loudnessMeter->getLoudnessRange();
+
+        results.referenceMatchScore = referenceMatchScore.load();
+        results.hasReference = hasReference;
+
+        publishedResults.publish(results);
+    }
+
 private:
+    void analyzeStereo(const float* left, const float* right, int numSamples)
+    {
+        spectralAnalyzer.pushStereoSamples(left, right, numSamples);
+        if (constantQRunning)
+            constantQAnalyzer.pushStereoSamples(left, right, numSamples);
+        dynamicsAnalyzer.process(left, right, numSamples);
+        stereoAnalyzer.process(left, right, numSamples);
+    }
+
     void updateReferenceMatch()
     {
         if (!hasReference)
             return;
 
-        std::lock_guard<std::mutex> lock(referenceMutex);
+        // Never wait on the message thread; a reference being swapped in is picked up next block
+        std::unique_lock<std::mutex> lock(referenceMutex, std::try_to_lock);
+        if (!lock.owns_lock())
+            return;
 
-        auto bandEnergies = spectralAnalyzer.getBandEnergies();
-        float currentLoudness = loudnessMeter.getShortTermLUFS();
+        auto bandEnergies = getBandEnergies();
+        float currentLoudness = getMatchLoudness(loudnessMeter->getIntegratedLUFS(), loudnessMeter->getShortTermLUFS());
         float currentWidth = stereoAnalyzer.getWidth();
         float currentCorrelation = stereoAnalyzer.getCorrelation();
 
@@ -368,17 +1079,26 @@ private:
 
     void stopAnalysis()
     {
-        // Cleanup if needed
+        cancelOfflineAnalysis();
     }
 
     double currentSampleRate = 44100.0;
     int currentBlockSize = 512;
+    juce::AudioChannelSet currentLayout;
+    bool isPrepared = false;
+
+    // Backing memory for the analyzers' history buffers
+    DSPUtils::StateArena stateArena;
+    DSPUtils::StateArray<float> conversionLeft;   // Double-precision input, audio thread only
+    DSPUtils::StateArray<float> conversionRight;
 
     // Analyzers
     SpectralAnalyzer spectralAnalyzer;
+    ConstantQAnalyzer constantQAnalyzer;
     DynamicsAnalyzer dynamicsAnalyzer;
     StereoAnalyzer stereoAnalyzer;
-    LoudnessMeter loudnessMeter;
+    LoudnessMeter ownLoudnessMeter;
+    LoudnessMeter* loudnessMeter = &ownLoudnessMeter;
 
     // Reference profile
     mutable std::mutex referenceMutex;
@@ -387,12 +1107,41 @@ private:
 
     // State
     std::atomic<bool> analysisValid { false };
+    std::atomic<int> consumerMask { 0 };
+    bool detailedAnalysisRunning = false;  // Audio thread only
+    std::atomic<int> bandAnalysis { static_cast<int>(BandAnalysis::FFT) };
+    bool constantQRunning = false;         // Audio thread only
     std::atomic<float> referenceMatchScore { 0.0f };
 
+    // Published results
+    DSPUtils::SeqLock<AnalysisResults> publishedResults;
+
     // Accumulation state (Ozone-style workflow)
-    mutable std::mutex accumulationMutex;
     std::atomic<bool> isAccumulating { false };
-    AccumulatedAnalysis accumulatedAnalysis;
-    std::chrono::steady_clock::time_point accumulationStartTime;
-    int accumulationDurationMs = 10000;  // Default 10 seconds
+    std::atomic<uint32_t> accumulationGeneration { 0 };
+    std::atomic<std::chrono::steady_clock::rep> accumulationStartTicks { 0 };
+    std::atomic<int> accumulationDurationMs { 10000 };  // Default 10 seconds
+    AccumulatedAnalysis accumulation;  // Audio thread only
+    DSPUtils::SeqLock<AccumulatedAnalysis> publishedAccumulation;
+
+    // Feature timeline (written by the audio thread)
+    FeatureTimeline featureTimeline;
+    int samplesSinceFrame = 0;  // Audio thread only
+    std::atomic<bool> timelineResetRequested { false };
+
+    // Input capture; settings are applied in prepare()
+    InputCapture inputCapture;
+    double captureSeconds = 60.0;
+    bool captureCompressed = true;
+    double preparedCaptureSeconds = 0.0;
+    bool preparedCaptureCompressed = true;
+
+    // Offline analysis (message thread starts and stops the job)
+    std::unique_ptr<OfflineAnalysisJob> offlineAnalysisJob;
+    std::atomic<bool> offlineAnalysisRunning { false };
+    std::atomic<bool> offlineAnalysisCompleted { false };
+    std::atomic<float> offlineAnalysisProgress { 0.0f };
+    std::atomic<double> fileAnalysisRangeStart { 0.0 };
+    std::atomic<double> fileAnalysisRangeEnd { 0.0 };
+    DSPUtils::SeqLock<AccumulatedAnalysis> publishedOfflineAccumulation;  // Written by the job thread
 };
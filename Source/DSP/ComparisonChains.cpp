@@ -0,0 +1,3 @@
+// ComparisonChains implementation
+// All functionality is in the header file
+#include "ComparisonChains.h"
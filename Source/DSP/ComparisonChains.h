@@ -0,0 +1,505 @@
+#pragma once
+
+#include "MasteringChain.h"
+#include "DSPUtils.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// A/B/C/D comparison with one complete MasteringChain per slot.
+//
+// Every stored slot keeps processing its own copy of the input, so its
+// filters, envelopes and lookahead are warm by the time it becomes audible.
+// Switching slots is then a short crossfade between two outputs that already
+// exist rather than a state reload. Shadow slots are rendered on worker
+// threads while the audio thread renders the audible one; the audio thread
+// also picks up any shadow slot a worker hasn't started yet, so a late
+// wake-up costs time but never output.
+//
+// Workers sit outside the host's audio workgroup and can be descheduled, so
+// the audio thread waits only a bounded time for a slot a worker has already
+// started. A slot that misses the block skips it and warms up again from
+// clean state. Workers run only while there are shadow slots to render.
+class ComparisonChains
+{
+public:
+    static constexpr int NUM_SLOTS = 4;
+    static constexpr double CROSSFADE_SECONDS = 0.02;
+    static constexpr double WARMUP_SECONDS = 0.1;  // Envelopes settle before a slot may become audible
+    static constexpr double MAX_WAIT_BLOCKS = 0.5;  // Longest wait for a worker, in block durations
+
+    ComparisonChains()
+    {
+        const int numWorkers = std::min(NUM_SLOTS - 1, juce::SystemStats::getNumCpus() - 1);
+
+        for (int w = 0; w < numWorkers; ++w)
+            workers.push_back(std::make_unique<Worker>(*this));
+    }
+
+    ~ComparisonChains()
+    {
+        workersEnabled = false;
+        updateWorkers();
+    }
+
+    void prepare(double sampleRate, int samplesPerBlock,
+                 const juce::AudioChannelSet& layout = juce::AudioChannelSet::stereo(),
+                 juce::AudioProcessor::ProcessingPrecision precision = juce::AudioProcessor::singlePrecision)
+    {
+        waitForWorkers();
+
+        for (auto& chain : chains)
+            chain.prepare(sampleRate, samplesPerBlock, layout, precision);
+
+        numChannels = layout.size();
+        maxBlockSize = samplesPerBlock;
+        jobIsDouble = precision == juce::AudioProcessor::doublePrecision;
+
+        // Input copies for the shadow slots, at the host's precision only
+        if (jobIsDouble)
+        {
+            slotBuffers.get<double>().setSize(numChannels, maxBlockSize);
+            slotBuffers.get<float>().setSize(0, 0);
+        }
+        else
+        {
+            slotBuffers.get<float>().setSize(numChannels, maxBlockSize);
+            slotBuffers.get<double>().setSize(0, 0);
+        }
+
+        crossfadeLength = std::max(1, static_cast<int>(sampleRate * CROSSFADE_SECONDS));
+        warmupLength = chains[0].getLatencySamples() + static_cast<int>(sampleRate * WARMUP_SECONDS);
+        maxWaitMs = 1000.0 * MAX_WAIT_BLOCKS * samplesPerBlock / sampleRate;
+
+        workersEnabled = true;
+        updateWorkers();
+
+        reset();
+    }
+
+    // Stops the workers until the next prepare()
+    void releaseResources()
+    {
+        workersEnabled = false;
+        updateWorkers();
+
+        reset();
+    }
+
+    // Not called while process() is running
+    void reset()
+    {
+        waitForWorkers();
+
+        for (auto& chain : chains)
+            chain.reset();
+
+        audibleSlot = selectedSlot.load();
+        fadeFromSlot = -1;
+        fadePosition = 0;
+
+        // All chains restart together, so none is colder than the audible one
+        runningSlots = liveSlots.load();
+        stalledSlots = 0;
+        warmSamples.fill(warmupLength);
+    }
+
+    // ===== Message thread =====
+
+    // Starts running a slot's chain; unless the slot is the one being edited it
+    // takes the current parameter values once, on the next block
+    void storeSlot(int slot)
+    {
+        if (!isValidSlot(slot))
+            return;
+
+        liveSlots.fetch_or(1 << slot);
+
+        if (slot != parameterSlot.load())
+            pendingParameterSlots.fetch_or(1 << slot);
+
+        updateWorkers();
+    }
+
+    // Stops running a stored slot's chain; the selected slot stays stored
+    void releaseSlot(int slot)
+    {
+        if (!isValidSlot(slot) || slot == selectedSlot.load())
+            return;
+
+        liveSlots.fetch_and(~(1 << slot));
+        pendingParameterSlots.fetch_and(~(1 << slot));
+
+        updateWorkers();
+    }
+
+    // Makes a stored slot audible. Its chain already runs with its own
+    // settings, so parameters are detached from every chain until the caller
+    // has brought them in line with the slot and calls attachParameters()
+    void selectSlot(int slot)
+    {
+        if (!isValidSlot(slot) || (liveSlots.load() & (1 << slot)) == 0)
+            return;
+
+        parameterSlot.store(-1);
+        selectedSlot.store(slot);
+    }
+
+    void attachParameters(int slot)
+    {
+        if (isValidSlot(slot))
+            parameterSlot.store(slot);
+    }
+
+    int getSelectedSlot() const { return selectedSlot.load(); }
+    bool isSlotStored(int slot) const { return isValidSlot(slot) && (liveSlots.load() & (1 << slot)) != 0; }
+
+    MasteringChain& getChain(int slot) { return chains[static_cast<size_t>(slot)]; }
+    MasteringChain& getSelectedChain() { return getChain(selectedSlot.load()); }
+    const MasteringChain& getSelectedChain() const { return chains[static_cast<size_t>(selectedSlot.load())]; }
+
+    int getLatencySamples() const { return chains[0].getLatencySamples(); }
+
+    // ===== Audio thread =====
+
+    // Calls function for every chain that should take the live parameter
+    // values this block: the slot being edited, plus any slot just stored.
+    // A stalled slot's worker may still be inside its chain, so it is left
+    // alone; a pending update waits until the slot is back.
+    template <typename Function>
+    void forEachChainFollowingParameters(Function&& function)
+    {
+        const int slot = parameterSlot.load(std::memory_order_acquire);
+        if (slot >= 0 && (stalledSlots & (1 << slot)) == 0)
+            function(chains[static_cast<size_t>(slot)]);
+
+        const int pending = pendingParameterSlots.exchange(0, std::memory_order_acq_rel);
+        const int deferred = pending & stalledSlots;
+        if (deferred != 0)
+            pendingParameterSlots.fetch_or(deferred, std::memory_order_acq_rel);
+
+        for (int s = 0; s < NUM_SLOTS; ++s)
+            if (((pending & ~deferred) & (1 << s)) != 0 && s != slot)
+                function(chains[static_cast<size_t>(s)]);
+    }
+
+    // Blocks larger than the size given to prepare() run in pieces that fit
+    // the shadow slots' input copies
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer)
+    {
+        const int numSamples = buffer.getNumSamples();
+
+        if (numSamples <= maxBlockSize)
+        {
+            processBlock(buffer);
+            return;
+        }
+
+        for (int start = 0; start < numSamples; start += maxBlockSize)
+        {
+            juce::AudioBuffer<SampleType> block(buffer.getArrayOfWritePointers(), buffer.getNumChannels(),
+                                                start, std::min(maxBlockSize, numSamples - start));
+            processBlock(block);
+        }
+    }
+
+private:
+    enum JobState { idle, queued, rendering };
+
+    // One shadow slot's block; the slot's input copy and chain belong to
+    // whoever moved state from queued to rendering, until it is idle again
+    struct alignas(DSPUtils::CACHE_LINE_SIZE) Job
+    {
+        std::atomic<int> state { idle };
+        int channels = 0;
+        int samples = 0;
+    };
+
+    template <typename SampleType>
+    struct SlotBuffers
+    {
+        std::array<juce::AudioBuffer<SampleType>, NUM_SLOTS> buffers;
+
+        void setSize(int channels, int samples)
+        {
+            for (auto& buffer : buffers)
+                buffer.setSize(channels, samples);
+        }
+    };
+
+    class Worker : public juce::Thread
+    {
+    public:
+        explicit Worker(ComparisonChains& o) : juce::Thread("Comparison chain"), owner(o) {}
+
+        void run() override
+        {
+            while (!threadShouldExit())
+            {
+                wakeUp.wait();
+
+                if (!threadShouldExit())
+                    owner.runJobs();
+            }
+        }
+
+        juce::WaitableEvent wakeUp;
+
+    private:
+        ComparisonChains& owner;
+    };
+
+    static bool isValidSlot(int slot) { return slot >= 0 && slot < NUM_SLOTS; }
+
+    template <typename SampleType>
+    void processBlock(juce::AudioBuffer<SampleType>& buffer)
+    {
+        const int numSamples = buffer.getNumSamples();
+        const int channels = std::min(buffer.getNumChannels(), numChannels);
+
+        updateRunningSlots();
+        updateAudibleSlot();
+
+        // Copy the input for every running shadow slot before the audible
+        // chain processes the buffer in place
+        auto& inputs = slotBuffers.get<SampleType>();
+        const int shadowSlots = runningSlots & ~stalledSlots & ~(1 << audibleSlot);
+        int jobCount = 0;
+
+        for (int slot = 0; slot < NUM_SLOTS; ++slot)
+        {
+            if ((shadowSlots & (1 << slot)) == 0)
+                continue;
+
+            for (int ch = 0; ch < channels; ++ch)
+                juce::FloatVectorOperations::copy(inputs.buffers[static_cast<size_t>(slot)].getWritePointer(ch),
+                                                  buffer.getReadPointer(ch), numSamples);
+
+            auto& job = jobs[static_cast<size_t>(slot)];
+            job.channels = channels;
+            job.samples = numSamples;
+            job.state.store(queued, std::memory_order_release);
+            ++jobCount;
+        }
+
+        for (int w = 0; w < std::min(jobCount, static_cast<int>(workers.size())); ++w)
+            workers[static_cast<size_t>(w)]->wakeUp.signal();
+
+        chains[static_cast<size_t>(audibleSlot)].process(buffer);
+
+        if (jobCount > 0)
+        {
+            runJobs();
+            waitForShadows(shadowSlots);
+        }
+
+        for (int slot = 0; slot < NUM_SLOTS; ++slot)
+            if (((runningSlots & ~stalledSlots) & (1 << slot)) != 0)
+                warmSamples[static_cast<size_t>(slot)] = std::min(warmupLength, warmSamples[static_cast<size_t>(slot)] + numSamples);
+
+        if (fadeFromSlot >= 0)
+            applyCrossfade(buffer, inputs.buffers[static_cast<size_t>(fadeFromSlot)], channels, numSamples);
+    }
+
+    // Claims and renders every queued shadow slot
+    void runJobs()
+    {
+        juce::ScopedNoDenormals noDenormals;
+
+        for (int slot = 0; slot < NUM_SLOTS; ++slot)
+        {
+            auto& job = jobs[static_cast<size_t>(slot)];
+
+            int expected = queued;
+            if (!job.state.compare_exchange_strong(expected, rendering, std::memory_order_acquire))
+                continue;
+
+            if (jobIsDouble)
+                renderSlot<double>(slot, job);
+            else
+                renderSlot<float>(slot, job);
+
+            job.state.store(idle, std::memory_order_release);
+        }
+    }
+
+    template <typename SampleType>
+    void renderSlot(int slot, const Job& job)
+    {
+        auto& input = slotBuffers.get<SampleType>().buffers[static_cast<size_t>(slot)];
+        juce::AudioBuffer<SampleType> block(input.getArrayOfWritePointers(), job.channels, job.samples);
+        chains[static_cast<size_t>(slot)].process(block);
+    }
+
+    // Waits up to maxWaitMs for the workers still rendering these slots.
+    // Any still busy then skip this block: no crossfade from them, and they
+    // restart cold once their worker is done.
+    void waitForShadows(int slots)
+    {
+        const double deadline = juce::Time::getMillisecondCounterHiRes() + maxWaitMs;
+
+        for (;;)
+        {
+            int busy = 0;
+            for (int slot = 0; slot < NUM_SLOTS; ++slot)
+                if ((slots & (1 << slot)) != 0 && jobs[static_cast<size_t>(slot)].state.load(std::memory_order_acquire) != idle)
+                    busy |= 1 << slot;
+
+            if (busy == 0)
+                return;
+
+            if (juce::Time::getMillisecondCounterHiRes() >= deadline)
+            {
+                stalledSlots |= busy;
+
+                if (fadeFromSlot >= 0 && (busy & (1 << fadeFromSlot)) != 0)
+                    fadeFromSlot = -1;
+
+                return;
+            }
+
+            std::this_thread::yield();
+        }
+    }
+
+    // Message thread, before touching the chains outside process()
+    void waitForWorkers() const
+    {
+        for (const auto& job : jobs)
+            while (job.state.load(std::memory_order_acquire) != idle)
+                std::this_thread::yield();
+    }
+
+    // One worker per shadow slot, as far as there are cores for them;
+    // none while released or with only the selected slot stored
+    void updateWorkers()
+    {
+        const int live = liveSlots.load();
+        const int numShadows = workersEnabled ? juce::countNumberOfBits(static_cast<juce::uint32>(live)) - 1 : 0;
+
+        for (int w = 0; w < static_cast<int>(workers.size()); ++w)
+        {
+            auto& worker = *workers[static_cast<size_t>(w)];
+
+            if (w < numShadows)
+            {
+                if (!worker.isThreadRunning())
+                    worker.startThread(juce::Thread::Priority::highest);
+            }
+            else if (worker.isThreadRunning())
+            {
+                worker.signalThreadShouldExit();
+                worker.wakeUp.signal();
+                worker.stopThread(1000);
+            }
+        }
+    }
+
+    // A slot that has just been stored, or whose worker has caught up after
+    // missing a block, starts from clean state and warms up
+    void updateRunningSlots()
+    {
+        const int live = liveSlots.load(std::memory_order_acquire);
+
+        for (int slot = 0; slot < NUM_SLOTS; ++slot)
+        {
+            if ((stalledSlots & (1 << slot)) != 0
+                && jobs[static_cast<size_t>(slot)].state.load(std::memory_order_acquire) == idle)
+            {
+                stalledSlots &= ~(1 << slot);
+                runningSlots &= ~(1 << slot);
+            }
+        }
+
+        const int started = live & ~runningSlots & ~stalledSlots;
+
+        for (int slot = 0; slot < NUM_SLOTS; ++slot)
+        {
+            if ((started & (1 << slot)) != 0)
+            {
+                chains[static_cast<size_t>(slot)].reset();
+                warmSamples[static_cast<size_t>(slot)] = 0;
+            }
+        }
+
+        runningSlots = live;
+
+        if (fadeFromSlot >= 0 && (runningSlots & (1 << fadeFromSlot)) == 0)
+            fadeFromSlot = -1;
+    }
+
+    // The switch waits for any running crossfade and for the new slot to warm up
+    void updateAudibleSlot()
+    {
+        const int target = selectedSlot.load(std::memory_order_acquire);
+
+        if (target == audibleSlot || fadeFromSlot >= 0 || (runningSlots & (1 << target)) == 0)
+            return;
+
+        if ((stalledSlots & (1 << target)) != 0 || warmSamples[static_cast<size_t>(target)] < warmupLength)
+            return;
+
+        fadeFromSlot = audibleSlot;
+        audibleSlot = target;
+        fadePosition = 0;
+    }
+
+    // Linear fade: both outputs come from the same input, so they're correlated
+    template <typename SampleType>
+    void applyCrossfade(juce::AudioBuffer<SampleType>& buffer, const juce::AudioBuffer<SampleType>& previous,
+                        int channels, int numSamples)
+    {
+        const int fadeSamples = std::min(numSamples, crossfadeLength - fadePosition);
+        const auto step = SampleType(1) / static_cast<SampleType>(crossfadeLength);
+
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            auto* out = buffer.getWritePointer(ch);
+            const auto* old = previous.getReadPointer(ch);
+
+            for (int i = 0; i < fadeSamples; ++i)
+            {
+                const auto t = static_cast<SampleType>(fadePosition + i) * step;
+                out[i] = old[i] + (out[i] - old[i]) * t;
+            }
+        }
+
+        fadePosition += fadeSamples;
+        if (fadePosition >= crossfadeLength)
+            fadeFromSlot = -1;
+    }
+
+    std::array<MasteringChain, NUM_SLOTS> chains;
+    DSPUtils::PerSampleType<SlotBuffers> slotBuffers;
+    std::vector<std::unique_ptr<Worker>> workers;  // Fixed at construction; threads start and stop with the shadow slots
+    bool workersEnabled = false;
+
+    int numChannels = 2;
+    int maxBlockSize = 512;
+    int crossfadeLength = 1;
+    int warmupLength = 0;
+    double maxWaitMs = 0.0;
+
+    // Shared with the message thread
+    std::atomic<int> liveSlots { 1 };
+    std::atomic<int> selectedSlot { 0 };
+    std::atomic<int> parameterSlot { 0 };
+    std::atomic<int> pendingParameterSlots { 0 };
+
+    // Audio thread only
+    int runningSlots = 1;
+    int stalledSlots = 0;  // Missed a block; their worker may still be rendering
+    int audibleSlot = 0;
+    int fadeFromSlot = -1;
+    int fadePosition = 0;
+    std::array<int, NUM_SLOTS> warmSamples {};
+
+    // Hand-off to the workers
+    std::array<Job, NUM_SLOTS> jobs;
+    bool jobIsDouble = false;
+
+    JUCE_DECLARE_NON_COPYABLE(ComparisonChains)
+};
@@ -0,0 +1,3 @@
+// ConstantQAnalyzer implementation
+// All functionality is in the header file
+#include "ConstantQAnalyzer.h"
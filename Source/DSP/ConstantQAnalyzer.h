@@ -0,0 +1,277 @@
+#pragma once
+
+#include "DSPUtils.h"
+#include "SpectralAnalyzer.h"
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+
+// 32-band energy profile from an octave-decimated filterbank.
+//
+// The mono mix runs through a cascade of 2x half-band decimators. Every
+// level has its own 256-point frame at its own rate, and each band is
+// measured at the most decimated level that still holds it below 0.4x that
+// level's rate. Bands therefore get tens of bins each whether they sit at
+// 25 Hz or 15 kHz, where the single 4096-point FFT gives the lowest bands
+// one or two. The cascade costs about two full-rate 256-point transforms
+// per hop plus the decimators, well under a larger FFT.
+//
+// Band values use the same dB scale as SpectralAnalyzer (per-bin energy
+// scaled to its 4096-point bin width), so either can feed the rules,
+// parameter generator and reference match.
+class ConstantQAnalyzer
+{
+public:
+    static constexpr int NUM_BANDS = SpectralAnalyzer::NUM_BANDS;
+    static constexpr int FRAME_ORDER = 8;
+    static constexpr int FRAME_SIZE = 1 << FRAME_ORDER;  // 256
+    static constexpr int NUM_BINS = FRAME_SIZE / 2;
+    static constexpr int HOP_SIZE = FRAME_SIZE / 2;
+    static constexpr int MAX_LEVELS = 12;                 // Reaches 20 Hz at 192 kHz
+    static constexpr float MAX_BAND_FRACTION = 0.4f;      // Highest band edge / level rate
+
+    ConstantQAnalyzer()
+        : fft(FRAME_ORDER)
+    {
+        prepare(44100.0);
+    }
+
+    void prepare(double sampleRate)
+    {
+        currentSampleRate = sampleRate;
+        numLevels = 1;
+        DSPUtils::getBlackmanHarrisWindow<FRAME_SIZE>();  // Built here rather than on the audio thread
+
+        for (int band = 0; band < NUM_BANDS; ++band)
+        {
+            const float lowFreq = DSPUtils::SpectralFeatureTables::getBandEdge(band);
+            const float highFreq = DSPUtils::SpectralFeatureTables::getBandEdge(band + 1);
+
+            // Most decimated level whose usable range still holds the band
+            int level = 0;
+            while (level + 1 < MAX_LEVELS
+                   && highFreq <= MAX_BAND_FRACTION * static_cast<float>(sampleRate / (1 << (level + 1))))
+                ++level;
+
+            const float binWidth = static_cast<float>(sampleRate / (1 << level)) / FRAME_SIZE;
+            int lowBin = static_cast<int>(lowFreq / binWidth);
+            int highBin = static_cast<int>(highFreq / binWidth);
+
+            lowBin = std::max(1, std::min(lowBin, NUM_BINS - 1));
+            highBin = std::max(lowBin + 1, std::min(highBin, NUM_BINS));
+
+            bands[static_cast<size_t>(band)] = { level, lowBin, highBin };
+            numLevels = std::max(numLevels, level + 1);
+        }
+
+        // Per-bin energy grows with bin width; match the 4096-point analyzer's
+        for (int level = 0; level < MAX_LEVELS; ++level)
+            levelEnergyScale[static_cast<size_t>(level)] =
+                static_cast<float>(FRAME_SIZE << level) / static_cast<float>(SpectralAnalyzer::FFT_SIZE);
+
+        reset();
+    }
+
+    void reset()
+    {
+        for (auto& level : levels)
+            level = Level {};
+
+        bandEnergies.fill(-100.0f);
+        publishedBandEnergies.publish(bandEnergies);
+        bandsChanged = false;
+    }
+
+    void pushStereoSamples(const float* left, const float* right, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            pushSample((left[i] + right[i]) * 0.5f);
+
+        publishIfChanged();
+    }
+
+    void pushSamples(const float* samples, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            pushSample(samples[i]);
+
+        publishIfChanged();
+    }
+
+    std::array<float, NUM_BANDS> getBandEnergies() const { return publishedBandEnergies.read(); }
+
+    // Decimation level a band is measured at (0 = full rate)
+    int getBandLevel(int band) const { return bands[static_cast<size_t>(band)].level; }
+
+    // Seconds of audio behind one frame of the given band
+    double getBandWindowSeconds(int band) const
+    {
+        return static_cast<double>(FRAME_SIZE << getBandLevel(band)) / currentSampleRate;
+    }
+
+private:
+    static constexpr int DECIMATOR_TAPS = 63;
+    static constexpr int DECIMATOR_CENTRE = DECIMATOR_TAPS / 2;
+    static constexpr int NUM_SIDE_TAPS = (DECIMATOR_CENTRE + 1) / 2;  // Odd offsets from the centre
+
+    struct Band
+    {
+        int level = 0;
+        int lowBin = 1;
+        int highBin = 2;
+    };
+
+    struct Level
+    {
+        std::array<float, FRAME_SIZE> ring {};
+        int ringIndex = 0;
+        int samplesCollected = 0;
+        int samplesSinceFrame = 0;
+
+        // Decimator history, stored twice so the taps always read contiguously
+        std::array<float, DECIMATOR_TAPS * 2> history {};
+        int historyIndex = 0;
+        bool oddSample = false;
+    };
+
+    // Blackman-windowed half-band lowpass: the centre tap plus the odd
+    // offsets (even offsets are zero). Passes 0.2x the input rate, stops
+    // by 0.3x, so everything a level measures is alias-free.
+    static const std::array<float, NUM_SIDE_TAPS>& getDecimatorTaps()
+    {
+        static const std::array<float, NUM_SIDE_TAPS> taps = []
+        {
+            std::array<float, NUM_SIDE_TAPS> result {};
+            const double pi = juce::MathConstants<double>::pi;
+            double sum = 0.0;
+
+            for (int m = 0; m < NUM_SIDE_TAPS; ++m)
+            {
+                const int offset = 2 * m + 1;
+                const double n = static_cast<double>(DECIMATOR_CENTRE + offset) / (DECIMATOR_TAPS - 1);
+                const double window = 0.42 - 0.5 * std::cos(2.0 * pi * n) + 0.08 * std::cos(4.0 * pi * n);
+                const double sinc = std::sin(pi * offset * 0.5) / (pi * offset);
+
+                result[static_cast<size_t>(m)] = static_cast<float>(sinc * window);
+                sum += 2.0 * sinc * window;
+            }
+
+            // Unity gain at DC with the 0.5 centre tap
+            for (auto& tap : result)
+                tap = static_cast<float>(tap * 0.5 / sum);
+
+            return result;
+        }();
+
+        return taps;
+    }
+
+    // Once per push, however many levels completed a frame
+    void publishIfChanged()
+    {
+        if (bandsChanged)
+        {
+            publishedBandEnergies.publish(bandEnergies);
+            bandsChanged = false;
+        }
+    }
+
+    void pushSample(float sample)
+    {
+        for (int index = 0; index < numLevels; ++index)
+        {
+            Level& level = levels[static_cast<size_t>(index)];
+
+            level.ring[static_cast<size_t>(level.ringIndex)] = sample;
+            level.ringIndex = (level.ringIndex + 1) & (FRAME_SIZE - 1);
+            level.samplesCollected = std::min(level.samplesCollected + 1, FRAME_SIZE);
+
+            if (++level.samplesSinceFrame >= HOP_SIZE)
+            {
+                level.samplesSinceFrame = 0;
+                if (level.samplesCollected == FRAME_SIZE)
+                    analyzeLevel(index);
+            }
+
+            if (index + 1 == numLevels)
+                break;
+
+            // Feed the decimator; every second sample produces one for the next level
+            level.history[static_cast<size_t>(level.historyIndex)] = sample;
+            level.history[static_cast<size_t>(level.historyIndex + DECIMATOR_TAPS)] = sample;
+            level.historyIndex = (level.historyIndex + 1) % DECIMATOR_TAPS;
+
+            level.oddSample = !level.oddSample;
+            if (level.oddSample)
+                break;
+
+            sample = decimate(level);
+        }
+    }
+
+    static float decimate(const Level& level)
+    {
+        const auto& taps = getDecimatorTaps();
+        const float* centre = level.history.data() + level.historyIndex + DECIMATOR_CENTRE;
+
+        float acc = 0.5f * centre[0];
+        for (int m = 0; m < NUM_SIDE_TAPS; ++m)
+            acc += taps[static_cast<size_t>(m)] * (centre[-(2 * m + 1)] + centre[2 * m + 1]);
+
+        return acc;
+    }
+
+    void analyzeLevel(int index)
+    {
+        const Level& level = levels[static_cast<size_t>(index)];
+        const auto& window = DSPUtils::getBlackmanHarrisWindow<FRAME_SIZE>();
+        const int firstPart = FRAME_SIZE - level.ringIndex;
+
+        // Windowed copy of the ring, oldest sample first
+        for (int i = 0; i < firstPart; ++i)
+            fftData[static_cast<size_t>(i)] = level.ring[static_cast<size_t>(level.ringIndex + i)] * window[static_cast<size_t>(i)];
+
+        for (int i = firstPart; i < FRAME_SIZE; ++i)
+            fftData[static_cast<size_t>(i)] = level.ring[static_cast<size_t>(i - firstPart)] * window[static_cast<size_t>(i)];
+
+        fft.performRealOnlyForwardTransform(fftData.data(), true);
+
+        // Same normalisation as SpectralAnalyzer: magnitude = |X| / N * 2
+        const float norm = 2.0f / FRAME_SIZE;
+        const float scale = levelEnergyScale[static_cast<size_t>(index)] * norm * norm;
+
+        for (int band = 0; band < NUM_BANDS; ++band)
+        {
+            const Band& b = bands[static_cast<size_t>(band)];
+            if (b.level != index)
+                continue;
+
+            float bandEnergy = 0.0f;
+            for (int bin = b.lowBin; bin < b.highBin; ++bin)
+            {
+                const float re = fftData[static_cast<size_t>(2 * bin)];
+                const float im = fftData[static_cast<size_t>(2 * bin + 1)];
+                bandEnergy += re * re + im * im;
+            }
+
+            bandEnergy *= scale;
+            bandEnergies[static_cast<size_t>(band)] = DSPUtils::linearToDecibels(std::sqrt(bandEnergy / (b.highBin - b.lowBin + 1)));
+        }
+
+        bandsChanged = true;
+    }
+
+    double currentSampleRate = 44100.0;
+    int numLevels = 1;
+
+    std::array<Band, NUM_BANDS> bands {};
+    std::array<float, MAX_LEVELS> levelEnergyScale {};
+    std::array<Level, MAX_LEVELS> levels {};
+
+    juce::dsp::FFT fft;
+    std::array<float, FRAME_SIZE * 2> fftData {};  // Transform works in place on 2x the size
+
+    // Working copy (audio thread) and the last complete set for other threads
+    std::array<float, NUM_BANDS> bandEnergies {};
+    bool bandsChanged = false;
+    DSPUtils::SeqLock<std::array<float, NUM_BANDS>> publishedBandEnergies;
+};
@@ -5,6 +5,13 @@
 #include <cmath>
 #include <array>
 #include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
 
 namespace DSPUtils
 {
@@ -24,6 +31,29 @@ namespace DSPUtils
         return dB > MINUS_INFINITY_DB ? std::pow(10.0f, dB / 20.0f) : 0.0f;
     }
 
+    // log2 for positive normal floats, within 2e-6 of std::log2: exponent from
+    // the bits, mantissa centred on 1, then 2/ln2 * atanh((m-1)/(m+1)) to the
+    // t^5 term. Branch-free, so loops over it vectorize.
+    inline float fastLog2(float x)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+
+        int exponent = static_cast<int>((bits >> 23) & 0xff) - 127;
+        bits = (bits & 0x007fffffu) | 0x3f800000u;
+
+        float m;
+        std::memcpy(&m, &bits, sizeof(m));
+
+        const bool high = m > 1.41421356f;
+        m = high ? m * 0.5f : m;
+        exponent += high ? 1 : 0;
+
+        const float t = (m - 1.0f) / (m + 1.0f);
+        const float t2 = t * t;
+        return static_cast<float>(exponent) + t * (2.88539008f + t2 * (0.961796693f + t2 * 0.577078016f));
+    }
+
     inline float frequencyToMel(float freq)
     {
         return 2595.0f * std::log10(1.0f + freq / 700.0f);
@@ -34,112 +64,164 @@ namespace DSPUtils
         return 700.0f * (std::pow(10.0f, mel / 2595.0f) - 1.0f);
     }
 
-    // Biquad filter coefficients
-    struct BiquadCoeffs
+    // Biquad filter coefficients. Designs are always computed in double
+    // precision and rounded to SampleType on assignment, so low-frequency
+    // shelves and high-order HPFs keep their pole positions at 96/192 kHz.
+    template <typename SampleType>
+    struct BiquadCoefficients
     {
-        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f;
-        float a1 = 0.0f, a2 = 0.0f;
+        SampleType b0 = 1, b1 = 0, b2 = 0;
+        SampleType a1 = 0, a2 = 0;
 
         void makeBypass()
         {
-            b0 = 1.0f; b1 = 0.0f; b2 = 0.0f;
-            a1 = 0.0f; a2 = 0.0f;
+            set(1.0, 0.0, 0.0, 0.0, 0.0);
         }
 
-        void makeLowPass(double sampleRate, float frequency, float Q)
+        void makeLowPass(double sampleRate, double frequency, double Q)
         {
-            float w0 = TWO_PI * frequency / static_cast<float>(sampleRate);
-            float cosw0 = std::cos(w0);
-            float sinw0 = std::sin(w0);
-            float alpha = sinw0 / (2.0f * Q);
-
-            float a0 = 1.0f + alpha;
-            b0 = ((1.0f - cosw0) / 2.0f) / a0;
-            b1 = (1.0f - cosw0) / a0;
-            b2 = ((1.0f - cosw0) / 2.0f) / a0;
-            a1 = (-2.0f * cosw0) / a0;
-            a2 = (1.0f - alpha) / a0;
+            double w0 = 2.0 * juce::MathConstants<double>::pi * frequency / sampleRate;
+            double cosw0 = std::cos(w0);
+            double sinw0 = std::sin(w0);
+            double alpha = sinw0 / (2.0 * Q);
+
+            double a0 = 1.0 + alpha;
+            set(((1.0 - cosw0) / 2.0) / a0,
+                (1.0 - cosw0) / a0,
+                ((1.0 - cosw0) / 2.0) / a0,
+                (-2.0 * cosw0) / a0,
+                (1.0 - alpha) / a0);
         }
 
-        void makeHighPass(double sampleRate, float frequency, float Q)
+        void makeHighPass(double sampleRate, double frequency, double Q)
         {
-            float w0 = TWO_PI * frequency / static_cast<float>(sampleRate);
-            float cosw0 = std::cos(w0);
-            float sinw0 = std::sin(w0);
-            float alpha = sinw0 / (2.0f * Q);
-
-            float a0 = 1.0f + alpha;
-            b0 = ((1.0f + cosw0) / 2.0f) / a0;
-            b1 = (-(1.0f + cosw0)) / a0;
-            b2 = ((1.0f + cosw0) / 2.0f) / a0;
-            a1 = (-2.0f * cosw0) / a0;
-            a2 = (1.0f - alpha) / a0;
+            double w0 = 2.0 * juce::MathConstants<double>::pi * frequency / sampleRate;
+            double cosw0 = std::cos(w0);
+            double sinw0 = std::sin(w0);
+            double alpha = sinw0 / (2.0 * Q);
+
+            double a0 = 1.0 + alpha;
+            set(((1.0 + cosw0) / 2.0) / a0,
+                (-(1.0 + cosw0)) / a0,
+                ((1.0 + cosw0) / 2.0) / a0,
+                (-2.0 * cosw0) / a0,
+                (1.0 - alpha) / a0);
         }
 
-        void makePeaking(double sampleRate, float frequency, float gainDB, float Q)
+        void makePeaking(double sampleRate, double frequency, double gainDB, double Q)
         {
-            float A = std::pow(10.0f, gainDB / 40.0f);
-            float w0 = TWO_PI * frequency / static_cast<float>(sampleRate);
-            float cosw0 = std::cos(w0);
-            float sinw0 = std::sin(w0);
-            float alpha = sinw0 / (2.0f * Q);
-
-            float a0 = 1.0f + alpha / A;
-            b0 = (1.0f + alpha * A) / a0;
-            b1 = (-2.0f * cosw0) / a0;
-            b2 = (1.0f - alpha * A) / a0;
-            a1 = (-2.0f * cosw0) / a0;
-            a2 = (1.0f - alpha / A) / a0;
+            double A = std::pow(10.0, gainDB / 40.0);
+            double w0 = 2.0 * juce::MathConstants<double>::pi * frequency / sampleRate;
+            double cosw0 = std::cos(w0);
+            double sinw0 = std::sin(w0);
+            double alpha = sinw0 / (2.0 * Q);
+
+            double a0 = 1.0 + alpha / A;
+            set((1.0 + alpha * A) / a0,
+                (-2.0 * cosw0) / a0,
+                (1.0 - alpha * A) / a0,
+                (-2.0 * cosw0) / a0,
+                (1.0 - alpha / A) / a0);
         }
 
-        void makeLowShelf(double sampleRate, float frequency, float gainDB, float Q)
+        void makeLowShelf(double sampleRate, double frequency, double gainDB, double Q)
         {
-            float A = std::pow(10.0f, gainDB / 40.0f);
-            float w0 = TWO_PI * frequency / static_cast<float>(sampleRate);
-            float cosw0 = std::cos(w0);
-            float sinw0 = std::sin(w0);
-            float alpha = sinw0 / (2.0f * Q);
-            float sqrtA = std::sqrt(A);
+            double A = std::pow(10.0, gainDB / 40.0);
+            double w0 = 2.0 * juce::MathConstants<double>::pi * frequency / sampleRate;
+            double cosw0 = std::cos(w0);
+            double sinw0 = std::sin(w0);
+            double alpha = sinw0 / (2.0 * Q);
+            double sqrtA = std::sqrt(A);
+
+            double a0 = (A + 1.0) + (A - 1.0) * cosw0 + 2.0 * sqrtA * alpha;
+            set(A * ((A + 1.0) - (A - 1.0) * cosw0 + 2.0 * sqrtA * alpha) / a0,
+                2.0 * A * ((A - 1.0) - (A + 1.0) * cosw0) / a0,
+                A * ((A + 1.0) - (A - 1.0) * cosw0 - 2.0 * sqrtA * alpha) / a0,
+                -2.0 * ((A - 1.0) + (A + 1.0) * cosw0) / a0,
+                ((A + 1.0) + (A - 1.0) * cosw0 - 2.0 * sqrtA * alpha) / a0);
+        }
 
-            float a0 = (A + 1.0f) + (A - 1.0f) * cosw0 + 2.0f * sqrtA * alpha;
-            b0 = A * ((A + 1.0f) - (A - 1.0f) * cosw0 + 2.0f * sqrtA * alpha) / a0;
-            b1 = 2.0f * A * ((A - 1.0f) - (A + 1.0f) * cosw0) / a0;
-            b2 = A * ((A + 1.0f) - (A - 1.0f) * cosw0 - 2.0f * sqrtA * alpha) / a0;
-            a1 = -2.0f * ((A - 1.0f) + (A + 1.0f) * cosw0) / a0;
-            a2 = ((A + 1.0f) + (A - 1.0f) * cosw0 - 2.0f * sqrtA * alpha) / a0;
+        void makeHighShelf(double sampleRate, double frequency, double gainDB, double Q)
+        {
+            double A = std::pow(10.0, gainDB / 40.0);
+            double w0 = 2.0 * juce::MathConstants<double>::pi * frequency / sampleRate;
+            double cosw0 = std::cos(w0);
+            double sinw0 = std::sin(w0);
+            double alpha = sinw0 / (2.0 * Q);
+            double sqrtA = std::sqrt(A);
+
+            double a0 = (A + 1.0) - (A - 1.0) * cosw0 + 2.0 * sqrtA * alpha;
+            set(A * ((A + 1.0) + (A - 1.0) * cosw0 + 2.0 * sqrtA * alpha) / a0,
+                -2.0 * A * ((A - 1.0) + (A + 1.0) * cosw0) / a0,
+                A * ((A + 1.0) + (A - 1.0) * cosw0 - 2.0 * sqrtA * alpha) / a0,
+                2.0 * ((A - 1.0) - (A + 1.0) * cosw0) / a0,
+                ((A + 1.0) - (A - 1.0) * cosw0 - 2.0 * sqrtA * alpha) / a0);
         }
 
-        void makeHighShelf(double sampleRate, float frequency, float gainDB, float Q)
+        void makeAllPass(double sampleRate, double frequency, double Q)
         {
-            float A = std::pow(10.0f, gainDB / 40.0f);
-            float w0 = TWO_PI * frequency / static_cast<float>(sampleRate);
-            float cosw0 = std::cos(w0);
-            float sinw0 = std::sin(w0);
-            float alpha = sinw0 / (2.0f * Q);
-            float sqrtA = std::sqrt(A);
+            double w0 = 2.0 * juce::MathConstants<double>::pi * frequency / sampleRate;
+            double cosw0 = std::cos(w0);
+            double sinw0 = std::sin(w0);
+            double alpha = sinw0 / (2.0 * Q);
+
+            double a0 = 1.0 + alpha;
+            set((1.0 - alpha) / a0,
+                (-2.0 * cosw0) / a0,
+                (1.0 + alpha) / a0,
+                (-2.0 * cosw0) / a0,
+                (1.0 - alpha) / a0);
+        }
 
-            float a0 = (A + 1.0f) - (A - 1.0f) * cosw0 + 2.0f * sqrtA * alpha;
-            b0 = A * ((A + 1.0f) + (A - 1.0f) * cosw0 + 2.0f * sqrtA * alpha) / a0;
-            b1 = -2.0f * A * ((A - 1.0f) + (A + 1.0f) * cosw0) / a0;
-            b2 = A * ((A + 1.0f) + (A - 1.0f) * cosw0 - 2.0f * sqrtA * alpha) / a0;
-            a1 = 2.0f * ((A - 1.0f) - (A + 1.0f) * cosw0) / a0;
-            a2 = ((A + 1.0f) - (A - 1.0f) * cosw0 - 2.0f * sqrtA * alpha) / a0;
+        template <typename OtherType>
+        BiquadCoefficients<OtherType> cast() const
+        {
+            BiquadCoefficients<OtherType> result;
+            result.b0 = static_cast<OtherType>(b0);
+            result.b1 = static_cast<OtherType>(b1);
+            result.b2 = static_cast<OtherType>(b2);
+            result.a1 = static_cast<OtherType>(a1);
+            result.a2 = static_cast<OtherType>(a2);
+            return result;
         }
 
-        void makeAllPass(double sampleRate, float frequency, float Q)
+    private:
+        void set(double nb0, double nb1, double nb2, double na1, double na2)
         {
-            float w0 = TWO_PI * frequency / static_cast<float>(sampleRate);
-            float cosw0 = std::cos(w0);
-            float sinw0 = std::sin(w0);
-            float alpha = sinw0 / (2.0f * Q);
+            b0 = static_cast<SampleType>(nb0);
+            b1 = static_cast<SampleType>(nb1);
+            b2 = static_cast<SampleType>(nb2);
+            a1 = static_cast<SampleType>(na1);
+            a2 = static_cast<SampleType>(na2);
+        }
+    };
+
+    using BiquadCoeffs = BiquadCoefficients<float>;
+
+    // A filter design kept at double precision together with a float copy,
+    // so float and double processing paths can share one set of parameters
+    struct BiquadDesign
+    {
+        BiquadCoefficients<double> coeffs;
+        BiquadCoefficients<float> floatCoeffs;
 
-            float a0 = 1.0f + alpha;
-            b0 = (1.0f - alpha) / a0;
-            b1 = (-2.0f * cosw0) / a0;
-            b2 = (1.0f + alpha) / a0;
-            a1 = (-2.0f * cosw0) / a0;
-            a2 = (1.0f - alpha) / a0;
+        void makeLowPass(double sampleRate, double frequency, double Q)                     { coeffs.makeLowPass(sampleRate, frequency, Q); update(); }
+        void makeHighPass(double sampleRate, double frequency, double Q)                    { coeffs.makeHighPass(sampleRate, frequency, Q); update(); }
+        void makePeaking(double sampleRate, double frequency, double gainDB, double Q)      { coeffs.makePeaking(sampleRate, frequency, gainDB, Q); update(); }
+        void makeLowShelf(double sampleRate, double frequency, double gainDB, double Q)     { coeffs.makeLowShelf(sampleRate, frequency, gainDB, Q); update(); }
+        void makeHighShelf(double sampleRate, double frequency, double gainDB, double Q)    { coeffs.makeHighShelf(sampleRate, frequency, gainDB, Q); update(); }
+
+        template <typename SampleType>
+        const BiquadCoefficients<SampleType>& get() const
+        {
+            if constexpr (std::is_same_v<SampleType, float>)
+                return floatCoeffs;
+            else
+                return coeffs;
         }
+
+    private:
+        void update() { floatCoeffs = coeffs.cast<float>(); }
     };
 
     // Biquad filter state
@@ -165,6 +247,281 @@ namespace DSPUtils
         }
     };
 
+    // =========================================================================
+    // MULTICHANNEL (channel-parallel) PROCESSING
+    // A frame holds one sample for every channel. Filters run across the frame
+    // with one channel per SIMD lane, so a 7.1.4 bus costs three vector ops per
+    // biquad on SSE/NEON instead of twelve scalar ones (six for double).
+    // =========================================================================
+
+    constexpr int MAX_CHANNELS = 16;
+
+    // Four floats or two doubles per register on SSE/NEON
+    template <typename SampleType>
+    using SIMDVector = juce::dsp::SIMDRegister<SampleType>;
+
+    template <typename SampleType>
+    constexpr int SIMD_WIDTH = static_cast<int>(SIMDVector<SampleType>::SIMDNumElements);
+
+    static_assert(MAX_CHANNELS % SIMD_WIDTH<float> == 0, "MAX_CHANNELS must be a multiple of the SIMD width");
+    static_assert(MAX_CHANNELS % SIMD_WIDTH<double> == 0, "MAX_CHANNELS must be a multiple of the SIMD width");
+
+    // One sample per channel, aligned for SIMD loads/stores
+    template <typename SampleType>
+    struct alignas(sizeof(SIMDVector<SampleType>)) ChannelFrame
+    {
+        std::array<SampleType, MAX_CHANNELS> lanes = {};
+
+        SampleType& operator[](int ch) { return lanes[static_cast<size_t>(ch)]; }
+        SampleType operator[](int ch) const { return lanes[static_cast<size_t>(ch)]; }
+        SampleType* data() { return lanes.data(); }
+        const SampleType* data() const { return lanes.data(); }
+
+        void clear() { lanes.fill(SampleType(0)); }
+
+        void multiply(SampleType gain, int numChannels)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                lanes[static_cast<size_t>(ch)] *= gain;
+        }
+
+        SampleType getMaxAbs(int numChannels) const
+        {
+            SampleType maxVal = 0;
+            for (int ch = 0; ch < numChannels; ++ch)
+                maxVal = std::max(maxVal, std::abs(lanes[static_cast<size_t>(ch)]));
+            return maxVal;
+        }
+    };
+
+    template <typename SampleType, typename FrameType>
+    inline void readFrame(const SampleType* const* channels, int numChannels, int sample, ChannelFrame<FrameType>& frame)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            frame[ch] = static_cast<FrameType>(channels[ch][sample]);
+    }
+
+    template <typename SampleType>
+    inline void writeFrame(SampleType* const* channels, int numChannels, int sample, const ChannelFrame<SampleType>& frame)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            channels[ch][sample] = frame[ch];
+    }
+
+    // Biquad state for a whole frame; all channels share one set of coefficients
+    template <typename SampleType>
+    struct MultiChannelBiquadState
+    {
+        using Vector = SIMDVector<SampleType>;
+        static constexpr int width = SIMD_WIDTH<SampleType>;
+
+        ChannelFrame<SampleType> x1, x2, y1, y2;
+
+        void reset()
+        {
+            x1.clear();
+            x2.clear();
+            y1.clear();
+            y2.clear();
+        }
+
+        // Filters the frame in place. Lanes past numChannels (up to the next
+        // SIMD boundary) are processed too but never read back.
+        void process(ChannelFrame<SampleType>& frame, int numChannels, const BiquadCoefficients<SampleType>& coeffs)
+        {
+            const auto b0 = Vector::expand(coeffs.b0);
+            const auto b1 = Vector::expand(coeffs.b1);
+            const auto b2 = Vector::expand(coeffs.b2);
+            const auto a1 = Vector::expand(coeffs.a1);
+            const auto a2 = Vector::expand(coeffs.a2);
+
+            for (int i = 0; i < numChannels; i += width)
+            {
+                const auto input = Vector::fromRawArray(frame.data() + i);
+                const auto xm1 = Vector::fromRawArray(x1.data() + i);
+                const auto xm2 = Vector::fromRawArray(x2.data() + i);
+                const auto ym1 = Vector::fromRawArray(y1.data() + i);
+                const auto ym2 = Vector::fromRawArray(y2.data() + i);
+
+                const auto output = b0 * input + b1 * xm1 + b2 * xm2 - a1 * ym1 - a2 * ym2;
+
+                xm1.copyToRawArray(x2.data() + i);
+                input.copyToRawArray(x1.data() + i);
+                ym1.copyToRawArray(y2.data() + i);
+                output.copyToRawArray(y1.data() + i);
+                output.copyToRawArray(frame.data() + i);
+            }
+        }
+    };
+
+    // Holds one Holder<float> and one Holder<double> so a processor can keep
+    // separate state per precision and pick the right one at compile time
+    template <template <typename> class Holder>
+    struct PerSampleType
+    {
+        Holder<float> floatVersion;
+        Holder<double> doubleVersion;
+
+        template <typename SampleType>
+        Holder<SampleType>& get()
+        {
+            if constexpr (std::is_same_v<SampleType, float>)
+                return floatVersion;
+            else
+                return doubleVersion;
+        }
+
+        template <typename Function>
+        void forEach(Function&& function)
+        {
+            function(floatVersion);
+            function(doubleVersion);
+        }
+    };
+
+    // =========================================================================
+    // STATE ARENA
+    // Per-instance processing buffers are carved out of one cache-line-aligned
+    // block sized in prepare(), instead of one heap allocation per buffer.
+    // Layout runs the same code twice: a sizing pass that only measures, then
+    // a pass that hands out pointers into the freshly allocated block.
+    // =========================================================================
+
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+    // Fixed-size view onto arena memory
+    template <typename T>
+    struct StateArray
+    {
+        T* data = nullptr;
+        int size = 0;
+
+        T& operator[](int index) { return data[index]; }
+        const T& operator[](int index) const { return data[index]; }
+
+        T* begin() { return data; }
+        T* end() { return data + size; }
+        const T* begin() const { return data; }
+        const T* end() const { return data + size; }
+
+        bool isEmpty() const { return size == 0; }
+    };
+
+    class StateArena
+    {
+    public:
+        // Calls layout(arena) to measure, allocates, then calls it again to
+        // assign. Arrays from the previous build are invalid afterwards.
+        template <typename LayoutFunction>
+        void build(LayoutFunction&& layout)
+        {
+            storage.free();
+            base = nullptr;
+            offset = 0;
+            layout(*this);
+
+            const size_t bytesNeeded = offset;
+            storage.allocate(bytesNeeded + CACHE_LINE_SIZE, true);
+            base = juce::snapPointerToAlignment(storage.get(), CACHE_LINE_SIZE);
+            offset = 0;
+            layout(*this);
+
+            jassert(offset == bytesNeeded);
+        }
+
+        // Every array starts on its own cache line. Returns an empty array
+        // during the sizing pass.
+        template <typename T>
+        StateArray<T> allocate(int count)
+        {
+            static_assert(std::is_trivially_destructible_v<T>, "Arena memory is released without running destructors");
+            static_assert(alignof(T) <= CACHE_LINE_SIZE, "Arena alignment is one cache line");
+
+            offset = (offset + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
+
+            StateArray<T> array;
+            if (base != nullptr)
+            {
+                array.data = reinterpret_cast<T*>(base + offset);
+                array.size = count;
+                std::uninitialized_value_construct_n(array.data, static_cast<size_t>(count));
+            }
+
+            offset += sizeof(T) * static_cast<size_t>(count);
+            return array;
+        }
+
+        size_t getSizeInBytes() const { return offset; }
+
+    private:
+        juce::HeapBlock<char> storage;
+        char* base = nullptr;
+        size_t offset = 0;
+    };
+
+    // =========================================================================
+    // SNAPSHOT PUBLICATION
+    // Analysis results go from the audio thread to readers through a seqlock:
+    // the writer bumps a sequence number to odd, copies, then bumps it to
+    // even. It never waits. A reader copies between two reads of the
+    // sequence and retries if they differ or were odd, so it always gets one
+    // whole publish, never a mix of two.
+    // =========================================================================
+
+    template <typename T>
+    class SeqLock
+    {
+    public:
+        static_assert(std::is_trivially_copyable_v<T>, "Snapshots are copied as raw memory");
+
+        SeqLock() = default;
+        explicit SeqLock(const T& initial) : value(initial) {}
+
+        // Single writer only
+        void publish(const T& newValue)
+        {
+            const uint32_t start = sequence.load(std::memory_order_relaxed);
+            sequence.store(start + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            std::memcpy(&value, &newValue, sizeof(T));
+
+            sequence.store(start + 2, std::memory_order_release);
+        }
+
+        T read() const
+        {
+            T result;
+            read(result);
+            return result;
+        }
+
+        // Any number of readers; returns the version read
+        uint32_t read(T& result) const
+        {
+            for (;;)
+            {
+                const uint32_t before = sequence.load(std::memory_order_acquire);
+
+                if ((before & 1) == 0)
+                {
+                    std::memcpy(&result, &value, sizeof(T));
+                    std::atomic_thread_fence(std::memory_order_acquire);
+
+                    if (sequence.load(std::memory_order_relaxed) == before)
+                        return before / 2;
+                }
+            }
+        }
+
+        // Number of publishes so far; unchanged means nothing new to read
+        uint32_t getVersion() const { return sequence.load(std::memory_order_acquire) / 2; }
+
+    private:
+        alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> sequence { 0 };
+        T value {};
+    };
+
     // Smoothed value for parameter ramping
     class SmoothedValue
     {
@@ -307,6 +664,17 @@ namespace DSPUtils
             highOut = hpState2.process(hpTemp, hpCoeffs);
         }
 
+        // One side on its own, for analyzers that run the two sides at different rates
+        float processLow(float input)
+        {
+            return lpState2.process(lpState1.process(input, lpCoeffs), lpCoeffs);
+        }
+
+        float processHigh(float input)
+        {
+            return hpState2.process(hpState1.process(input, hpCoeffs), hpCoeffs);
+        }
+
     private:
         void updateCoefficients()
         {
@@ -323,6 +691,131 @@ namespace DSPUtils
         BiquadState hpState1, hpState2;
     };
 
+    // Power-of-two decimator for analysis signals that only need their lowest
+    // octaves. Each 2x stage is the 7-tap maximally flat half-band
+    // (-1, 0, 9, 16, 9, 0, -1) / 32: three multiplies per output, within
+    // 0.25 dB up to a tenth of the output rate. Anything that would alias
+    // into that range lies above 0.45 of the input rate, where the kernel is
+    // at least 55 dB down; it's only about 32 dB down at 0.4, so aliases
+    // land higher in the output band. Not a general resampler: keep the band
+    // of interest below about a tenth of the final rate.
+    class DecimationCascade
+    {
+    public:
+        static constexpr int MAX_STAGES = 8;
+
+        // Number of halvings that keeps the output rate at or above minRate
+        static int getNumStagesFor(double sampleRate, double minRate)
+        {
+            int numStagesForRate = 0;
+            while (numStagesForRate < MAX_STAGES && sampleRate / (2 << numStagesForRate) >= minRate)
+                ++numStagesForRate;
+            return numStagesForRate;
+        }
+
+        void setNumStages(int stagesToUse)
+        {
+            numStages = std::max(0, std::min(stagesToUse, MAX_STAGES));
+            reset();
+        }
+
+        int getFactor() const { return 1 << numStages; }
+
+        void reset()
+        {
+            stages = {};
+        }
+
+        // Returns true, with the decimated sample in output, once every getFactor() inputs
+        bool process(float input, float& output)
+        {
+            for (int s = 0; s < numStages; ++s)
+            {
+                Stage& stage = stages[static_cast<size_t>(s)];
+                const int newest = stage.index;
+
+                stage.history[static_cast<size_t>(newest)] = input;
+                stage.index = (newest + 1) & (Stage::LENGTH - 1);
+                stage.odd = !stage.odd;
+
+                if (stage.odd)
+                    return false;
+
+                auto delayed = [&] (int delay) { return stage.history[static_cast<size_t>((newest - delay) & (Stage::LENGTH - 1))]; };
+                input = 0.5f * delayed(3) + 0.28125f * (delayed(2) + delayed(4)) - 0.03125f * (delayed(0) + delayed(6));
+            }
+
+            output = input;
+            return true;
+        }
+
+    private:
+        struct Stage
+        {
+            static constexpr int LENGTH = 8;  // 7 taps, rounded up for masking
+
+            std::array<float, LENGTH> history {};
+            int index = 0;
+            bool odd = false;
+        };
+
+        std::array<Stage, MAX_STAGES> stages {};
+        int numStages = 0;
+    };
+
+    // Linkwitz-Riley crossover across a whole channel frame
+    template <typename SampleType>
+    class MultiChannelCrossover
+    {
+    public:
+        using Frame = ChannelFrame<SampleType>;
+
+        void prepare(double sampleRate)
+        {
+            this->sampleRate = sampleRate;
+            updateCoefficients();
+        }
+
+        void setCrossoverFrequency(float frequency)
+        {
+            crossoverFreq = frequency;
+            updateCoefficients();
+        }
+
+        void reset()
+        {
+            lpState1.reset();
+            lpState2.reset();
+            hpState1.reset();
+            hpState2.reset();
+        }
+
+        void process(const Frame& input, Frame& lowOut, Frame& highOut, int numChannels)
+        {
+            lowOut = input;
+            lpState1.process(lowOut, numChannels, lpCoeffs);
+            lpState2.process(lowOut, numChannels, lpCoeffs);
+
+            highOut = input;
+            hpState1.process(highOut, numChannels, hpCoeffs);
+            hpState2.process(highOut, numChannels, hpCoeffs);
+        }
+
+    private:
+        void updateCoefficients()
+        {
+            lpCoeffs.makeLowPass(sampleRate, crossoverFreq, 0.707);
+            hpCoeffs.makeHighPass(sampleRate, crossoverFreq, 0.707);
+        }
+
+        double sampleRate = 44100.0;
+        float crossoverFreq = 1000.0f;
+
+        BiquadCoefficients<SampleType> lpCoeffs, hpCoeffs;
+        MultiChannelBiquadState<SampleType> lpState1, lpState2;
+        MultiChannelBiquadState<SampleType> hpState1, hpState2;
+    };
+
     // Window functions for FFT analysis
     inline void applyHannWindow(float* data, int size)
     {
@@ -348,6 +841,30 @@ namespace DSPUtils
         }
     }
 
+    // Blackman-Harris table for a fixed FFT size, computed once per process
+    // and shared by every analyzer instance. The first call allocates nothing
+    // but does the trig, so analyzers make it from prepare().
+    template <int Size>
+    inline const std::array<float, Size>& getBlackmanHarrisWindow()
+    {
+        static const std::array<float, Size> table = []
+        {
+            std::array<float, Size> window {};
+
+            for (int i = 0; i < Size; ++i)
+            {
+                const double angle = juce::MathConstants<double>::twoPi * i / (Size - 1);
+                window[static_cast<size_t>(i)] = static_cast<float>(0.35875 - 0.48829 * std::cos(angle)
+                                                                   + 0.14128 * std::cos(2.0 * angle)
+                                                                   - 0.01168 * std::cos(3.0 * angle));
+            }
+
+            return window;
+        }();
+
+        return table;
+    }
+
     // Spectral features
     struct SpectralFeatures
     {
@@ -359,129 +876,216 @@ namespace DSPUtils
         std::array<float, 32> bandEnergies = {};  // 32-band energy distribution
     };
 
-    // Calculate spectral features from FFT magnitude data
-    inline SpectralFeatures calculateSpectralFeatures(const float* magnitudes, int fftSize, double sampleRate)
+    // Everything calculateSpectralFeatures() needs that depends only on FFT
+    // size and sample rate: bin frequencies, the slope regressors and the
+    // bin range of each log band. Built once per (fftSize, sampleRate) and
+    // shared by every analyzer and reference load; look it up off the audio
+    // thread (get() takes a lock the first time a configuration is seen).
+    struct SpectralFeatureTables
     {
-        SpectralFeatures features;
-        int numBins = fftSize / 2;
-        float binWidth = static_cast<float>(sampleRate) / fftSize;
-
-        // Calculate total energy and weighted frequency sum for centroid
-        float totalEnergy = 0.0f;
-        float weightedFreqSum = 0.0f;
+        static constexpr int NUM_BANDS = 32;
 
-        for (int i = 1; i < numBins; ++i)
+        SpectralFeatureTables(int size, double rate)
+            : fftSize(size), sampleRate(rate), numBins(size / 2),
+              binWidth(static_cast<float>(rate) / size)
         {
-            float freq = i * binWidth;
-            float energy = magnitudes[i] * magnitudes[i];
-            totalEnergy += energy;
-            weightedFreqSum += freq * energy;
-        }
+            frequency.resize(static_cast<size_t>(numBins));
+            slopeWeight.resize(static_cast<size_t>(numBins));
+            slopeX.resize(static_cast<size_t>(numBins));
 
-        if (totalEnergy > 0.0f)
-        {
-            features.centroid = weightedFreqSum / totalEnergy;
+            for (int i = 0; i < numBins; ++i)
+            {
+                const float freq = i * binWidth;
+                const bool inRange = freq > 20.0f && freq < 20000.0f;
+
+                frequency[static_cast<size_t>(i)] = freq;
+                slopeWeight[static_cast<size_t>(i)] = inRange ? 1.0f : 0.0f;
+                slopeX[static_cast<size_t>(i)] = inRange ? std::log2(freq) : 0.0f;
+            }
 
-            // Spectral spread (standard deviation around centroid)
-            float spreadSum = 0.0f;
-            for (int i = 1; i < numBins; ++i)
+            for (int band = 0; band < NUM_BANDS; ++band)
             {
-                float freq = i * binWidth;
-                float energy = magnitudes[i] * magnitudes[i];
-                float diff = freq - features.centroid;
-                spreadSum += diff * diff * energy;
+                const float lowFreq = getBandEdge(band);
+                const float highFreq = getBandEdge(band + 1);
+                int lowBin = static_cast<int>(lowFreq / binWidth);
+                int highBin = static_cast<int>(highFreq / binWidth);
+
+                lowBin = std::max(1, std::min(lowBin, numBins - 1));
+                highBin = std::max(lowBin + 1, std::min(highBin, numBins));
+
+                bandLow[static_cast<size_t>(band)] = lowBin;
+                bandHigh[static_cast<size_t>(band)] = highBin;
             }
-            features.spread = std::sqrt(spreadSum / totalEnergy);
         }
 
-        // Spectral flatness (geometric mean / arithmetic mean)
-        float logSum = 0.0f;
-        float linSum = 0.0f;
-        int validBins = 0;
+        // Edge of the 32 log-spaced bands (20 Hz - 20 kHz); band b spans edges b and b + 1
+        static float getBandEdge(int edge)
+        {
+            const float logMin = std::log2(20.0f);
+            const float logMax = std::log2(20000.0f);
+            const float logStep = (logMax - logMin) / static_cast<float>(NUM_BANDS);
+            return std::pow(2.0f, logMin + edge * logStep);
+        }
 
-        for (int i = 1; i < numBins; ++i)
+        static const SpectralFeatureTables& get(int fftSize, double sampleRate)
         {
-            if (magnitudes[i] > 1e-10f)
-            {
-                logSum += std::log(magnitudes[i]);
-                linSum += magnitudes[i];
-                validBins++;
-            }
+            static std::mutex cacheMutex;
+            static std::map<std::pair<int, double>, std::unique_ptr<SpectralFeatureTables>> cache;
+
+            std::lock_guard<std::mutex> lock(cacheMutex);
+
+            auto& tables = cache[{ fftSize, sampleRate }];
+            if (tables == nullptr)
+                tables = std::make_unique<SpectralFeatureTables>(fftSize, sampleRate);
+
+            return *tables;
         }
 
-        if (validBins > 0 && linSum > 0.0f)
+        int fftSize;
+        double sampleRate;
+        int numBins;
+        float binWidth;
+
+        std::vector<float> frequency;    // Hz per bin
+        std::vector<float> slopeWeight;  // 1 for bins between 20 Hz and 20 kHz
+        std::vector<float> slopeX;       // log2(frequency) for those bins
+        std::array<int, NUM_BANDS> bandLow {};
+        std::array<int, NUM_BANDS> bandHigh {};
+    };
+
+    // Calculate spectral features from FFT magnitude data.
+    // One fused pass accumulates centroid, spread, flatness and slope terms in
+    // independent lanes (so the compiler can vectorize the float reductions);
+    // a second pass finds the rolloff and sums the bands.
+    inline SpectralFeatures calculateSpectralFeatures(const float* magnitudes, const SpectralFeatureTables& tables)
+    {
+        constexpr int LANES = 8;
+        constexpr float DB_PER_OCTAVE = 6.02059991f;  // 20 * log10(2)
+        constexpr float LN_2 = 0.693147181f;
+
+        SpectralFeatures features;
+        const int numBins = tables.numBins;
+        const float* frequency = tables.frequency.data();
+        const float* slopeWeight = tables.slopeWeight.data();
+        const float* slopeX = tables.slopeX.data();
+
+        struct Lanes
+        {
+            std::array<float, LANES> energy {}, freqEnergy {}, freq2Energy {};
+            std::array<float, LANES> logSum {}, linSum {}, validCount {};
+            std::array<float, LANES> n {}, x {}, y {}, xy {}, x2 {};
+        } acc;
+
+        auto accumulate = [&] (int i, int lane)
         {
-            float geometricMean = std::exp(logSum / validBins);
-            float arithmeticMean = linSum / validBins;
-            features.flatness = geometricMean / arithmeticMean;
+            const float mag = magnitudes[i];
+            const float energy = mag * mag;
+            const float freq = frequency[i];
+
+            acc.energy[lane] += energy;
+            acc.freqEnergy[lane] += freq * energy;
+            acc.freq2Energy[lane] += freq * freq * energy;
+
+            // Bins at or below 1e-10 are left out of flatness and slope
+            const float valid = mag > 1e-10f ? 1.0f : 0.0f;
+            const float log2Mag = fastLog2(mag) * valid;
+
+            acc.logSum[lane] += log2Mag;
+            acc.linSum[lane] += mag * valid;
+            acc.validCount[lane] += valid;
+
+            const float w = slopeWeight[i] * valid;
+            const float x = slopeX[i];
+            const float y = DB_PER_OCTAVE * log2Mag;
+            acc.n[lane] += w;
+            acc.x[lane] += w * x;
+            acc.y[lane] += w * y;
+            acc.xy[lane] += w * x * y;
+            acc.x2[lane] += w * x * x;
+        };
+
+        int i = 1;
+        for (; i + LANES <= numBins; i += LANES)
+            for (int lane = 0; lane < LANES; ++lane)
+                accumulate(i + lane, lane);
+
+        for (; i < numBins; ++i)
+            accumulate(i, 0);
+
+        auto total = [] (const std::array<float, LANES>& lanes)
+        {
+            double sum = 0.0;
+            for (float v : lanes)
+                sum += v;
+            return sum;
+        };
+
+        const double totalEnergy = total(acc.energy);
+
+        if (totalEnergy > 0.0)
+        {
+            const double centroid = total(acc.freqEnergy) / totalEnergy;
+            features.centroid = static_cast<float>(centroid);
+
+            // Spectral spread: E[f^2] - E[f]^2
+            features.spread = static_cast<float>(std::sqrt(std::max(0.0, total(acc.freq2Energy) / totalEnergy - centroid * centroid)));
         }
 
-        // Spectral slope (linear regression in log-frequency space)
-        float sumX = 0.0f, sumY = 0.0f, sumXY = 0.0f, sumX2 = 0.0f;
-        int slopePoints = 0;
+        // Spectral flatness (geometric mean / arithmetic mean)
+        const double validBins = total(acc.validCount);
+        const double linSum = total(acc.linSum);
 
-        for (int i = 1; i < numBins; ++i)
+        if (validBins > 0.0 && linSum > 0.0)
         {
-            float freq = i * binWidth;
-            if (freq > 20.0f && freq < 20000.0f && magnitudes[i] > 1e-10f)
-            {
-                float logFreq = std::log2(freq);
-                float logMag = linearToDecibels(magnitudes[i]);
-                sumX += logFreq;
-                sumY += logMag;
-                sumXY += logFreq * logMag;
-                sumX2 += logFreq * logFreq;
-                slopePoints++;
-            }
+            const double geometricMean = std::exp(total(acc.logSum) * LN_2 / validBins);
+            features.flatness = static_cast<float>(geometricMean / (linSum / validBins));
         }
 
-        if (slopePoints > 1)
+        // Spectral slope (linear regression of dB against log2 frequency)
+        const double n = total(acc.n);
+        if (n > 1.0)
         {
-            features.slope = (slopePoints * sumXY - sumX * sumY) /
-                            (slopePoints * sumX2 - sumX * sumX);
+            const double sumX = total(acc.x), sumY = total(acc.y);
+            const double denominator = n * total(acc.x2) - sumX * sumX;
+            if (denominator != 0.0)
+                features.slope = static_cast<float>((n * total(acc.xy) - sumX * sumY) / denominator);
         }
 
         // Spectral rolloff (frequency at 85% cumulative energy)
+        const float rolloffThreshold = static_cast<float>(totalEnergy) * 0.85f;
         float cumulativeEnergy = 0.0f;
-        float rolloffThreshold = totalEnergy * 0.85f;
 
-        for (int i = 1; i < numBins; ++i)
+        for (int bin = 1; bin < numBins; ++bin)
         {
-            cumulativeEnergy += magnitudes[i] * magnitudes[i];
+            cumulativeEnergy += magnitudes[bin] * magnitudes[bin];
             if (cumulativeEnergy >= rolloffThreshold)
             {
-                features.rolloff = i * binWidth;
+                features.rolloff = frequency[bin];
                 break;
             }
         }
 
-        // 32-band energy distribution (logarithmic spacing)
-        float minFreq = 20.0f;
-        float maxFreq = 20000.0f;
-        float logMin = std::log2(minFreq);
-        float logMax = std::log2(maxFreq);
-        float logStep = (logMax - logMin) / 32.0f;
-
-        for (int band = 0; band < 32; ++band)
+        // 32-band energy distribution from the precomputed bin ranges
+        for (int band = 0; band < SpectralFeatureTables::NUM_BANDS; ++band)
         {
-            float lowFreq = std::pow(2.0f, logMin + band * logStep);
-            float highFreq = std::pow(2.0f, logMin + (band + 1) * logStep);
-            int lowBin = static_cast<int>(lowFreq / binWidth);
-            int highBin = static_cast<int>(highFreq / binWidth);
-
-            lowBin = std::max(1, std::min(lowBin, numBins - 1));
-            highBin = std::max(lowBin + 1, std::min(highBin, numBins));
+            const int lowBin = tables.bandLow[static_cast<size_t>(band)];
+            const int highBin = tables.bandHigh[static_cast<size_t>(band)];
 
             float bandEnergy = 0.0f;
-            for (int i = lowBin; i < highBin; ++i)
-                bandEnergy += magnitudes[i] * magnitudes[i];
+            for (int bin = lowBin; bin < highBin; ++bin)
+                bandEnergy += magnitudes[bin] * magnitudes[bin];
 
-            features.bandEnergies[band] = linearToDecibels(std::sqrt(bandEnergy / (highBin - lowBin + 1)));
+            features.bandEnergies[static_cast<size_t>(band)] = linearToDecibels(std::sqrt(bandEnergy / (highBin - lowBin + 1)));
         }
 
         return features;
     }
 
+    inline SpectralFeatures calculateSpectralFeatures(const float* magnitudes, int fftSize, double sampleRate)
+    {
+        return calculateSpectralFeatures(magnitudes, SpectralFeatureTables::get(fftSize, sampleRate));
+    }
+
     // Soft clipper for gentle saturation
     inline float softClip(float input, float threshold = 0.9f)
     {
@@ -517,8 +1121,10 @@ namespace DSPUtils
                 b = 0.0f;
             bufferIndex = 0;
             peakValue = 0.0f;
+            samplePeak = 0.0f;
         }
 
+        // Returns the peak held since the last reset
         float process(float input)
         {
             // Store input in circular buffer for interpolation
@@ -528,20 +1134,25 @@ namespace DSPUtils
             float samples[4];
             int prevIndex = (bufferIndex + 3) % 4;
             float prev = buffer[prevIndex];
+            samplePeak = 0.0f;
 
             for (int i = 0; i < 4; ++i)
             {
                 float t = i / 4.0f;
                 float interp = prev + t * (input - prev);
                 samples[i] = states[i].process(interp, lpCoeffs);
-                peakValue = std::max(peakValue, std::abs(samples[i]));
+                samplePeak = std::max(samplePeak, std::abs(samples[i]));
             }
 
+            peakValue = std::max(peakValue, samplePeak);
             bufferIndex = (bufferIndex + 1) % 4;
             return peakValue;
         }
 
         float getPeakValue() const { return peakValue; }
+
+        // Oversampled peak of the last input sample alone
+        float getSamplePeak() const { return samplePeak; }
         void resetPeak() { peakValue = 0.0f; }
 
     private:
@@ -550,6 +1161,7 @@ namespace DSPUtils
         std::array<float, 4> buffer = {};
         int bufferIndex = 0;
         float peakValue = 0.0f;
+        float samplePeak = 0.0f;
     };
 
 } // namespace DSPUtils
@@ -2,14 +2,43 @@
 
 #include "DSPUtils.h"
 #include <array>
-#include <atomic>
-#include <deque>
-
+#include <cstdint>
+
+// Per-band crest factors, transient density, onset times and dynamic range.
+//
+// The low band (below 200 Hz) is split off a decimated copy of the input
+// running at 4 kHz or more, and the envelope followers run at 2 kHz or more
+// on each band's peak and mean square over the samples in between, so the
+// cost per sample barely grows with the host rate.
+//
+// Onsets are found at the envelope rate: the full-band energy of the last
+// 5 ms against the 100 ms before it, both kept as running sums. Dynamic
+// range comes from 10 s histograms of the full-band peak and RMS levels.
 class DynamicsAnalyzer
 {
 public:
     static constexpr int NUM_BANDS = 3;
-    static constexpr int TRANSIENT_WINDOW = 512;
+    static constexpr int HISTORY_SIZE = 100;  // 10 seconds at ~10 updates/sec
+    static constexpr double HISTORY_RATE = 10.0;
+    static constexpr double MIN_LOW_BAND_RATE = 4000.0;
+    static constexpr double MIN_ENVELOPE_RATE = 2000.0;
+    static constexpr int FULL_BAND = NUM_BANDS;        // Envelope slot for the unsplit mono signal
+    static constexpr int NUM_ENVELOPES = NUM_BANDS + 1;
+
+    // Onset detection, in envelope steps of at most 0.5 ms
+    static constexpr int ONSET_HISTORY = 512;          // Power of two, holds both windows
+    static constexpr double ONSET_FAST_SECONDS = 0.005;
+    static constexpr double ONSET_SLOW_SECONDS = 0.1;
+    static constexpr double MIN_ONSET_INTERVAL_SECONDS = 0.05;
+    static constexpr float ONSET_RATIO = 4.0f;         // 6 dB energy rise
+    static constexpr float ONSET_FLOOR = 1e-6f;        // -60 dBFS mean square
+    static constexpr int MAX_ONSETS = 32;
+
+    // Level histograms: 0.5 dB bins from -100 to 0 dBFS
+    static constexpr int HISTOGRAM_BINS = 200;
+    static constexpr float HISTOGRAM_FLOOR_DB = -100.0f;
+    static constexpr float HISTOGRAM_BIN_DB = 0.5f;
+    static constexpr float RMS_GATE_DB = -70.0f;       // Silence doesn't widen the range
 
     DynamicsAnalyzer() = default;
 
@@ -17,190 +46,392 @@ public:
     {
         currentSampleRate = sampleRate;
 
-        // Prepare crossovers
+        // Low band: decimated input, low side of the 200 Hz split at that rate
+        lowBandDecimator.setNumStages(DSPUtils::DecimationCascade::getNumStagesFor(sampleRate, MIN_LOW_BAND_RATE));
+        const double lowBandRate = sampleRate / lowBandDecimator.getFactor();
+
+        lowCrossover.prepare(lowBandRate);
+        lowCrossover.setCrossoverFrequency(200.0f);
+
+        // Mid and high: high side of the 200 Hz split, then the 3 kHz split, at full rate
         crossover1.prepare(sampleRate);
         crossover2.prepare(sampleRate);
         crossover1.setCrossoverFrequency(200.0f);
         crossover2.setCrossoverFrequency(3000.0f);
 
-        // Prepare envelope followers
-        for (int band = 0; band < NUM_BANDS; ++band)
+        // Envelope followers run once per envelope period
+        envelopePeriod = 1 << DSPUtils::DecimationCascade::getNumStagesFor(sampleRate, MIN_ENVELOPE_RATE);
+        const double envelopeRate = sampleRate / envelopePeriod;
+
+        for (int band = 0; band < NUM_ENVELOPES; ++band)
         {
-            peakFollower[band].prepare(sampleRate);
+            peakFollower[band].prepare(envelopeRate);
             peakFollower[band].setAttackTime(0.1f);   // Fast peak
             peakFollower[band].setReleaseTime(300.0f);
 
-            rmsFollower[band].prepare(sampleRate);
+            rmsFollower[band].prepare(envelopeRate);
             rmsFollower[band].setAttackTime(10.0f);
             rmsFollower[band].setReleaseTime(300.0f);
         }
 
+        onsetFastSteps = juce::jlimit(1, ONSET_HISTORY / 4, static_cast<int>(std::round(ONSET_FAST_SECONDS * envelopeRate)));
+        onsetSlowSteps = juce::jlimit(1, ONSET_HISTORY - onsetFastSteps, static_cast<int>(std::round(ONSET_SLOW_SECONDS * envelopeRate)));
+        minOnsetInterval = static_cast<int64_t>(MIN_ONSET_INTERVAL_SECONDS * sampleRate);
+        historyPeriod = std::max(1, static_cast<int>(std::round(sampleRate / HISTORY_RATE)));
+
         reset();
     }
 
     void reset()
     {
+        lowBandDecimator.reset();
+        lowCrossover.reset();
         crossover1.reset();
         crossover2.reset();
 
-        for (int band = 0; band < NUM_BANDS; ++band)
+        for (int band = 0; band < NUM_ENVELOPES; ++band)
         {
             peakFollower[band].reset();
             rmsFollower[band].reset();
-            crestFactor[band].store(0.0f);
         }
 
-        transientBuffer.clear();
-        transientDensity.store(0.0f);
-        dynamicRange.store(0.0f);
+        periodPeak.fill(0.0f);
+        periodSquares.fill(0.0f);
+        periodCount.fill(0);
+        envelopeCounter = 0;
+        fullBandPeak = 0.0f;
+        fullBandRMS = 0.0f;
+
+        std::fill(onsetEnergy.begin(), onsetEnergy.end(), 0.0f);
+        onsetIndex = 0;
+        onsetFastSum = 0.0;
+        onsetSlowSum = 0.0;
+        samplePosition = 0;
+        lastOnsetPosition = -minOnsetInterval;
+        onsetsThisSecond = 0;
+        samplesThisSecond = 0;
+        onsets = OnsetTimes {};
+        onsetsChanged = false;
+        publishedOnsets.publish(onsets);
+
+        features = {};
+        publishedFeatures.publish(features);
+
+        std::fill(peakHistory.begin(), peakHistory.end(), uint8_t { 0 });
+        std::fill(rmsHistory.begin(), rmsHistory.end(), uint8_t { 0 });
+        std::fill(peakHistogram.begin(), peakHistogram.end(), 0);
+        std::fill(rmsHistogram.begin(), rmsHistogram.end(), 0);
+        historyIndex = 0;
+        historyCount = 0;
+        historyCounter = 0;
+    }
 
-        peakHistory.clear();
-        rmsHistory.clear();
+    // Onset energies, level history and histograms live in the owner's arena; call after prepare()
+    void allocateState(DSPUtils::StateArena& arena)
+    {
+        onsetEnergy = arena.allocate<float>(ONSET_HISTORY);
+        peakHistory = arena.allocate<uint8_t>(HISTORY_SIZE);
+        rmsHistory = arena.allocate<uint8_t>(HISTORY_SIZE);
+        peakHistogram = arena.allocate<int>(HISTOGRAM_BINS);
+        rmsHistogram = arena.allocate<int>(HISTOGRAM_BINS);
     }
 
     void process(const float* left, const float* right, int numSamples)
     {
+        if (onsetEnergy.isEmpty() || numSamples < 1)
+            return;
+
         for (int i = 0; i < numSamples; ++i)
         {
             float mono = (left[i] + right[i]) * 0.5f;
 
-            // Split into bands
-            float low, midHigh, mid, high;
-            crossover1.process(mono, low, midHigh);
-            crossover2.process(midHigh, mid, high);
+            // Split into bands, the low band at its reduced rate
+            float decimated;
+            if (lowBandDecimator.process(mono, decimated))
+                accumulateBand(0, lowCrossover.processLow(decimated));
 
-            float bands[NUM_BANDS] = { low, mid, high };
+            float mid, high;
+            crossover2.process(crossover1.processHigh(mono), mid, high);
+            accumulateBand(1, mid);
+            accumulateBand(2, high);
+            accumulateBand(FULL_BAND, mono);
 
-            // Analyze each band
-            for (int band = 0; band < NUM_BANDS; ++band)
+            if (++envelopeCounter == envelopePeriod)
             {
-                float peak = peakFollower[band].process(bands[band]);
-                float rms = rmsFollower[band].processRMS(bands[band] * bands[band]);
-
-                // Calculate crest factor (peak/RMS ratio in dB)
-                if (rms > 1e-10f)
-                {
-                    float cf = DSPUtils::linearToDecibels(peak) - DSPUtils::linearToDecibels(rms);
-                    crestFactor[band].store(cf);
-                }
+                envelopeCounter = 0;
+                samplePosition += envelopePeriod;
+                updateEnvelopes();
             }
 
-            // Transient detection
-            float absValue = std::abs(mono);
-            transientBuffer.push_back(absValue);
-            if (transientBuffer.size() > TRANSIENT_WINDOW)
-                transientBuffer.pop_front();
-
-            // Count transients (samples that exceed short-term average significantly)
-            if (transientBuffer.size() == TRANSIENT_WINDOW)
+            if (++historyCounter == historyPeriod)
             {
-                float avg = 0.0f;
-                for (float v : transientBuffer)
-                    avg += v;
-                avg /= TRANSIENT_WINDOW;
-
-                if (absValue > avg * 3.0f)  // Transient threshold: 3x average
-                    transientCount++;
+                historyCounter = 0;
+                updateHistory();
             }
-
-            sampleCount++;
         }
 
         // Update transient density every second
-        int samplesPerSecond = static_cast<int>(currentSampleRate);
-        if (sampleCount >= samplesPerSecond)
+        samplesThisSecond += numSamples;
+        if (samplesThisSecond >= static_cast<int>(currentSampleRate))
         {
-            // Transients per second, normalized to 0-100 range
-            float density = std::min(100.0f, transientCount * 10.0f);
-            transientDensity.store(density);
+            // Onsets per second, normalized to 0-100 range
+            features.transientDensity = std::min(100.0f, static_cast<float>(onsetsThisSecond) * 10.0f);
 
-            transientCount = 0;
-            sampleCount = 0;
+            onsetsThisSecond = 0;
+            samplesThisSecond = 0;
         }
 
-        // Track overall dynamics
-        float overallPeak = peakFollower[1].process((left[numSamples - 1] + right[numSamples - 1]) * 0.5f);
-        float overallRMS = rmsFollower[1].processRMS(((left[numSamples - 1] + right[numSamples - 1]) * 0.5f));
-
-        peakHistory.push_back(DSPUtils::linearToDecibels(overallPeak));
-        rmsHistory.push_back(DSPUtils::linearToDecibels(overallRMS));
+        publishedFeatures.publish(features);
 
-        // Keep 10 seconds of history at ~10 updates/sec
-        while (peakHistory.size() > 100)
-            peakHistory.pop_front();
-        while (rmsHistory.size() > 100)
-            rmsHistory.pop_front();
-
-        // Calculate dynamic range from history
-        if (peakHistory.size() >= 10)
+        if (onsetsChanged)
         {
-            float maxPeak = -100.0f, minRMS = 0.0f;
-            for (float p : peakHistory)
-                maxPeak = std::max(maxPeak, p);
-            for (float r : rmsHistory)
-                minRMS = std::min(minRMS, r);
-
-            dynamicRange.store(maxPeak - minRMS);
+            publishedOnsets.publish(onsets);
+            onsetsChanged = false;
         }
     }
 
+    // Get all dynamics features as a struct
+    struct DynamicsFeatures
+    {
+        std::array<float, NUM_BANDS> crestFactors {};
+        float transientDensity = 0.0f;
+        float dynamicRange = 0.0f;
+    };
+
+    // One consistent set, as of the end of the last processed block
+    DynamicsFeatures getFeatures() const { return publishedFeatures.read(); }
+
     // Getters for analysis results
     float getCrestFactor(int band) const
     {
-        return (band >= 0 && band < NUM_BANDS) ? crestFactor[band].load() : 0.0f;
+        return (band >= 0 && band < NUM_BANDS) ? getFeatures().crestFactors[band] : 0.0f;
     }
 
     float getAverageCrestFactor() const
     {
+        const auto current = getFeatures();
         float sum = 0.0f;
         for (int band = 0; band < NUM_BANDS; ++band)
-            sum += crestFactor[band].load();
+            sum += current.crestFactors[band];
         return sum / NUM_BANDS;
     }
 
-    float getTransientDensity() const { return transientDensity.load(); }
-    float getDynamicRange() const { return dynamicRange.load(); }
+    float getTransientDensity() const { return getFeatures().transientDensity; }
+    float getDynamicRange() const { return getFeatures().dynamicRange; }
 
-    // Get all dynamics features as a struct
-    struct DynamicsFeatures
+    // The most recent onsets, oldest first, as sample positions since the
+    // last reset(). Positions are accurate to one envelope step.
+    struct OnsetTimes
     {
-        std::array<float, NUM_BANDS> crestFactors;
-        float transientDensity;
-        float dynamicRange;
+        std::array<int64_t, MAX_ONSETS> positions {};
+        int count = 0;
+        int64_t totalOnsets = 0;
     };
 
-    DynamicsFeatures getFeatures() const
+    OnsetTimes getRecentOnsets() const { return publishedOnsets.read(); }
+
+    double getOnsetSeconds(int64_t position) const { return static_cast<double>(position) / currentSampleRate; }
+
+private:
+    inline void accumulateBand(int band, float sample)
     {
-        DynamicsFeatures features;
-        for (int band = 0; band < NUM_BANDS; ++band)
-            features.crestFactors[band] = crestFactor[band].load();
-        features.transientDensity = transientDensity.load();
-        features.dynamicRange = dynamicRange.load();
-        return features;
+        periodPeak[band] = std::max(periodPeak[band], std::abs(sample));
+        periodSquares[band] += sample * sample;
+        ++periodCount[band];
     }
 
-private:
-    double currentSampleRate = 44100.0;
+    // One envelope step per band from the peak and mean square since the last
+    void updateEnvelopes()
+    {
+        for (int band = 0; band < NUM_ENVELOPES; ++band)
+        {
+            if (periodCount[band] == 0)
+                continue;
 
-    // Crossover filters
-    DSPUtils::LinkwitzRileyCrossover crossover1;
-    DSPUtils::LinkwitzRileyCrossover crossover2;
+            float peak = peakFollower[band].process(periodPeak[band]);
+            float rms = rmsFollower[band].processRMS(periodSquares[band] / static_cast<float>(periodCount[band]));
 
-    // Per-band envelope followers
-    DSPUtils::EnvelopeFollower peakFollower[NUM_BANDS];
-    DSPUtils::EnvelopeFollower rmsFollower[NUM_BANDS];
+            if (band == FULL_BAND)
+            {
+                fullBandPeak = peak;
+                fullBandRMS = rms;
+                detectOnset(periodSquares[band] / static_cast<float>(periodCount[band]));
+            }
+            // Calculate crest factor (peak/RMS ratio in dB)
+            else if (rms > 1e-10f)
+            {
+                float cf = DSPUtils::linearToDecibels(peak) - DSPUtils::linearToDecibels(rms);
+                features.crestFactors[band] = cf;
+            }
 
-    // Atomic crest factor per band
-    std::array<std::atomic<float>, NUM_BANDS> crestFactor = { 0.0f, 0.0f, 0.0f };
+            periodPeak[band] = 0.0f;
+            periodSquares[band] = 0.0f;
+            periodCount[band] = 0;
+        }
+    }
 
-    // Transient detection
-    std::deque<float> transientBuffer;
-    int transientCount = 0;
-    int sampleCount = 0;
-    std::atomic<float> transientDensity { 0.0f };
+    // Slides both windows one step: the newest energy enters the fast
+    // window, the one leaving it enters the slow window, and the oldest
+    // leaves the slow window.
+    void detectOnset(float energy)
+    {
+        const int mask = ONSET_HISTORY - 1;
+        const float leavingFast = onsetEnergy[(onsetIndex - onsetFastSteps) & mask];
+        const float leavingSlow = onsetEnergy[(onsetIndex - onsetFastSteps - onsetSlowSteps) & mask];
+
+        onsetFastSum += static_cast<double>(energy) - leavingFast;
+        onsetSlowSum += static_cast<double>(leavingFast) - leavingSlow;
+
+        onsetEnergy[onsetIndex] = energy;
+        onsetIndex = (onsetIndex + 1) & mask;
+
+        // Once per lap, recompute the sums so rounding can't build up
+        if (onsetIndex == 0)
+            resumOnsetWindows();
+
+        const float fastMean = static_cast<float>(onsetFastSum) / static_cast<float>(onsetFastSteps);
+        const float slowMean = static_cast<float>(onsetSlowSum) / static_cast<float>(onsetSlowSteps);
+
+        if (fastMean > ONSET_FLOOR
+            && fastMean > slowMean * ONSET_RATIO
+            && samplePosition - lastOnsetPosition >= minOnsetInterval)
+        {
+            // Report the start of the step that crossed the threshold
+            const int64_t position = samplePosition - envelopePeriod;
+            lastOnsetPosition = samplePosition;
+            ++onsetsThisSecond;
+
+            if (onsets.count == MAX_ONSETS)
+                std::copy(onsets.positions.begin() + 1, onsets.positions.end(), onsets.positions.begin());
+            else
+                ++onsets.count;
+
+            onsets.positions[static_cast<size_t>(onsets.count - 1)] = position;
+            ++onsets.totalOnsets;
+            onsetsChanged = true;
+        }
+    }
+
+    void resumOnsetWindows()
+    {
+        const int mask = ONSET_HISTORY - 1;
+        onsetFastSum = 0.0;
+        onsetSlowSum = 0.0;
+
+        for (int i = 1; i <= onsetFastSteps; ++i)
+            onsetFastSum += onsetEnergy[(onsetIndex - i) & mask];
+
+        for (int i = onsetFastSteps + 1; i <= onsetFastSteps + onsetSlowSteps; ++i)
+            onsetSlowSum += onsetEnergy[(onsetIndex - i) & mask];
+    }
+
+    static uint8_t getHistogramBin(float levelDB)
+    {
+        const int bin = static_cast<int>((levelDB - HISTOGRAM_FLOOR_DB) / HISTOGRAM_BIN_DB);
+        return static_cast<uint8_t>(juce::jlimit(0, HISTOGRAM_BINS - 1, bin));
+    }
+
+    static float getBinLevel(int bin) { return HISTOGRAM_FLOOR_DB + (static_cast<float>(bin) + 0.5f) * HISTOGRAM_BIN_DB; }
+
+    // Level of the given fraction of the way up a histogram, ignoring bins below firstBin
+    float getPercentileLevel(const DSPUtils::StateArray<int>& histogram, int firstBin, float fraction) const
+    {
+        int total = 0;
+        for (int bin = firstBin; bin < HISTOGRAM_BINS; ++bin)
+            total += histogram[bin];
+
+        if (total == 0)
+            return getBinLevel(firstBin);
+
+        const int target = std::max(1, static_cast<int>(std::ceil(fraction * static_cast<float>(total))));
+        int cumulative = 0;
+        for (int bin = firstBin; bin < HISTOGRAM_BINS; ++bin)
+        {
+            cumulative += histogram[bin];
+            if (cumulative >= target)
+                return getBinLevel(bin);
+        }
+
+        return getBinLevel(HISTOGRAM_BINS - 1);
+    }
+
+    // Ten times a second: move the full-band levels through the histograms
+    // and read the range off them
+    void updateHistory()
+    {
+        if (historyCount == HISTORY_SIZE)
+        {
+            --peakHistogram[peakHistory[historyIndex]];
+            --rmsHistogram[rmsHistory[historyIndex]];
+        }
+
+        const uint8_t peakBin = getHistogramBin(DSPUtils::linearToDecibels(fullBandPeak));
+        const uint8_t rmsBin = getHistogramBin(DSPUtils::linearToDecibels(fullBandRMS));
+        peakHistory[historyIndex] = peakBin;
+        rmsHistory[historyIndex] = rmsBin;
+        ++peakHistogram[peakBin];
+        ++rmsHistogram[rmsBin];
+
+        historyIndex = (historyIndex + 1) % HISTORY_SIZE;
+        historyCount = std::min(historyCount + 1, HISTORY_SIZE);
+
+        // Loud peaks (95th percentile) over quiet passages (10th percentile
+        // of RMS above the silence gate); one stray spike or a gap between
+        // songs no longer sets the range
+        if (historyCount >= 10)
+        {
+            const float loudPeak = getPercentileLevel(peakHistogram, 0, 0.95f);
+            const float quietRMS = getPercentileLevel(rmsHistogram, getHistogramBin(RMS_GATE_DB), 0.1f);
+            features.dynamicRange = std::max(0.0f, loudPeak - quietRMS);
+        }
+    }
+
+    double currentSampleRate = 44100.0;
+
+    // Crossover filters; the low band is split off the decimated input
+    DSPUtils::DecimationCascade lowBandDecimator;
+    DSPUtils::LinkwitzRileyCrossover lowCrossover;
+    DSPUtils::LinkwitzRileyCrossover crossover1;
+    DSPUtils::LinkwitzRileyCrossover crossover2;
 
-    // Dynamic range tracking
-    std::deque<float> peakHistory;
-    std::deque<float> rmsHistory;
-    std::atomic<float> dynamicRange { 0.0f };
+    // Per-band envelope followers, stepped once per envelope period
+    DSPUtils::EnvelopeFollower peakFollower[NUM_ENVELOPES];
+    DSPUtils::EnvelopeFollower rmsFollower[NUM_ENVELOPES];
+    std::array<float, NUM_ENVELOPES> periodPeak {};
+    std::array<float, NUM_ENVELOPES> periodSquares {};
+    std::array<int, NUM_ENVELOPES> periodCount {};
+    int envelopePeriod = 16;
+    int envelopeCounter = 0;
+    float fullBandPeak = 0.0f;
+    float fullBandRMS = 0.0f;
+
+    // Onset detection: full-band energy per envelope step (arena memory)
+    DSPUtils::StateArray<float> onsetEnergy;
+    int onsetIndex = 0;
+    int onsetFastSteps = 10;
+    int onsetSlowSteps = 200;
+    double onsetFastSum = 0.0;
+    double onsetSlowSum = 0.0;
+    int64_t samplePosition = 0;      // Samples since reset, in whole envelope steps
+    int64_t lastOnsetPosition = 0;
+    int64_t minOnsetInterval = 2205;
+    int onsetsThisSecond = 0;
+    int samplesThisSecond = 0;
+    OnsetTimes onsets;
+    bool onsetsChanged = false;
+    DSPUtils::SeqLock<OnsetTimes> publishedOnsets;
+
+    // Dynamic range tracking: level history as histogram bins (arena memory)
+    DSPUtils::StateArray<uint8_t> peakHistory;
+    DSPUtils::StateArray<uint8_t> rmsHistory;
+    DSPUtils::StateArray<int> peakHistogram;
+    DSPUtils::StateArray<int> rmsHistogram;
+    int historyIndex = 0;
+    int historyCount = 0;
+    int historyPeriod = 4410;
+    int historyCounter = 0;
+
+    // Results: working copy (audio thread) and the last published set
+    DynamicsFeatures features;
+    DSPUtils::SeqLock<DynamicsFeatures> publishedFeatures;
 };
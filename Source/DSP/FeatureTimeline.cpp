@@ -0,0 +1,3 @@
+// FeatureTimeline implementation
+// All functionality is in the header file
+#include "FeatureTimeline.h"
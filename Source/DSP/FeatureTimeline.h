@@ -0,0 +1,264 @@
+#pragma once
+
+#include "DSPUtils.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// A time series of analysis frames, one per 100 ms, with section detection
+// on top.
+//
+// Frames live in a fixed ring of MAX_FRAMES (about 55 minutes, a full album
+// side) stored column by column, one byte per value: levels in 0.5 dB
+// steps, crest factor in 0.25 dB, width in hundredths and correlation in
+// 1/127ths. The whole ring is about 1.2 MB of arena memory.
+//
+// The audio thread pushes frames; any other thread copies them out with
+// getFrames(), which trims frames the writer lapped during the copy.
+class FeatureTimeline
+{
+public:
+    static constexpr int NUM_BANDS = 32;
+    static constexpr int MAX_FRAMES = 1 << 15;
+    static constexpr double FRAME_SECONDS = 0.1;
+
+    // Section detection, in frames
+    static constexpr int NOVELTY_FRAMES = 40;      // 4 s either side of a boundary
+    static constexpr int MIN_SECTION_FRAMES = 80;  // 8 s
+    static constexpr float NOVELTY_THRESHOLD = 2.0f;
+    static constexpr float SILENCE_LUFS = -70.0f;
+
+    struct Frame
+    {
+        std::array<float, NUM_BANDS> bandEnergies {};
+        float shortTermLUFS = -100.0f;
+        float crestFactor = 0.0f;
+        float width = 0.0f;
+        float correlation = 0.0f;
+    };
+
+    // Loudness of a section against the loudest one: Peak sections are the
+    // chorus/drop candidates, Low ones intros and breakdowns
+    enum class SectionLevel
+    {
+        Low,
+        Mid,
+        Peak
+    };
+
+    struct Section
+    {
+        int startFrame = 0;  // Index into the frames passed to findSections()
+        int endFrame = 0;
+        float loudness = -100.0f;  // Energy mean of the short-term LUFS
+        SectionLevel level = SectionLevel::Low;
+
+        int getNumFrames() const { return endFrame - startFrame; }
+    };
+
+    FeatureTimeline() = default;
+
+    void allocateState(DSPUtils::StateArena& arena)
+    {
+        for (auto& column : bandColumns)
+            column = arena.allocate<uint8_t>(MAX_FRAMES);
+
+        lufsColumn = arena.allocate<uint8_t>(MAX_FRAMES);
+        crestColumn = arena.allocate<uint8_t>(MAX_FRAMES);
+        widthColumn = arena.allocate<uint8_t>(MAX_FRAMES);
+        correlationColumn = arena.allocate<int8_t>(MAX_FRAMES);
+    }
+
+    void reset()
+    {
+        frameCount.store(0, std::memory_order_release);
+    }
+
+    // Audio thread
+    void push(const Frame& frame)
+    {
+        if (lufsColumn.isEmpty())
+            return;
+
+        const int64_t count = frameCount.load(std::memory_order_relaxed);
+        const int slot = static_cast<int>(count & (MAX_FRAMES - 1));
+
+        for (int band = 0; band < NUM_BANDS; ++band)
+            bandColumns[static_cast<size_t>(band)][slot] = packLevel(frame.bandEnergies[static_cast<size_t>(band)]);
+
+        lufsColumn[slot] = packLevel(frame.shortTermLUFS);
+        crestColumn[slot] = static_cast<uint8_t>(juce::jlimit(0, 255, static_cast<int>(std::lrint(frame.crestFactor * 4.0f))));
+        widthColumn[slot] = static_cast<uint8_t>(juce::jlimit(0, 255, static_cast<int>(std::lrint(frame.width * 100.0f))));
+        correlationColumn[slot] = static_cast<int8_t>(juce::jlimit(-127, 127, static_cast<int>(std::lrint(frame.correlation * 127.0f))));
+
+        frameCount.store(count + 1, std::memory_order_release);
+    }
+
+    // Frames pushed since the last reset, including any the ring has dropped
+    int64_t getTotalFrames() const { return frameCount.load(std::memory_order_acquire); }
+
+    // The newest frames (up to maxFrames), oldest first
+    std::vector<Frame> getFrames(int maxFrames = MAX_FRAMES) const
+    {
+        std::vector<Frame> frames;
+        if (lufsColumn.isEmpty())
+            return frames;
+
+        // Keep one slot of slack for the frame being written
+        const int64_t end = frameCount.load(std::memory_order_acquire);
+        const int64_t numFrames = std::min(end, static_cast<int64_t>(std::min(maxFrames, MAX_FRAMES - 1)));
+        const int64_t start = end - numFrames;
+
+        frames.resize(static_cast<size_t>(numFrames));
+
+        for (int64_t i = 0; i < numFrames; ++i)
+        {
+            const int slot = static_cast<int>((start + i) & (MAX_FRAMES - 1));
+            Frame& frame = frames[static_cast<size_t>(i)];
+
+            for (int band = 0; band < NUM_BANDS; ++band)
+                frame.bandEnergies[static_cast<size_t>(band)] = unpackLevel(bandColumns[static_cast<size_t>(band)][slot]);
+
+            frame.shortTermLUFS = unpackLevel(lufsColumn[slot]);
+            frame.crestFactor = static_cast<float>(crestColumn[slot]) * 0.25f;
+            frame.width = static_cast<float>(widthColumn[slot]) * 0.01f;
+            frame.correlation = static_cast<float>(correlationColumn[slot]) / 127.0f;
+        }
+
+        // Drop any the writer lapped while we copied
+        const int64_t firstIntact = frameCount.load(std::memory_order_acquire) + 1 - MAX_FRAMES;
+        if (firstIntact > start)
+            frames.erase(frames.begin(), frames.begin() + static_cast<std::ptrdiff_t>(std::min(numFrames, firstIntact - start)));
+
+        return frames;
+    }
+
+    // Splits the frames where loudness or spectral shape changes for good.
+    // Novelty at each frame is the difference between the means of the
+    // NOVELTY_FRAMES before and after it (loudness in dB plus the average
+    // change in band-relative levels), from prefix sums in one pass.
+    // Boundaries are novelty peaks over NOVELTY_THRESHOLD at least
+    // MIN_SECTION_FRAMES apart.
+    static std::vector<Section> findSections(const std::vector<Frame>& frames)
+    {
+        std::vector<Section> sections;
+        const int numFrames = static_cast<int>(frames.size());
+        if (numFrames == 0)
+            return sections;
+
+        // Per-frame features: loudness, then each band relative to the frame's mean band level
+        constexpr int numFeatures = NUM_BANDS + 1;
+        std::vector<double> prefix(static_cast<size_t>((numFrames + 1) * numFeatures), 0.0);
+
+        for (int f = 0; f < numFrames; ++f)
+        {
+            const Frame& frame = frames[static_cast<size_t>(f)];
+            const double* previous = prefix.data() + f * numFeatures;
+            double* current = prefix.data() + (f + 1) * numFeatures;
+
+            float meanBand = 0.0f;
+            for (float level : frame.bandEnergies)
+                meanBand += level;
+            meanBand /= NUM_BANDS;
+
+            current[0] = previous[0] + std::max(frame.shortTermLUFS, SILENCE_LUFS);
+            for (int band = 0; band < NUM_BANDS; ++band)
+                current[band + 1] = previous[band + 1] + (frame.bandEnergies[static_cast<size_t>(band)] - meanBand);
+        }
+
+        const auto windowMean = [&prefix] (int feature, int first, int last)
+        {
+            return (prefix[static_cast<size_t>(last * numFeatures + feature)]
+                    - prefix[static_cast<size_t>(first * numFeatures + feature)]) / (last - first);
+        };
+
+        std::vector<float> novelty(static_cast<size_t>(numFrames), 0.0f);
+        for (int f = NOVELTY_FRAMES; f + NOVELTY_FRAMES <= numFrames; ++f)
+        {
+            double shapeChange = 0.0;
+            for (int band = 1; band < numFeatures; ++band)
+                shapeChange += std::abs(windowMean(band, f, f + NOVELTY_FRAMES) - windowMean(band, f - NOVELTY_FRAMES, f));
+
+            const double loudnessChange = std::abs(windowMean(0, f, f + NOVELTY_FRAMES) - windowMean(0, f - NOVELTY_FRAMES, f));
+            novelty[static_cast<size_t>(f)] = static_cast<float>(loudnessChange + shapeChange / NUM_BANDS);
+        }
+
+        // Peak picking: the largest novelty within half a minimum section either side
+        std::vector<int> boundaries { 0 };
+        const int halfSection = MIN_SECTION_FRAMES / 2;
+
+        for (int f = NOVELTY_FRAMES; f + NOVELTY_FRAMES <= numFrames; ++f)
+        {
+            const float value = novelty[static_cast<size_t>(f)];
+            if (value < NOVELTY_THRESHOLD || f - boundaries.back() < MIN_SECTION_FRAMES || numFrames - f < MIN_SECTION_FRAMES)
+                continue;
+
+            bool isPeak = true;
+            for (int g = std::max(0, f - halfSection); g < std::min(numFrames, f + halfSection + 1) && isPeak; ++g)
+                isPeak = novelty[static_cast<size_t>(g)] < value || (novelty[static_cast<size_t>(g)] == value && g >= f);
+
+            if (isPeak)
+                boundaries.push_back(f);
+        }
+
+        boundaries.push_back(numFrames);
+
+        float loudest = -100.0f;
+        for (size_t b = 0; b + 1 < boundaries.size(); ++b)
+        {
+            Section section;
+            section.startFrame = boundaries[b];
+            section.endFrame = boundaries[b + 1];
+            section.loudness = getEnergyMeanLUFS(frames, section.startFrame, section.endFrame);
+            loudest = std::max(loudest, section.loudness);
+            sections.push_back(section);
+        }
+
+        for (auto& section : sections)
+        {
+            const float belowLoudest = loudest - section.loudness;
+            section.level = belowLoudest <= 2.0f ? SectionLevel::Peak
+                          : belowLoudest <= 6.0f ? SectionLevel::Mid
+                                                 : SectionLevel::Low;
+        }
+
+        return sections;
+    }
+
+    // Mean of the short-term loudness over [startFrame, endFrame) in the power domain
+    static float getEnergyMeanLUFS(const std::vector<Frame>& frames, int startFrame, int endFrame)
+    {
+        double power = 0.0;
+        int count = 0;
+
+        for (int f = startFrame; f < endFrame; ++f)
+        {
+            const float lufs = frames[static_cast<size_t>(f)].shortTermLUFS;
+            if (lufs > SILENCE_LUFS)
+            {
+                power += std::pow(10.0, lufs / 10.0);
+                ++count;
+            }
+        }
+
+        return count > 0 ? static_cast<float>(10.0 * std::log10(power / count)) : -100.0f;
+    }
+
+private:
+    static uint8_t packLevel(float levelDB)
+    {
+        return static_cast<uint8_t>(juce::jlimit(0, 255, static_cast<int>(std::lrint((levelDB + 100.0f) * 2.0f))));
+    }
+
+    static float unpackLevel(uint8_t packed) { return static_cast<float>(packed) * 0.5f - 100.0f; }
+
+    // Columns (arena memory)
+    std::array<DSPUtils::StateArray<uint8_t>, NUM_BANDS> bandColumns;
+    DSPUtils::StateArray<uint8_t> lufsColumn;
+    DSPUtils::StateArray<uint8_t> crestColumn;
+    DSPUtils::StateArray<uint8_t> widthColumn;
+    DSPUtils::StateArray<int8_t> correlationColumn;
+
+    std::atomic<int64_t> frameCount { 0 };
+};
@@ -0,0 +1,3 @@
+// InputCapture implementation
+// All functionality is in the header file
+#include "InputCapture.h"
@@ -0,0 +1,214 @@
+#pragma once
+
+#include "DSPUtils.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// The last stretch of plugin input (30-120 s) in a preallocated ring, so
+// auto-master can analyze what already played instead of asking for a
+// replay.
+//
+// The audio thread stages BLOCK_SIZE frames at a time and then commits
+// them to the ring in one go. It never allocates or waits. Compressed
+// rings store each block as 16-bit samples scaled to that block's peak
+// (per channel), which halves the memory and still leaves about 90 dB of
+// range below the block peak, plenty for analysis.
+//
+// One reader thread at a time copies out the latest samples with
+// readLatest(). A copy that the writer overtakes is trimmed to the part
+// that was still intact.
+class InputCapture
+{
+public:
+    static constexpr int BLOCK_SIZE = 256;
+    static constexpr double MIN_SECONDS = 30.0;
+    static constexpr double MAX_SECONDS = 120.0;
+
+    InputCapture() = default;
+
+    // Allocates the ring; call while audio is stopped
+    void prepare(double sampleRate, double seconds, bool compressed)
+    {
+        currentSampleRate = sampleRate;
+        isCompressed = compressed;
+
+        const double clampedSeconds = juce::jlimit(MIN_SECONDS, MAX_SECONDS, seconds);
+        const int64_t numBlocks = std::max(int64_t { 2 }, static_cast<int64_t>(std::ceil(clampedSeconds * sampleRate / BLOCK_SIZE)));
+        capacity = numBlocks * BLOCK_SIZE;
+
+        floatLeft.clear();
+        floatRight.clear();
+        packedLeft.clear();
+        packedRight.clear();
+        blockScaleLeft.clear();
+        blockScaleRight.clear();
+
+        if (isCompressed)
+        {
+            packedLeft.assign(static_cast<size_t>(capacity), 0);
+            packedRight.assign(static_cast<size_t>(capacity), 0);
+            blockScaleLeft.assign(static_cast<size_t>(numBlocks), 0.0f);
+            blockScaleRight.assign(static_cast<size_t>(numBlocks), 0.0f);
+        }
+        else
+        {
+            floatLeft.assign(static_cast<size_t>(capacity), 0.0f);
+            floatRight.assign(static_cast<size_t>(capacity), 0.0f);
+        }
+
+        reset();
+    }
+
+    void reset()
+    {
+        stagingLeft.fill(0.0f);
+        stagingRight.fill(0.0f);
+        stagedFrames = 0;
+        writePosition.store(0, std::memory_order_release);
+    }
+
+    // Audio thread
+    template <typename SampleType>
+    void write(const SampleType* left, const SampleType* right, int numSamples)
+    {
+        if (capacity == 0)
+            return;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            stagingLeft[static_cast<size_t>(stagedFrames)] = static_cast<float>(left[i]);
+            stagingRight[static_cast<size_t>(stagedFrames)] = static_cast<float>(right[i]);
+
+            if (++stagedFrames == BLOCK_SIZE)
+            {
+                commitBlock();
+                stagedFrames = 0;
+            }
+        }
+    }
+
+    double getSampleRate() const { return currentSampleRate; }
+    int64_t getCapacity() const { return capacity; }
+
+    // Frames a reader can get, at most the ring's capacity less one block
+    int64_t getNumAvailable() const
+    {
+        return std::min(writePosition.load(std::memory_order_acquire), std::max(int64_t { 0 }, capacity - BLOCK_SIZE));
+    }
+
+    double getAvailableSeconds() const { return static_cast<double>(getNumAvailable()) / currentSampleRate; }
+
+    // Copies the newest frames (up to maxFrames), oldest first, and returns
+    // how many are valid. Call from one thread at a time.
+    int64_t readLatest(float* left, float* right, int64_t maxFrames) const
+    {
+        const int64_t end = writePosition.load(std::memory_order_acquire);
+        const int64_t numFrames = std::min(maxFrames, std::min(end, capacity - BLOCK_SIZE));
+        const int64_t start = end - numFrames;
+
+        if (numFrames <= 0)
+            return 0;
+
+        for (int64_t position = start; position < end; )
+        {
+            const int64_t slot = position % capacity;
+            const int64_t count = std::min(end - position, capacity - slot);
+            const int64_t offset = position - start;
+
+            if (isCompressed)
+            {
+                unpack(packedLeft, blockScaleLeft, slot, count, left + offset);
+                unpack(packedRight, blockScaleRight, slot, count, right + offset);
+            }
+            else
+            {
+                std::copy_n(floatLeft.data() + slot, count, left + offset);
+                std::copy_n(floatRight.data() + slot, count, right + offset);
+            }
+
+            position += count;
+        }
+
+        // The writer may have lapped the oldest frames while we copied; the
+        // block it is filling is already being overwritten too
+        const int64_t firstIntact = writePosition.load(std::memory_order_acquire) + BLOCK_SIZE - capacity;
+        if (firstIntact <= start)
+            return numFrames;
+
+        const int64_t torn = std::min(numFrames, firstIntact - start);
+        std::copy(left + torn, left + numFrames, left);
+        std::copy(right + torn, right + numFrames, right);
+        return numFrames - torn;
+    }
+
+private:
+    void commitBlock()
+    {
+        const int64_t position = writePosition.load(std::memory_order_relaxed);
+        const int64_t slot = position % capacity;
+
+        if (isCompressed)
+        {
+            const size_t block = static_cast<size_t>(slot / BLOCK_SIZE);
+            blockScaleLeft[block] = pack(stagingLeft, packedLeft.data() + slot);
+            blockScaleRight[block] = pack(stagingRight, packedRight.data() + slot);
+        }
+        else
+        {
+            std::copy(stagingLeft.begin(), stagingLeft.end(), floatLeft.data() + slot);
+            std::copy(stagingRight.begin(), stagingRight.end(), floatRight.data() + slot);
+        }
+
+        writePosition.store(position + BLOCK_SIZE, std::memory_order_release);
+    }
+
+    // Scales a block to its peak and rounds it to 16 bits; returns the scale
+    static float pack(const std::array<float, BLOCK_SIZE>& samples, int16_t* dest)
+    {
+        float peak = 0.0f;
+        for (float sample : samples)
+            peak = std::max(peak, std::abs(sample));
+
+        if (peak < 1e-20f)
+        {
+            std::fill_n(dest, BLOCK_SIZE, int16_t { 0 });
+            return 0.0f;
+        }
+
+        const float toPacked = 32767.0f / peak;
+        for (int i = 0; i < BLOCK_SIZE; ++i)
+            dest[i] = static_cast<int16_t>(std::lrint(samples[static_cast<size_t>(i)] * toPacked));
+
+        return peak / 32767.0f;
+    }
+
+    static void unpack(const std::vector<int16_t>& packed, const std::vector<float>& scales,
+                       int64_t slot, int64_t count, float* dest)
+    {
+        for (int64_t i = 0; i < count; ++i)
+        {
+            const int64_t index = slot + i;
+            dest[i] = static_cast<float>(packed[static_cast<size_t>(index)]) * scales[static_cast<size_t>(index / BLOCK_SIZE)];
+        }
+    }
+
+    double currentSampleRate = 44100.0;
+    bool isCompressed = true;
+    int64_t capacity = 0;  // Frames, a whole number of blocks
+
+    // Ring storage: float, or 16-bit with one scale per block
+    std::vector<float> floatLeft;
+    std::vector<float> floatRight;
+    std::vector<int16_t> packedLeft;
+    std::vector<int16_t> packedRight;
+    std::vector<float> blockScaleLeft;
+    std::vector<float> blockScaleRight;
+
+    // Audio thread staging
+    std::array<float, BLOCK_SIZE> stagingLeft {};
+    std::array<float, BLOCK_SIZE> stagingRight {};
+    int stagedFrames = 0;
+
+    std::atomic<int64_t> writePosition { 0 };  // Frames committed since reset
+};
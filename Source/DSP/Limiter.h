@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DSPUtils.h"
+#include "Oversampler.h"
 #include <juce_dsp/juce_dsp.h>
 #include <vector>
 #include <cmath>
@@ -34,34 +35,51 @@ public:
 
     Limiter() = default;
 
-    void prepare(double sampleRate, int samplesPerBlock)
+    // Cheap: records sizes and recomputes coefficients. Buffers are handed out
+    // by allocateState(), and only for the given precision; the other path
+    // stays empty until the host switches precision and re-prepares.
+    void prepare(double sampleRate, int samplesPerBlock, int numChannels = 2,
+                 juce::AudioProcessor::ProcessingPrecision precision = juce::AudioProcessor::singlePrecision)
     {
         currentSampleRate = sampleRate;
         currentBlockSize = samplesPerBlock;
+        currentNumChannels = juce::jlimit(1, DSPUtils::MAX_CHANNELS, numChannels);
+        currentPrecision = precision;
 
-        // Lookahead buffer (5ms)
+        // Lookahead (5ms); the buffers themselves are handed out by allocateState()
         lookaheadSamples = static_cast<int>(sampleRate * 0.005);
-        lookaheadBufferL.resize(lookaheadSamples, 0.0f);
-        lookaheadBufferR.resize(lookaheadSamples, 0.0f);
-        gainBuffer.resize(lookaheadSamples, 1.0f);
-
-        // 4x oversampling for true peak detection (ITU-R BS.1770 compliant)
-        oversampling = std::make_unique<juce::dsp::Oversampling<float>>(
-            2,  // numChannels
-            2,  // order (2^2 = 4x)
-            juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple,
-            true  // isMaxQuality
-        );
-        oversampling->initProcessing(static_cast<size_t>(samplesPerBlock));
+
+        signalPaths.forEach([this] (auto& path) { path.prepare(currentNumChannels, currentBlockSize); });
 
         updateCoefficients();
         reset();
     }
 
+    // Lays out the lookahead line, gain history and true-peak scratch in the
+    // owner's arena. Call after prepare(); process() is a no-op until then.
+    void allocateState(DSPUtils::StateArena& arena)
+    {
+        signalPaths.forEach([] (auto& path) { path.release(); });
+
+        if (currentPrecision == juce::AudioProcessor::doublePrecision)
+            signalPaths.doubleVersion.lookaheadBuffer = arena.allocate<DSPUtils::ChannelFrame<double>>(lookaheadSamples);
+        else
+            signalPaths.floatVersion.lookaheadBuffer = arena.allocate<DSPUtils::ChannelFrame<float>>(lookaheadSamples);
+
+        gainBuffer = arena.allocate<float>(lookaheadSamples);
+        truePeaks = arena.allocate<float>(currentBlockSize);
+
+        if (currentPrecision == juce::AudioProcessor::doublePrecision)
+            signalPaths.doubleVersion.oversampler.allocateState(arena);
+        else
+            signalPaths.floatVersion.oversampler.allocateState(arena);
+
+        std::fill(gainBuffer.begin(), gainBuffer.end(), 1.0f);
+    }
+
     void reset()
     {
-        std::fill(lookaheadBufferL.begin(), lookaheadBufferL.end(), 0.0f);
-        std::fill(lookaheadBufferR.begin(), lookaheadBufferR.end(), 0.0f);
+        signalPaths.forEach([] (auto& path) { path.reset(); });
         std::fill(gainBuffer.begin(), gainBuffer.end(), 1.0f);
         lookaheadIndex = 0;
 
@@ -69,35 +87,37 @@ public:
         slowEnvelope = 0.0f;
         smoothedGain = 1.0f;
         gainReduction.store(0.0f);
-
-        if (oversampling)
-            oversampling->reset();
     }
 
-    void process(juce::AudioBuffer<float>& buffer)
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer)
     {
-        if (bypassed)
+        auto& path = signalPaths.get<SampleType>();
+
+        if (bypassed || path.lookaheadBuffer.isEmpty())
             return;
 
         const int numSamples = buffer.getNumSamples();
-        const int numChannels = std::min(buffer.getNumChannels(), 2);
+        jassert(numSamples <= truePeaks.size);  // MasteringChain splits larger host blocks
+
+        const int numChannels = std::min(buffer.getNumChannels(), currentNumChannels);
+        auto* const* channels = buffer.getArrayOfWritePointers();
+        auto& lookaheadBuffer = path.lookaheadBuffer;
+        auto& oversampling = path.oversampler;
 
         float ceilingLinear = DSPUtils::decibelsToLinear(ceiling);
         float maxGR = 0.0f;
 
         // Create audio block for oversampling
-        juce::dsp::AudioBlock<float> inputBlock(buffer);
+        auto inputBlock = juce::dsp::AudioBlock<SampleType>(buffer).getSubsetChannelBlock(0, static_cast<size_t>(numChannels));
 
         // Upsample for true peak detection
-        auto oversampledBlock = oversampling->processSamplesUp(inputBlock);
+        auto oversampledBlock = oversampling.processSamplesUp(inputBlock);
 
         // Find true peaks in oversampled domain
         const size_t osNumSamples = oversampledBlock.getNumSamples();
         const int osFactor = static_cast<int>(osNumSamples) / numSamples;
 
-        // Temporary storage for per-sample true peaks
-        std::vector<float> truePeaks(numSamples, 0.0f);
-
         for (int i = 0; i < numSamples; ++i)
         {
             float maxPeak = 0.0f;
@@ -106,7 +126,7 @@ public:
                 int osIndex = i * osFactor + os;
                 for (int ch = 0; ch < numChannels; ++ch)
                 {
-                    float absVal = std::abs(oversampledBlock.getSample(ch, osIndex));
+                    float absVal = static_cast<float>(std::abs(oversampledBlock.getSample(ch, osIndex)));
                     maxPeak = std::max(maxPeak, absVal);
                 }
             }
@@ -114,21 +134,16 @@ public:
         }
 
         // Downsample (we only needed the sidechain analysis)
-        oversampling->processSamplesDown(inputBlock);
+        oversampling.processSamplesDown(inputBlock);
+
+        DSPUtils::ChannelFrame<SampleType> delayed;
 
         for (int sample = 0; sample < numSamples; ++sample)
         {
-            // Read from lookahead buffer
-            float delayedL = lookaheadBufferL[lookaheadIndex];
-            float delayedR = numChannels > 1 ? lookaheadBufferR[lookaheadIndex] : delayedL;
-
-            // Write current samples to lookahead buffer
-            float inputL = buffer.getSample(0, sample);
-            float inputR = numChannels > 1 ? buffer.getSample(1, sample) : inputL;
-
-            lookaheadBufferL[lookaheadIndex] = inputL;
-            if (numChannels > 1)
-                lookaheadBufferR[lookaheadIndex] = inputR;
+            // Read from lookahead buffer, then write the current frame in its place
+            auto& slot = lookaheadBuffer[lookaheadIndex];
+            delayed = slot;
+            DSPUtils::readFrame(channels, numChannels, sample, slot);
 
             // Use true peak from oversampled detection
             // IMPORTANT: Factor in auto-gain so limiter knows what the OUTPUT level will be
@@ -175,19 +190,12 @@ public:
 
             lookaheadIndex = (lookaheadIndex + 1) % lookaheadSamples;
 
-            // Apply gain reduction to delayed signal
-            delayedL *= smoothedGain;
-            delayedR *= smoothedGain;
-
-            // Apply output gain if targeting LUFS
-            if (autoGainEnabled)
-            {
-                delayedL *= autoGainLinear;
-                delayedR *= autoGainLinear;
-            }
+            // Apply gain reduction to delayed signal, plus output gain if targeting LUFS
+            // (linked across channels: every channel gets the same gain)
+            delayed.multiply(static_cast<SampleType>(autoGainEnabled ? smoothedGain * autoGainLinear : smoothedGain), numChannels);
 
             // DIAGNOSTIC: Track pre-soft-clip levels
-            float preSoftClipMax = std::max(std::abs(delayedL), std::abs(delayedR));
+            float preSoftClipMax = static_cast<float>(delayed.getMaxAbs(numChannels));
             diag.maxPreSoftClipLevel = std::max(diag.maxPreSoftClipLevel, preSoftClipMax);
 
             // Check if soft clip will engage (above knee)
@@ -195,24 +203,22 @@ public:
             if (preSoftClipMax > knee)
             {
                 diag.softClipEngagements++;
-            }
 
-            // SOFT CLIP safety (tanh-based) instead of hard clip
-            // This catches any remaining peaks musically
-            delayedL = softClipOutput(delayedL, ceilingLinear);
-            delayedR = softClipOutput(delayedR, ceilingLinear);
+                // SOFT CLIP safety (tanh-based) instead of hard clip
+                // This catches any remaining peaks musically
+                for (int ch = 0; ch < numChannels; ++ch)
+                    delayed[ch] = softClipOutput(delayed[ch], static_cast<SampleType>(ceilingLinear));
+            }
 
             // DIAGNOSTIC: Track output levels
-            float outputMax = std::max(std::abs(delayedL), std::abs(delayedR));
+            float outputMax = static_cast<float>(delayed.getMaxAbs(numChannels));
             diag.maxOutputLevel = std::max(diag.maxOutputLevel, outputMax);
             diag.totalSamples++;
 
             if (outputMax > 1.0f)
                 diag.samplesExceeding1++;
 
-            buffer.setSample(0, sample, delayedL);
-            if (numChannels > 1)
-                buffer.setSample(1, sample, delayedR);
+            DSPUtils::writeFrame(channels, numChannels, sample, delayed);
 
             // Track gain reduction for metering
             float grDB = DSPUtils::linearToDecibels(smoothedGain);
@@ -280,38 +286,43 @@ public:
     float getCeiling() const { return ceiling; }
     float getRelease() const { return releaseTime; }
     float getTargetLUFS() const { return targetLUFS; }
+    float getAutoGainValue() const { return autoGainDB; }
+    bool isAutoGainEnabled() const { return autoGainEnabled; }
 
     // Latency for host compensation (lookahead + oversampling filter)
     int getLatencySamples() const
     {
-        int osLatency = oversampling ? static_cast<int>(oversampling->getLatencyInSamples()) : 0;
+        int osLatency = currentPrecision == juce::AudioProcessor::doublePrecision
+                            ? signalPaths.doubleVersion.getLatencySamples()
+                            : signalPaths.floatVersion.getLatencySamples();
         return lookaheadSamples + osLatency;
     }
 
 private:
     // Soft clip using tanh - musical saturation instead of harsh digital clip
     // This version has NO discontinuity - starts engaging at knee and smoothly approaches ceiling
-    float softClipOutput(float input, float ceiling)
+    template <typename SampleType>
+    static SampleType softClipOutput(SampleType input, SampleType ceiling)
     {
-        float absInput = std::abs(input);
+        SampleType absInput = std::abs(input);
 
         // Knee at 95% of ceiling - only engage for actual emergencies
         // (Was 80%, which caused audible saturation on peaks that were already within limits)
-        float knee = ceiling * 0.95f;
+        SampleType knee = ceiling * SampleType(0.95);
 
         // If below knee, pass through unchanged (linear region)
         if (absInput <= knee)
             return input;
 
-        float sign = input > 0.0f ? 1.0f : -1.0f;
+        SampleType sign = input > SampleType(0) ? SampleType(1) : SampleType(-1);
 
         // Soft region is from knee to ceiling (and beyond)
-        float softRegion = ceiling - knee;  // 0.2 * ceiling
-        float excess = absInput - knee;
+        SampleType softRegion = ceiling - knee;  // 0.2 * ceiling
+        SampleType excess = absInput - knee;
 
         // tanh maps 0->0 and infinity->1
         // So knee + softRegion * tanh(excess/softRegion) approaches knee + softRegion = ceiling
-        float clipped = knee + softRegion * std::tanh(excess / softRegion);
+        SampleType clipped = knee + softRegion * std::tanh(excess / softRegion);
 
         return sign * clipped;
     }
@@ -340,6 +351,8 @@ private:
 
     double currentSampleRate = 44100.0;
     int currentBlockSize = 512;
+    int currentNumChannels = 2;
+    juce::AudioProcessor::ProcessingPrecision currentPrecision = juce::AudioProcessor::singlePrecision;
     bool bypassed = false;
 
     // Limiter settings
@@ -351,7 +364,8 @@ private:
     float autoGainLinear = 1.0f;
     bool truePeakEnabled = true;
 
-    // Processing state - program-dependent dual envelope
+    // Per-sample state, packed together: dual envelope, gain smoothing and
+    // the lookahead position all touch the same cache lines every sample
     float fastReleaseCoeff = 0.0f;
     float slowAttackCoeff = 0.0f;
     float slowReleaseCoeff = 0.0f;
@@ -360,24 +374,59 @@ private:
     float fastEnvelope = 1.0f;
     float slowEnvelope = 1.0f;
     float smoothedGain = 1.0f;
-
-    // Lookahead buffer
-    std::vector<float> lookaheadBufferL;
-    std::vector<float> lookaheadBufferR;
-    std::vector<float> gainBuffer;
     int lookaheadSamples = 0;
     int lookaheadIndex = 0;
 
-    // 4x oversampling for true peak detection
-    std::unique_ptr<juce::dsp::Oversampling<float>> oversampling;
+    // Lookahead gain history and per-block true peaks (arena memory, shared
+    // by both sample types since only one runs at a time)
+    DSPUtils::StateArray<float> gainBuffer;
+    DSPUtils::StateArray<float> truePeaks;
 
-    // Metering
-    std::atomic<float> gainReduction { 0.0f };
+    // Audio delay line and true-peak oversampler for one sample type
+    template <typename SampleType>
+    struct SignalPath
+    {
+        // One frame of all channels per lookahead sample (arena memory)
+        DSPUtils::StateArray<DSPUtils::ChannelFrame<SampleType>> lookaheadBuffer;
+
+        // 4x oversampling for true peak detection (ITU-R BS.1770 compliant);
+        // FIR designs are shared process-wide, see Oversampler.h
+        Oversampler<SampleType> oversampler;
+
+        void prepare(int numChannels, int samplesPerBlock)
+        {
+            oversampler.prepare(numChannels, samplesPerBlock);
+        }
+
+        void release()
+        {
+            lookaheadBuffer = {};
+            oversampler.releaseState();
+        }
+
+        void reset()
+        {
+            for (auto& frame : lookaheadBuffer)
+                frame.clear();
+
+            oversampler.reset();
+        }
+
+        int getLatencySamples() const
+        {
+            return static_cast<int>(oversampler.getLatencyInSamples());
+        }
+    };
+
+    DSPUtils::PerSampleType<SignalPath> signalPaths;
 
     // Diagnostics
     Diagnostics diag;
     int diagBlockCount = 0;
 
+    // Metering (own cache line: written by the audio thread, polled by the UI)
+    alignas(DSPUtils::CACHE_LINE_SIZE) std::atomic<float> gainReduction { 0.0f };
+
     void logDiagnostics()
     {
         // Write to log file in user's home directory
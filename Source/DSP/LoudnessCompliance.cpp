@@ -0,0 +1,3 @@
+// LoudnessCompliance implementation
+// All functionality is in the header file
+#include "LoudnessCompliance.h"
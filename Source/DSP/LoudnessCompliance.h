@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Delivery loudness specs checked against one LoudnessMeter's program
+// statistics. The meter measures everything in its single K-weighted pass;
+// this only compares the numbers, so one render yields the report for
+// every deliverable.
+namespace LoudnessCompliance
+{
+    // True-peak ceilings the meter counts overs against (dBTP)
+    constexpr std::array<float, 3> OVER_THRESHOLDS { 0.0f, -1.0f, -2.0f };
+
+    // Everything the meter measured since the last program reset
+    struct Statistics
+    {
+        float integratedLUFS = -100.0f;  // BS.1770-4, gated 400 ms blocks
+        float loudnessRange = 0.0f;      // EBU Tech 3342
+        float maxMomentaryLUFS = -100.0f;
+        float maxShortTermLUFS = -100.0f;
+        float maxTruePeak = -100.0f;     // dBTP
+        std::array<uint32_t, OVER_THRESHOLDS.size()> truePeakOvers {};  // Excursions above each threshold
+        double measuredSeconds = 0.0;
+    };
+
+    enum class Standard
+    {
+        EBUR128,
+        ATSCA85,
+        AESStreaming,
+        Spotify,
+        AppleMusic,
+        YouTube,
+        NumStandards
+    };
+
+    constexpr int NUM_STANDARDS = static_cast<int>(Standard::NumStandards);
+
+    struct Spec
+    {
+        const char* name;
+        float targetLUFS;
+        float tolerance;      // LU either side of the target
+        float maxTruePeak;    // dBTP
+        bool normalizes;      // A platform that turns the track up or down rather than rejecting it
+    };
+
+    // Platform targets follow the README table
+    inline const Spec& getSpec(Standard standard)
+    {
+        static const std::array<Spec, NUM_STANDARDS> specs {{
+            { "EBU R128",       -23.0f, 0.5f, -1.0f, false },
+            { "ATSC A/85",      -24.0f, 2.0f, -2.0f, false },
+            { "AES streaming",  -18.0f, 2.0f, -1.0f, false },
+            { "Spotify",        -14.0f, 1.0f, -1.0f, true },
+            { "Apple Music",    -16.0f, 1.0f, -1.0f, true },
+            { "YouTube",        -14.0f, 1.0f, -1.0f, true }
+        }};
+
+        return specs[static_cast<size_t>(standard)];
+    }
+
+    struct Result
+    {
+        float loudnessDelta = 0.0f;       // Integrated minus target (LU)
+        float normalizationGain = 0.0f;   // What a normalizing platform applies (dB)
+        float truePeakAfterGain = -100.0f;
+        bool loudnessPasses = false;
+        bool truePeakPasses = false;
+
+        bool passes() const { return loudnessPasses && truePeakPasses; }
+    };
+
+    struct Report
+    {
+        Statistics statistics;
+        std::array<Result, NUM_STANDARDS> results {};
+        bool hasProgram = false;  // Something above the gate was measured
+
+        const Result& get(Standard standard) const { return results[static_cast<size_t>(standard)]; }
+
+        std::string toText() const
+        {
+            char line[160];
+            std::string text;
+
+            std::snprintf(line, sizeof(line), "Integrated %.1f LUFS, LRA %.1f LU, max momentary %.1f, max short-term %.1f, true peak %.1f dBTP (%.0f s)\n",
+                          statistics.integratedLUFS, statistics.loudnessRange, statistics.maxMomentaryLUFS,
+                          statistics.maxShortTermLUFS, statistics.maxTruePeak, statistics.measuredSeconds);
+            text += line;
+
+            std::snprintf(line, sizeof(line), "True-peak overs: %u above 0, %u above -1, %u above -2 dBTP\n",
+                          statistics.truePeakOvers[0], statistics.truePeakOvers[1], statistics.truePeakOvers[2]);
+            text += line;
+
+            for (int i = 0; i < NUM_STANDARDS; ++i)
+            {
+                const Spec& spec = getSpec(static_cast<Standard>(i));
+                const Result& result = results[static_cast<size_t>(i)];
+
+                if (spec.normalizes)
+                    std::snprintf(line, sizeof(line), "%-14s %s  %+.1f LU, plays at %+.1f dB, peaks %.1f dBTP\n", spec.name,
+                                  result.passes() ? "PASS" : "FAIL", result.loudnessDelta, result.normalizationGain, result.truePeakAfterGain);
+                else
+                    std::snprintf(line, sizeof(line), "%-14s %s  %+.1f LU (%.0f +/- %.1f), true peak %s %.0f dBTP\n", spec.name,
+                                  result.passes() ? "PASS" : "FAIL", result.loudnessDelta, spec.targetLUFS, spec.tolerance,
+                                  result.truePeakPasses ? "within" : "over", spec.maxTruePeak);
+                text += line;
+            }
+
+            return text;
+        }
+    };
+
+    inline Report createReport(const Statistics& statistics)
+    {
+        Report report;
+        report.statistics = statistics;
+        report.hasProgram = statistics.integratedLUFS > -70.0f;
+
+        if (!report.hasProgram)
+            return report;
+
+        for (int i = 0; i < NUM_STANDARDS; ++i)
+        {
+            const Spec& spec = getSpec(static_cast<Standard>(i));
+            Result& result = report.results[static_cast<size_t>(i)];
+
+            result.loudnessDelta = statistics.integratedLUFS - spec.targetLUFS;
+            result.loudnessPasses = std::abs(result.loudnessDelta) <= spec.tolerance;
+            result.truePeakPasses = statistics.maxTruePeak <= spec.maxTruePeak;
+
+            // Normalizing platforms move the track to the target, so what
+            // matters is the peak once they have
+            result.normalizationGain = spec.normalizes ? -result.loudnessDelta : 0.0f;
+            result.truePeakAfterGain = statistics.maxTruePeak + result.normalizationGain;
+
+            if (spec.normalizes)
+                result.truePeakPasses = result.truePeakAfterGain <= spec.maxTruePeak;
+        }
+
+        return report;
+    }
+}
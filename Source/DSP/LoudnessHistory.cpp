@@ -0,0 +1,3 @@
+// LoudnessHistory implementation
+// All functionality is in the header file
+#include "LoudnessHistory.h"
@@ -0,0 +1,245 @@
+#pragma once
+
+#include "DSPUtils.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Loudness and true-peak history for scrolling over-time graphs, kept as a
+// pyramid like a waveform overview.
+//
+// Level 0 holds one entry per 100 ms LoudnessMeter block. Each level above
+// summarises LEVEL_FACTOR entries of the one below (min, max and mean
+// momentary and short-term loudness, max true peak). Every level is a fixed
+// ring of LEVEL_CAPACITY entries, so memory never grows: level 0 keeps the
+// last 13.6 minutes at full resolution and the top level (4^5 = 1024 blocks,
+// 102.4 s per entry) about 9.7 days, about 1.4 MB in all.
+//
+// The audio thread appends in amortised O(1). getRange() fills one entry
+// per pixel from whichever level is closest to the pixel width, so a
+// repaint costs O(pixels) at any zoom, however long the session.
+class LoudnessHistory
+{
+public:
+    static constexpr int NUM_LEVELS = 6;
+    static constexpr int LEVEL_FACTOR = 4;
+    static constexpr int LEVEL_CAPACITY = 1 << 13;
+    static constexpr double BLOCK_SECONDS = 0.1;
+
+    struct Entry
+    {
+        float momentaryMin = 1000.0f;
+        float momentaryMax = -1000.0f;
+        float momentaryMean = -100.0f;
+        float shortTermMin = 1000.0f;
+        float shortTermMax = -1000.0f;
+        float shortTermMean = -100.0f;
+        float truePeakMax = -100.0f;
+
+        // False for pixels outside the recorded history
+        bool hasData() const { return momentaryMax >= momentaryMin; }
+    };
+
+    LoudnessHistory()
+    {
+        for (auto& level : levels)
+            level.entries.resize(LEVEL_CAPACITY);
+    }
+
+    // Clears the history at the next push (any thread)
+    void requestReset() { resetRequested.store(true); }
+
+    // Audio thread, once per 100 ms block; levels in dB
+    void push(float momentaryLUFS, float shortTermLUFS, float truePeakDB)
+    {
+        if (resetRequested.exchange(false))
+            clear();
+
+        Entry entry;
+        entry.momentaryMin = entry.momentaryMax = entry.momentaryMean = momentaryLUFS;
+        entry.shortTermMin = entry.shortTermMax = entry.shortTermMean = shortTermLUFS;
+        entry.truePeakMax = truePeakDB;
+
+        // Each completed group carries up to the next level
+        for (int index = 0; index < NUM_LEVELS; ++index)
+        {
+            Level& level = levels[static_cast<size_t>(index)];
+            append(level, entry);
+
+            if (index + 1 == NUM_LEVELS)
+                break;
+
+            merge(level.pending, entry, level.pendingCount);
+            if (++level.pendingCount < LEVEL_FACTOR)
+                break;
+
+            entry = level.pending;
+            level.pending = Entry {};
+            level.pendingCount = 0;
+        }
+    }
+
+    // Blocks pushed since the last reset
+    int64_t getNumBlocks() const { return levels[0].count.load(std::memory_order_acquire); }
+    double getDurationSeconds() const { return static_cast<double>(getNumBlocks()) * BLOCK_SECONDS; }
+
+    // Seconds since the last reset of the oldest audio still in the history
+    double getOldestSeconds() const
+    {
+        const Level& top = levels[NUM_LEVELS - 1];
+        return static_cast<double>(getOldestIntact(top) * getBlocksPerEntry(NUM_LEVELS - 1)) * BLOCK_SECONDS;
+    }
+
+    // One entry per pixel across [startSeconds, endSeconds), in seconds of
+    // metered audio since the last reset. Pixels with nothing recorded
+    // come back without data. Any thread.
+    void getRange(double startSeconds, double endSeconds, Entry* dest, int numPixels) const
+    {
+        if (numPixels <= 0)
+            return;
+
+        const double pixelBlocks = (endSeconds - startSeconds) / BLOCK_SECONDS / numPixels;
+
+        // The coarsest level whose entries are no wider than a pixel
+        int level = 0;
+        while (level + 1 < NUM_LEVELS && getBlocksPerEntry(level + 1) <= pixelBlocks)
+            ++level;
+
+        for (int pixel = 0; pixel < numPixels; ++pixel)
+        {
+            const double pixelStart = startSeconds / BLOCK_SECONDS + pixel * pixelBlocks;
+            const int64_t firstBlock = static_cast<int64_t>(std::floor(pixelStart));
+            const int64_t endBlock = std::max(firstBlock + 1, static_cast<int64_t>(std::floor(pixelStart + pixelBlocks)));
+
+            Summary summary;
+            summarise(level, firstBlock, endBlock, summary, 0);
+            dest[pixel] = summary.finish();
+        }
+    }
+
+private:
+    struct Level
+    {
+        std::vector<Entry> entries;
+        std::atomic<int64_t> count { 0 };  // Entries appended since the last reset
+
+        // Audio thread: the group being built for the level above
+        Entry pending;
+        int pendingCount = 0;
+    };
+
+    static int64_t getBlocksPerEntry(int level)
+    {
+        int64_t blocks = 1;
+        for (int i = 0; i < level; ++i)
+            blocks *= LEVEL_FACTOR;
+        return blocks;
+    }
+
+    // Oldest entry a reader can trust; the slack covers entries overwritten
+    // while a query runs
+    static int64_t getOldestIntact(const Level& level)
+    {
+        constexpr int64_t slack = 16;
+        return std::max(int64_t { 0 }, level.count.load(std::memory_order_acquire) - LEVEL_CAPACITY + slack);
+    }
+
+    void clear()
+    {
+        for (auto& level : levels)
+        {
+            level.count.store(0, std::memory_order_release);
+            level.pending = Entry {};
+            level.pendingCount = 0;
+        }
+    }
+
+    static void append(Level& level, const Entry& entry)
+    {
+        const int64_t count = level.count.load(std::memory_order_relaxed);
+        level.entries[static_cast<size_t>(count & (LEVEL_CAPACITY - 1))] = entry;
+        level.count.store(count + 1, std::memory_order_release);
+    }
+
+    // Folds source into target, which already summarises targetCount entries
+    // of the same width (the mean is only right for equal widths)
+    static void merge(Entry& target, const Entry& source, int targetCount)
+    {
+        const float weight = 1.0f / static_cast<float>(targetCount + 1);
+
+        target.momentaryMin = std::min(target.momentaryMin, source.momentaryMin);
+        target.momentaryMax = std::max(target.momentaryMax, source.momentaryMax);
+        target.shortTermMin = std::min(target.shortTermMin, source.shortTermMin);
+        target.shortTermMax = std::max(target.shortTermMax, source.shortTermMax);
+        target.truePeakMax = std::max(target.truePeakMax, source.truePeakMax);
+
+        if (targetCount == 0)
+        {
+            target.momentaryMean = source.momentaryMean;
+            target.shortTermMean = source.shortTermMean;
+        }
+        else
+        {
+            target.momentaryMean += (source.momentaryMean - target.momentaryMean) * weight;
+            target.shortTermMean += (source.shortTermMean - target.shortTermMean) * weight;
+        }
+    }
+
+    // A pixel being built from entries of any width
+    struct Summary
+    {
+        Entry entry;
+        double momentarySum = 0.0;
+        double shortTermSum = 0.0;
+        double blocks = 0.0;
+
+        void add(const Entry& source, int64_t blocksPerEntry)
+        {
+            const double weight = static_cast<double>(blocksPerEntry);
+            merge(entry, source, blocks > 0.0 ? 1 : 0);
+            momentarySum += source.momentaryMean * weight;
+            shortTermSum += source.shortTermMean * weight;
+            blocks += weight;
+        }
+
+        Entry finish() const
+        {
+            Entry result = entry;
+            if (blocks > 0.0)
+            {
+                result.momentaryMean = static_cast<float>(momentarySum / blocks);
+                result.shortTermMean = static_cast<float>(shortTermSum / blocks);
+            }
+            return result;
+        }
+    };
+
+    // Adds the entries of one level covering blocks [firstBlock, endBlock).
+    // A level lags the one below by up to a group and forgets sooner than
+    // the one above, so the newest part comes from finer levels (direction
+    // -1) and the oldest from coarser ones (+1).
+    void summarise(int index, int64_t firstBlock, int64_t endBlock, Summary& summary, int direction) const
+    {
+        const Level& level = levels[static_cast<size_t>(index)];
+        const int64_t blocksPerEntry = getBlocksPerEntry(index);
+
+        const int64_t oldest = getOldestIntact(level);
+        const int64_t newest = level.count.load(std::memory_order_acquire);
+
+        if (direction >= 0 && index + 1 < NUM_LEVELS && firstBlock < oldest * blocksPerEntry)
+            summarise(index + 1, firstBlock, std::min(endBlock, oldest * blocksPerEntry), summary, 1);
+
+        const int64_t firstEntry = std::max(oldest, firstBlock / blocksPerEntry);
+        const int64_t endEntry = std::min(newest, (endBlock + blocksPerEntry - 1) / blocksPerEntry);
+
+        for (int64_t e = firstEntry; e < endEntry; ++e)
+            summary.add(level.entries[static_cast<size_t>(e & (LEVEL_CAPACITY - 1))], blocksPerEntry);
+
+        if (direction <= 0 && index > 0 && endBlock > newest * blocksPerEntry)
+            summarise(index - 1, std::max(firstBlock, newest * blocksPerEntry), endBlock, summary, -1);
+    }
+
+    std::array<Level, NUM_LEVELS> levels;
+    std::atomic<bool> resetRequested { false };
+};
@@ -1,37 +1,61 @@
 #pragma once
 
 #include "DSPUtils.h"
-#include <deque>
-#include <numeric>
+#include "LoudnessHistory.h"
+#include "LoudnessCompliance.h"
 
 class LoudnessMeter
 {
 public:
-    LoudnessMeter() = default;
+    LoudnessMeter()
+    {
+        channelWeights.fill(1.0f);
+
+        for (size_t i = 0; i < overThresholds.size(); ++i)
+            overThresholds[i] = DSPUtils::decibelsToLinear(LoudnessCompliance::OVER_THRESHOLDS[i]);
+    }
 
-    void prepare(double sampleRate, int samplesPerBlock)
+    void prepare(double sampleRate, int samplesPerBlock,
+                 const juce::AudioChannelSet& layout = juce::AudioChannelSet::stereo())
     {
         currentSampleRate = sampleRate;
         currentBlockSize = samplesPerBlock;
 
         // K-weighting filter coefficients (ITU-R BS.1770-4)
         setupKWeightingFilters(sampleRate);
+        setChannelLayout(layout);
 
-        // True peak detector
-        truePeakDetectorL.prepare(sampleRate);
-        truePeakDetectorR.prepare(sampleRate);
+        // True peak detectors
+        for (auto& detector : truePeakDetectors)
+            detector.prepare(sampleRate);
+        overGapSamples = std::max(1, static_cast<int>(sampleRate * OVER_GAP_SECONDS));
 
         reset();
     }
 
+    // BS.1770-4 channel weights: 1.41 for side/surround channels at +-60..120 degrees,
+    // 0 for LFE, 1.0 for everything else (front, rear and height channels)
+    void setChannelLayout(const juce::AudioChannelSet& layout)
+    {
+        channelWeights.fill(1.0f);
+
+        const int numChannels = std::min(layout.size(), DSPUtils::MAX_CHANNELS);
+        for (int ch = 0; ch < numChannels; ++ch)
+            channelWeights[static_cast<size_t>(ch)] = getChannelWeight(layout.getTypeOfChannel(ch));
+    }
+
+    // Records every 100 ms block into the given history (null to stop).
+    // Set while audio is stopped; the history outlives reset().
+    void setHistory(LoudnessHistory* newHistory)
+    {
+        history = newHistory;
+    }
+
     void reset()
     {
         // Reset K-weighting filter states
-        for (int ch = 0; ch < 2; ++ch)
-        {
-            kWeightState1[ch].reset();
-            kWeightState2[ch].reset();
-        }
+        kWeightState1.reset();
+        kWeightState2.reset();
 
         // Reset metering values
         momentaryLUFS.store(MINUS_INFINITY);
@@ -42,107 +66,109 @@ public:
         peakLevelR.store(MINUS_INFINITY);
         truePeakL.store(MINUS_INFINITY);
         truePeakR.store(MINUS_INFINITY);
+        maxTruePeak.store(MINUS_INFINITY);
 
         // Clear buffers
-        momentaryBuffer.clear();
-        shortTermBuffer.clear();
-        integratedBlocks.clear();
+        recentBlocks.fill(0.0f);
+        recentBlockIndex = 0;
+        recentBlockCount = 0;
+        clearProgram();
 
-        truePeakDetectorL.reset();
-        truePeakDetectorR.reset();
+        for (auto& detector : truePeakDetectors)
+            detector.reset();
 
         blockSampleCount = 0;
-        currentBlockPower = 0.0f;
+        blockTruePeak = 0.0f;
+        channelBlockPower.clear();
     }
 
-    void process(juce::AudioBuffer<float>& buffer)
+    // Metering runs in float whatever the host precision; double input is
+    // rounded as it is read into the frame
+    template <typename SampleType>
+    void process(const juce::AudioBuffer<SampleType>& buffer)
     {
         const int numSamples = buffer.getNumSamples();
-        const int numChannels = std::min(buffer.getNumChannels(), 2);
+        const int numChannels = std::min(buffer.getNumChannels(), DSPUtils::MAX_CHANNELS);
 
         if (numChannels < 1)
             return;
 
+        const auto* const* channels = buffer.getArrayOfReadPointers();
+        const int samplesPer100ms = static_cast<int>(currentSampleRate * 0.1);
+
+        if (programResetRequested.exchange(false))
+            clearProgram();
+
         // Process peak levels
-        float peakL = 0.0f, peakR = 0.0f;
-        float truePeakLVal = 0.0f, truePeakRVal = 0.0f;
+        DSPUtils::ChannelFrame<float> frame, peaks, truePeaks;
 
         for (int sample = 0; sample < numSamples; ++sample)
         {
-            float left = buffer.getSample(0, sample);
-            float right = numChannels > 1 ? buffer.getSample(1, sample) : left;
-
-            // Sample peak
-            peakL = std::max(peakL, std::abs(left));
-            peakR = std::max(peakR, std::abs(right));
-
-            // True peak with oversampling
-            truePeakLVal = std::max(truePeakLVal, truePeakDetectorL.process(left));
-            truePeakRVal = std::max(truePeakRVal, truePeakDetectorR.process(right));
-
-            // K-weighted filtering for loudness
-            float kWeightedL = processKWeighting(left, 0);
-            float kWeightedR = processKWeighting(right, 1);
+            DSPUtils::readFrame(channels, numChannels, sample, frame);
+            float sampleTruePeak = 0.0f;
 
-            // Accumulate power for current 100ms block
-            currentBlockPower += kWeightedL * kWeightedL + kWeightedR * kWeightedR;
-            blockSampleCount++;
-
-            // Check if we've completed a 100ms block
-            int samplesPerBlock = static_cast<int>(currentSampleRate * 0.1);
-            if (blockSampleCount >= samplesPerBlock)
+            for (int ch = 0; ch < numChannels; ++ch)
             {
-                float meanSquare = currentBlockPower / (2.0f * blockSampleCount);
-                float blockLoudness = -0.691f + 10.0f * std::log10(std::max(meanSquare, 1e-10f));
+                // Sample peak
+                peaks[ch] = std::max(peaks[ch], std::abs(frame[ch]));
 
-                // Add to windowed buffers
-                momentaryBuffer.push_back(meanSquare);
-                shortTermBuffer.push_back(meanSquare);
-
-                // Keep 4 blocks for momentary (400ms)
-                while (momentaryBuffer.size() > 4)
-                    momentaryBuffer.pop_front();
-
-                // Keep 30 blocks for short-term (3s)
-                while (shortTermBuffer.size() > 30)
-                    shortTermBuffer.pop_front();
+                // True peak with oversampling
+                auto& detector = truePeakDetectors[static_cast<size_t>(ch)];
+                truePeaks[ch] = std::max(truePeaks[ch], detector.process(frame[ch]));
+                sampleTruePeak = std::max(sampleTruePeak, detector.getSamplePeak());
+            }
 
-                // Calculate momentary loudness
-                if (!momentaryBuffer.empty())
+            // An over is one excursion above a threshold, however long;
+            // dips shorter than OVER_GAP_SECONDS don't end it
+            for (size_t i = 0; i < overThresholds.size(); ++i)
+            {
+                if (sampleTruePeak > overThresholds[i])
                 {
-                    float momMean = std::accumulate(momentaryBuffer.begin(), momentaryBuffer.end(), 0.0f)
-                                    / momentaryBuffer.size();
-                    float momLUFS = -0.691f + 10.0f * std::log10(std::max(momMean, 1e-10f));
-                    momentaryLUFS.store(momLUFS);
+                    if (overHoldRemaining[i] == 0)
+                        ++program.truePeakOvers[i];
+                    overHoldRemaining[i] = overGapSamples;
                 }
-
-                // Calculate short-term loudness
-                if (!shortTermBuffer.empty())
+                else if (overHoldRemaining[i] > 0)
                 {
-                    float stMean = std::accumulate(shortTermBuffer.begin(), shortTermBuffer.end(), 0.0f)
-                                   / shortTermBuffer.size();
-                    float stLUFS = -0.691f + 10.0f * std::log10(std::max(stMean, 1e-10f));
-                    shortTermLUFS.store(stLUFS);
+                    --overHoldRemaining[i];
                 }
+            }
 
-                // Integrated loudness with gating
-                if (blockLoudness > ABSOLUTE_GATE)
-                {
-                    integratedBlocks.push_back(meanSquare);
-                    updateIntegratedLoudness();
-                }
+            blockTruePeak = std::max(blockTruePeak, sampleTruePeak);
+
+            // K-weighted filtering for loudness (all channels in parallel)
+            kWeightState1.process(frame, numChannels, kWeight1Coeffs);
+            kWeightState2.process(frame, numChannels, kWeight2Coeffs);
+
+            // Accumulate per-channel power for current 100ms block
+            for (int ch = 0; ch < numChannels; ++ch)
+                channelBlockPower[ch] += frame[ch] * frame[ch];
+            blockSampleCount++;
+
+            // Check if we've completed a 100ms block
+            if (blockSampleCount >= samplesPer100ms)
+            {
+                // Weighted channel sum (BS.1770): sum of G_i * mean square of channel i
+                float weightedPower = 0.0f;
+                for (int ch = 0; ch < numChannels; ++ch)
+                    weightedPower += channelWeights[static_cast<size_t>(ch)] * channelBlockPower[ch];
+
+                float meanSquare = weightedPower / static_cast<float>(blockSampleCount);
+                addLoudnessBlock(meanSquare);
 
                 // Reset block accumulators
-                currentBlockPower = 0.0f;
+                channelBlockPower.clear();
                 blockSampleCount = 0;
             }
         }
 
-        // Store peak values
-        peakLevelL.store(DSPUtils::linearToDecibels(peakL));
-        peakLevelR.store(DSPUtils::linearToDecibels(peakR));
-        truePeakL.store(DSPUtils::linearToDecibels(truePeakLVal));
-        truePeakR.store(DSPUtils::linearToDecibels(truePeakRVal));
+        // Store peak values (L/R are the first two channels; mono reports the same for both)
+        const int rightChannel = numChannels > 1 ? 1 : 0;
+        peakLevelL.store(DSPUtils::linearToDecibels(peaks[0]));
+        peakLevelR.store(DSPUtils::linearToDecibels(peaks[rightChannel]));
+        truePeakL.store(DSPUtils::linearToDecibels(truePeaks[0]));
+        truePeakR.store(DSPUtils::linearToDecibels(truePeaks[rightChannel]));
+        maxTruePeak.store(DSPUtils::linearToDecibels(truePeaks.getMaxAbs(numChannels)));
     }
 
     // Getters for metering values
@@ -154,21 +180,28 @@ public:
     float getPeakLevelR() const { return peakLevelR.load(); }
     float getTruePeakL() const { return truePeakL.load(); }
     float getTruePeakR() const { return truePeakR.load(); }
-    float getMaxTruePeak() const { return std::max(truePeakL.load(), truePeakR.load()); }
+    float getMaxTruePeak() const { return maxTruePeak.load(); }
+
+    // Program statistics (integrated, LRA, maxima, overs) as of the last
+    // 100ms block; any thread
+    LoudnessCompliance::Statistics getStatistics() const { return publishedStatistics.read(); }
+
+    LoudnessCompliance::Report getComplianceReport() const
+    {
+        return LoudnessCompliance::createReport(getStatistics());
+    }
 
+    // Starts a new program: integrated loudness, LRA, maxima and overs.
+    // Takes effect at the next processed block.
     void resetIntegratedLoudness()
     {
-        integratedBlocks.clear();
+        programResetRequested.store(true);
         integratedLUFS.store(MINUS_INFINITY);
         loudnessRange.store(0.0f);
     }
 
-private:
-    static constexpr float MINUS_INFINITY = -100.0f;
-    static constexpr float ABSOLUTE_GATE = -70.0f;  // LUFS
-    static constexpr float RELATIVE_GATE = -10.0f;  // dB below ungated loudness
-
-    void setupKWeightingFilters(double sampleRate)
+    // The two BS.1770 K-weighting stages, for callers that filter on their own
+    static void designKWeighting(double sampleRate, DSPUtils::BiquadCoeffs& shelf, DSPUtils::BiquadCoeffs& highPass)
     {
         // Stage 1: High shelf (pre-filter)
         // +4dB shelving at high frequencies
@@ -181,11 +214,11 @@ private:
         float Vb = std::pow(Vh, 0.4996667741545416f);
 
         float a0 = 1.0f + K / Q + K * K;
-        kWeight1Coeffs.b0 = (Vh + Vb * K / Q + K * K) / a0;
-        kWeight1Coeffs.b1 = 2.0f * (K * K - Vh) / a0;
-        kWeight1Coeffs.b2 = (Vh - Vb * K / Q + K * K) / a0;
-        kWeight1Coeffs.a1 = 2.0f * (K * K - 1.0f) / a0;
-        kWeight1Coeffs.a2 = (1.0f - K / Q + K * K) / a0;
+        shelf.b0 = (Vh + Vb * K / Q + K * K) / a0;
+        shelf.b1 = 2.0f * (K * K - Vh) / a0;
+        shelf.b2 = (Vh - Vb * K / Q + K * K) / a0;
+        shelf.a1 = 2.0f * (K * K - 1.0f) / a0;
+        shelf.a2 = (1.0f - K / Q + K * K) / a0;
 
         // Stage 2: High-pass (RLB weighting)
         float f1 = 38.13547087602444f;
@@ -194,88 +227,250 @@ private:
         float K1 = std::tan(DSPUtils::PI * f1 / static_cast<float>(sampleRate));
         float a0_2 = 1.0f + K1 / Q1 + K1 * K1;
 
-        kWeight2Coeffs.b0 = 1.0f / a0_2;
-        kWeight2Coeffs.b1 = -2.0f / a0_2;
-        kWeight2Coeffs.b2 = 1.0f / a0_2;
-        kWeight2Coeffs.a1 = 2.0f * (K1 * K1 - 1.0f) / a0_2;
-        kWeight2Coeffs.a2 = (1.0f - K1 / Q1 + K1 * K1) / a0_2;
+        highPass.b0 = 1.0f / a0_2;
+        highPass.b1 = -2.0f / a0_2;
+        highPass.b2 = 1.0f / a0_2;
+        highPass.a1 = 2.0f * (K1 * K1 - 1.0f) / a0_2;
+        highPass.a2 = (1.0f - K1 / Q1 + K1 * K1) / a0_2;
     }
 
-    float processKWeighting(float input, int channel)
+private:
+    static constexpr float MINUS_INFINITY = -100.0f;
+    static constexpr float ABSOLUTE_GATE = -70.0f;  // LUFS
+    static constexpr float RELATIVE_GATE = -10.0f;  // dB below ungated loudness
+    static constexpr int MOMENTARY_BLOCKS = 4;      // 400ms of 100ms blocks
+    static constexpr int SHORT_TERM_BLOCKS = 30;    // 3s of 100ms blocks
+    static constexpr float LRA_RELATIVE_GATE = -20.0f;  // EBU Tech 3342
+    static constexpr double OVER_GAP_SECONDS = 0.05;
+
+    // Program loudness histograms, 0.1 LU bins from the absolute gate up.
+    // Each bin keeps the exact energy of its blocks, so gated means are
+    // exact and only the relative gate position rounds to a bin.
+    static constexpr float HISTOGRAM_FLOOR = ABSOLUTE_GATE;
+    static constexpr int HISTOGRAM_BINS_PER_LU = 10;
+    static constexpr int HISTOGRAM_BINS = 80 * HISTOGRAM_BINS_PER_LU;  // Up to +10 LUFS
+
+    struct LoudnessHistogram
     {
-        float stage1 = kWeightState1[channel].process(input, kWeight1Coeffs);
-        return kWeightState2[channel].process(stage1, kWeight2Coeffs);
+        std::array<uint32_t, HISTOGRAM_BINS> counts {};
+        std::array<double, HISTOGRAM_BINS> energy {};
+        uint64_t totalCount = 0;
+        double totalEnergy = 0.0;
+
+        void clear()
+        {
+            counts.fill(0);
+            energy.fill(0.0);
+            totalCount = 0;
+            totalEnergy = 0.0;
+        }
+
+        // meanSquare is the K-weighted block power; blocks under the absolute gate are dropped
+        void add(float meanSquare)
+        {
+            const float loudness = powerToLoudness(meanSquare);
+            if (loudness <= ABSOLUTE_GATE)
+                return;
+
+            const int bin = std::min(HISTOGRAM_BINS - 1, static_cast<int>((loudness - HISTOGRAM_FLOOR) * HISTOGRAM_BINS_PER_LU));
+            counts[static_cast<size_t>(bin)]++;
+            energy[static_cast<size_t>(bin)] += meanSquare;
+            totalCount++;
+            totalEnergy += meanSquare;
+        }
+
+        // First bin at or above the relative gate below the ungated mean
+        int getRelativeGateBin(float relativeGate) const
+        {
+            const float threshold = powerToLoudness(static_cast<float>(totalEnergy / static_cast<double>(totalCount))) + relativeGate;
+            return juce::jlimit(0, HISTOGRAM_BINS - 1, static_cast<int>(std::floor((threshold - HISTOGRAM_FLOOR) * HISTOGRAM_BINS_PER_LU)));
+        }
+
+        static float getBinCentre(int bin)
+        {
+            return HISTOGRAM_FLOOR + (static_cast<float>(bin) + 0.5f) / HISTOGRAM_BINS_PER_LU;
+        }
+    };
+
+    static float powerToLoudness(float meanSquare)
+    {
+        return -0.691f + 10.0f * std::log10(std::max(meanSquare, 1e-10f));
     }
 
-    void updateIntegratedLoudness()
+    void setupKWeightingFilters(double sampleRate)
     {
-        if (integratedBlocks.empty())
-            return;
+        designKWeighting(sampleRate, kWeight1Coeffs, kWeight2Coeffs);
+    }
+
+    static float getChannelWeight(juce::AudioChannelSet::ChannelType type)
+    {
+        switch (type)
+        {
+            case juce::AudioChannelSet::LFE:
+            case juce::AudioChannelSet::LFE2:
+                return 0.0f;
+
+            case juce::AudioChannelSet::leftSurround:
+            case juce::AudioChannelSet::rightSurround:
+            case juce::AudioChannelSet::leftSurroundSide:
+            case juce::AudioChannelSet::rightSurroundSide:
+                return 1.41f;
+
+            default:
+                return 1.0f;
+        }
+    }
+
+    // Feed one completed 100ms block (weighted mean square) into the windows
+    void addLoudnessBlock(float meanSquare)
+    {
+        // Add to the window ring (the newest 4 blocks are the momentary window)
+        recentBlocks[static_cast<size_t>(recentBlockIndex)] = meanSquare;
+        recentBlockIndex = (recentBlockIndex + 1) % SHORT_TERM_BLOCKS;
+        recentBlockCount = std::min(recentBlockCount + 1, SHORT_TERM_BLOCKS);
+
+        // Calculate momentary loudness (400ms)
+        float momMean = getRecentMean(std::min(recentBlockCount, MOMENTARY_BLOCKS));
+        momentaryLUFS.store(powerToLoudness(momMean));
+
+        // Calculate short-term loudness (3s)
+        float stMean = getRecentMean(recentBlockCount);
+        shortTermLUFS.store(powerToLoudness(stMean));
+
+        if (history != nullptr)
+            history->push(momentaryLUFS.load(), shortTermLUFS.load(), DSPUtils::linearToDecibels(blockTruePeak));
 
-        // First pass: ungated loudness
-        float sum = std::accumulate(integratedBlocks.begin(), integratedBlocks.end(), 0.0f);
-        float ungatedLoudness = -0.691f + 10.0f * std::log10(sum / integratedBlocks.size());
+        // Program statistics: every full momentary window is a 400ms gating
+        // block (75% overlap) and every full short-term window an LRA reading
+        ++programBlocks;
+        programTruePeak = std::max(programTruePeak, blockTruePeak);
+        blockTruePeak = 0.0f;
 
-        // Second pass: apply relative gate
-        float relativeThreshold = ungatedLoudness + RELATIVE_GATE;
-        float relativeThresholdLinear = std::pow(10.0f, (relativeThreshold + 0.691f) / 10.0f);
+        if (programBlocks >= MOMENTARY_BLOCKS)
+        {
+            gatingBlocks.add(momMean);
+            program.maxMomentaryLUFS = std::max(program.maxMomentaryLUFS, powerToLoudness(momMean));
+        }
 
-        float gatedSum = 0.0f;
-        int gatedCount = 0;
+        if (programBlocks >= SHORT_TERM_BLOCKS)
+        {
+            shortTermBlocks.add(stMean);
+            program.maxShortTermLUFS = std::max(program.maxShortTermLUFS, powerToLoudness(stMean));
+        }
 
-        std::vector<float> gatedBlocks;
+        updateProgramStatistics();
+    }
 
-        for (float block : integratedBlocks)
+    // Mean of the newest numBlocks entries in the window ring
+    float getRecentMean(int numBlocks) const
+    {
+        float sum = 0.0f;
+        for (int i = 1; i <= numBlocks; ++i)
+            sum += recentBlocks[static_cast<size_t>((recentBlockIndex - i + SHORT_TERM_BLOCKS) % SHORT_TERM_BLOCKS)];
+        return numBlocks > 0 ? sum / static_cast<float>(numBlocks) : 0.0f;
+    }
+
+    // Integrated loudness (BS.1770-4) and LRA (Tech 3342) from the
+    // histograms: O(bins) per 100ms block however long the program
+    void updateProgramStatistics()
+    {
+        if (gatingBlocks.totalCount > 0)
         {
-            if (block >= relativeThresholdLinear)
+            const int gateBin = gatingBlocks.getRelativeGateBin(RELATIVE_GATE);
+
+            double gatedEnergy = 0.0;
+            uint64_t gatedCount = 0;
+            for (int bin = gateBin; bin < HISTOGRAM_BINS; ++bin)
             {
-                gatedSum += block;
-                gatedCount++;
-                gatedBlocks.push_back(-0.691f + 10.0f * std::log10(block));
+                gatedEnergy += gatingBlocks.energy[static_cast<size_t>(bin)];
+                gatedCount += gatingBlocks.counts[static_cast<size_t>(bin)];
             }
+
+            if (gatedCount > 0)
+                program.integratedLUFS = powerToLoudness(static_cast<float>(gatedEnergy / static_cast<double>(gatedCount)));
         }
 
-        if (gatedCount > 0)
+        if (shortTermBlocks.totalCount > 0)
         {
-            float intLUFS = -0.691f + 10.0f * std::log10(gatedSum / gatedCount);
-            integratedLUFS.store(intLUFS);
+            const int gateBin = shortTermBlocks.getRelativeGateBin(LRA_RELATIVE_GATE);
+
+            uint64_t gatedCount = 0;
+            for (int bin = gateBin; bin < HISTOGRAM_BINS; ++bin)
+                gatedCount += shortTermBlocks.counts[static_cast<size_t>(bin)];
 
-            // Calculate loudness range (LRA)
-            if (gatedBlocks.size() >= 2)
+            // 10th and 95th percentiles of the gated short-term loudness
+            const auto percentileBin = [&] (double fraction)
             {
-                std::sort(gatedBlocks.begin(), gatedBlocks.end());
-                int low10Index = static_cast<int>(gatedBlocks.size() * 0.1f);
-                int high95Index = static_cast<int>(gatedBlocks.size() * 0.95f);
-                high95Index = std::min(high95Index, static_cast<int>(gatedBlocks.size()) - 1);
-                loudnessRange.store(gatedBlocks[high95Index] - gatedBlocks[low10Index]);
-            }
+                const uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(gatedCount - 1));
+                uint64_t seen = 0;
+                for (int bin = gateBin; bin < HISTOGRAM_BINS; ++bin)
+                {
+                    seen += shortTermBlocks.counts[static_cast<size_t>(bin)];
+                    if (seen > rank)
+                        return bin;
+                }
+                return HISTOGRAM_BINS - 1;
+            };
+
+            if (gatedCount >= 2)
+                program.loudnessRange = LoudnessHistogram::getBinCentre(percentileBin(0.95))
+                                      - LoudnessHistogram::getBinCentre(percentileBin(0.10));
         }
+
+        program.maxTruePeak = DSPUtils::linearToDecibels(programTruePeak);
+        program.measuredSeconds = programBlocks * 0.1;
+
+        integratedLUFS.store(program.integratedLUFS);
+        loudnessRange.store(program.loudnessRange);
+        publishedStatistics.publish(program);
+    }
+
+    void clearProgram()
+    {
+        gatingBlocks.clear();
+        shortTermBlocks.clear();
+        program = LoudnessCompliance::Statistics {};
+        programBlocks = 0;
+        programTruePeak = 0.0f;
+        overHoldRemaining.fill(0);
+        publishedStatistics.publish(program);
     }
 
     double currentSampleRate = 44100.0;
     int currentBlockSize = 512;
 
-    // K-weighting filters
+    // Per-sample state, packed together: filters, block power and the
+    // true-peak detectors are all touched for every sample
+    DSPUtils::MultiChannelBiquadState<float> kWeightState1;
+    DSPUtils::MultiChannelBiquadState<float> kWeightState2;
+    DSPUtils::ChannelFrame<float> channelBlockPower;
     DSPUtils::BiquadCoeffs kWeight1Coeffs;
     DSPUtils::BiquadCoeffs kWeight2Coeffs;
-    DSPUtils::BiquadState kWeightState1[2];
-    DSPUtils::BiquadState kWeightState2[2];
-
-    // True peak detection
-    DSPUtils::TruePeakDetector truePeakDetectorL;
-    DSPUtils::TruePeakDetector truePeakDetectorR;
-
-    // Loudness measurement buffers
-    std::deque<float> momentaryBuffer;
-    std::deque<float> shortTermBuffer;
-    std::vector<float> integratedBlocks;
-
-    // Block accumulation
-    float currentBlockPower = 0.0f;
     int blockSampleCount = 0;
-
-    // Atomic metering outputs
-    std::atomic<float> momentaryLUFS { MINUS_INFINITY };
+    float blockTruePeak = 0.0f;  // Linear, all channels, since the last 100ms block
+    std::array<DSPUtils::TruePeakDetector, DSPUtils::MAX_CHANNELS> truePeakDetectors;
+
+    // Per-block state
+    std::array<float, DSPUtils::MAX_CHANNELS> channelWeights;
+    std::array<float, SHORT_TERM_BLOCKS> recentBlocks = {};
+    int recentBlockIndex = 0;
+    int recentBlockCount = 0;
+    LoudnessHistory* history = nullptr;
+
+    // Program statistics (audio thread), published once per 100ms block
+    LoudnessHistogram gatingBlocks;
+    LoudnessHistogram shortTermBlocks;
+    LoudnessCompliance::Statistics program;
+    int64_t programBlocks = 0;
+    float programTruePeak = 0.0f;  // Linear
+    std::array<float, LoudnessCompliance::OVER_THRESHOLDS.size()> overThresholds {};  // Linear
+    std::array<int, LoudnessCompliance::OVER_THRESHOLDS.size()> overHoldRemaining {};  // Samples until an over ends
+    int overGapSamples = 2205;
+    DSPUtils::SeqLock<LoudnessCompliance::Statistics> publishedStatistics;
+    std::atomic<bool> programResetRequested { false };
+
+    // Atomic metering outputs (own cache line: written by the audio thread, polled by the UI)
+    alignas(DSPUtils::CACHE_LINE_SIZE) std::atomic<float> momentaryLUFS { MINUS_INFINITY };
     std::atomic<float> shortTermLUFS { MINUS_INFINITY };
     std::atomic<float> integratedLUFS { MINUS_INFINITY };
     std::atomic<float> loudnessRange { 0.0f };
@@ -283,4 +478,5 @@ private:
     std::atomic<float> peakLevelR { MINUS_INFINITY };
     std::atomic<float> truePeakL { MINUS_INFINITY };
     std::atomic<float> truePeakR { MINUS_INFINITY };
+    std::atomic<float> maxTruePeak { MINUS_INFINITY };
 };
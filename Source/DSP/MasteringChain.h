@@ -4,7 +4,6 @@
 #include "MultibandCompressor.h"
 #include "StereoImager.h"
 #include "Limiter.h"
-#include "LoudnessMeter.h"
 #include "DSPUtils.h"
 
 class MasteringChain
@@ -12,25 +11,52 @@ class MasteringChain
 public:
     MasteringChain() = default;
 
-    void prepare(double sampleRate, int samplesPerBlock)
+    // Hosts re-prepare often (transport start, bounce, sample-rate probing), so
+    // only what depends on a changed setting is rebuilt. An unchanged
+    // configuration just clears the signal state.
+    void prepare(double sampleRate, int samplesPerBlock,
+                 const juce::AudioChannelSet& layout = juce::AudioChannelSet::stereo(),
+                 juce::AudioProcessor::ProcessingPrecision precision = juce::AudioProcessor::singlePrecision)
     {
+        const bool sampleRateChanged = !isPrepared || sampleRate != currentSampleRate;
+        const bool blockSizeChanged = !isPrepared || samplesPerBlock != currentBlockSize;
+        const bool layoutChanged = !isPrepared || layout != currentLayout;
+        const bool precisionChanged = !isPrepared || precision != currentPrecision;
+
         currentSampleRate = sampleRate;
         currentBlockSize = samplesPerBlock;
+        currentLayout = layout;
+        currentPrecision = precision;
+        isPrepared = true;
 
-        eq.prepare(sampleRate, samplesPerBlock);
-        compressor.prepare(sampleRate, samplesPerBlock);
-        stereoImager.prepare(sampleRate, samplesPerBlock);
-        limiter.prepare(sampleRate, samplesPerBlock);
+        // Filter coefficients and time constants
+        if (sampleRateChanged)
+        {
+            eq.prepare(sampleRate, samplesPerBlock);
+            compressor.prepare(sampleRate, samplesPerBlock);
+            stereoImager.prepare(sampleRate, samplesPerBlock);  // Acts on the front L/R pair only
 
-        inputMeter.prepare(sampleRate, samplesPerBlock);
-        outputMeter.prepare(sampleRate, samplesPerBlock);
+            inputGainSmoothed.reset(sampleRate);
+            outputGainSmoothed.reset(sampleRate);
+            headroomGainSmoothed.reset(sampleRate);
 
-        inputGainSmoothed.reset(sampleRate);
-        outputGainSmoothed.reset(sampleRate);
-        headroomGainSmoothed.reset(sampleRate);
+            // Peak follower coefficient: ~100ms attack/release for smooth tracking
+            peakFollowerCoeff = std::exp(-1.0f / (static_cast<float>(sampleRate) * 0.1f));
+        }
 
-        // Peak follower coefficient: ~100ms attack/release for smooth tracking
-        peakFollowerCoeff = std::exp(-1.0f / (static_cast<float>(sampleRate) * 0.1f));
+        // Buffer sizes: lookahead follows the rate, scratch the block size,
+        // the oversampler the channel count, the delay line the precision
+        if (sampleRateChanged || blockSizeChanged || layoutChanged || precisionChanged)
+        {
+            limiter.prepare(sampleRate, samplesPerBlock, layout.size(), precision);
+
+            // One allocation for every stage's buffers, hottest first
+            stateArena.build([this] (DSPUtils::StateArena& arena)
+            {
+                limiter.allocateState(arena);
+                stereoImager.allocateState(arena);
+            });
+        }
 
         reset();
     }
@@ -41,17 +67,86 @@ public:
         compressor.reset();
         stereoImager.reset();
         limiter.reset();
-        inputMeter.reset();
-        outputMeter.reset();
 
         trackedPeakLevel = 0.0f;
         currentHeadroomGainDB = 0.0f;
+        inputTrimDB.store(0.0f);
     }
 
-    void process(juce::AudioBuffer<float>& buffer)
+    // Compiled once for float and once for double; gains and metering stay
+    // float, the signal path runs at the host's precision. Blocks larger than
+    // the size given to prepare() run in pieces, since the stages' scratch
+    // buffers are sized for it.
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer)
+    {
+        const int numSamples = buffer.getNumSamples();
+
+        if (numSamples <= currentBlockSize)
+        {
+            processBlock(buffer);
+            return;
+        }
+
+        for (int start = 0; start < numSamples; start += currentBlockSize)
+        {
+            juce::AudioBuffer<SampleType> block(buffer.getArrayOfWritePointers(), buffer.getNumChannels(),
+                                                start, std::min(currentBlockSize, numSamples - start));
+            processBlock(block);
+        }
+    }
+
+    // Global controls
+    void setInputGain(float gainDB)
+    {
+        inputGainDB = juce::jlimit(-24.0f, 24.0f, gainDB);
+    }
+
+    void setOutputGain(float gainDB)
+    {
+        outputGainDB = juce::jlimit(-24.0f, 24.0f, gainDB);
+    }
+
+    void setChainEnabled(bool enabled)
+    {
+        chainEnabled = enabled;
+    }
+
+    // Module access
+    MasteringEQ& getEQ() { return eq; }
+    MultibandCompressor& getCompressor() { return compressor; }
+    StereoImager& getStereoImager() { return stereoImager; }
+    Limiter& getLimiter() { return limiter; }
+
+    const MasteringEQ& getEQ() const { return eq; }
+    const MultibandCompressor& getCompressor() const { return compressor; }
+    const StereoImager& getStereoImager() const { return stereoImager; }
+    const Limiter& getLimiter() const { return limiter; }
+
+    // Metering (loudness and peaks come from MeteringService)
+    float getInputTrimDB() const { return inputTrimDB.load(std::memory_order_relaxed); }
+    float getGainReduction() const { return limiter.getGainReduction() + compressor.getMaxGainReduction(); }
+
+    // Latency
+    int getLatencySamples() const { return limiter.getLatencySamples(); }
+
+    // Getters
+    float getInputGain() const { return inputGainDB; }
+    float getOutputGain() const { return outputGainDB; }
+    bool isChainEnabled() const { return chainEnabled; }
+
+    // Auto headroom control
+    void setAutoHeadroomEnabled(bool enabled) { autoHeadroomEnabled = enabled; }
+    bool isAutoHeadroomEnabled() const { return autoHeadroomEnabled; }
+    float getHeadroomReduction() const { return -currentHeadroomGainDB; }  // Return as positive dB
+
+private:
+    template <typename SampleType>
+    void processBlock(juce::AudioBuffer<SampleType>& buffer)
     {
         const int numSamples = buffer.getNumSamples();
         const int numChannels = buffer.getNumChannels();
+        auto* const* channels = buffer.getArrayOfWritePointers();
 
         // Apply input gain
         if (std::abs(inputGainDB) > 0.01f)
@@ -59,9 +154,9 @@ public:
             inputGainSmoothed.setTargetValue(DSPUtils::decibelsToLinear(inputGainDB));
             for (int sample = 0; sample < numSamples; ++sample)
             {
-                float gain = inputGainSmoothed.getNextValue();
+                auto gain = static_cast<SampleType>(inputGainSmoothed.getNextValue());
                 for (int ch = 0; ch < numChannels; ++ch)
-                    buffer.setSample(ch, sample, buffer.getSample(ch, sample) * gain);
+                    channels[ch][sample] *= gain;
             }
         }
 
@@ -77,7 +172,7 @@ public:
             {
                 for (int sample = 0; sample < numSamples; ++sample)
                 {
-                    float absVal = std::abs(buffer.getSample(ch, sample));
+                    float absVal = static_cast<float>(std::abs(channels[ch][sample]));
                     blockPeak = std::max(blockPeak, absVal);
                 }
             }
@@ -113,17 +208,20 @@ public:
                 headroomGainSmoothed.setTargetValue(DSPUtils::decibelsToLinear(currentHeadroomGainDB));
                 for (int sample = 0; sample < numSamples; ++sample)
                 {
-                    float gain = headroomGainSmoothed.getNextValue();
+                    auto gain = static_cast<SampleType>(headroomGainSmoothed.getNextValue());
                     for (int ch = 0; ch < numChannels; ++ch)
-                        buffer.setSample(ch, sample, buffer.getSample(ch, sample) * gain);
+                        channels[ch][sample] *= gain;
                 }
             }
         }
 
-        // Measure input (after headroom adjustment - this affects LUFS calculation,
-        // which the limiter's auto-gain will then compensate for)
-        juce::AudioBuffer<float> inputCopy(buffer);
-        inputMeter.process(inputCopy);
+        // Gain applied ahead of the stages this block. Metering taps the raw
+        // input once (MeteringService); levels as the stages see them are that
+        // tap offset by this trim.
+        float trimDB = std::abs(inputGainDB) > 0.01f ? inputGainDB : 0.0f;
+        if (autoHeadroomEnabled && chainEnabled && std::abs(currentHeadroomGainDB) > 0.01f)
+            trimDB += currentHeadroomGainDB;
+        inputTrimDB.store(trimDB, std::memory_order_relaxed);
 
         // Processing chain: EQ -> Compressor -> Stereo -> Limiter
         if (chainEnabled)
@@ -140,69 +238,22 @@ public:
             outputGainSmoothed.setTargetValue(DSPUtils::decibelsToLinear(outputGainDB));
             for (int sample = 0; sample < numSamples; ++sample)
             {
-                float gain = outputGainSmoothed.getNextValue();
+                auto gain = static_cast<SampleType>(outputGainSmoothed.getNextValue());
                 for (int ch = 0; ch < numChannels; ++ch)
-                    buffer.setSample(ch, sample, buffer.getSample(ch, sample) * gain);
+                    channels[ch][sample] *= gain;
             }
         }
-
-        // Measure output
-        outputMeter.process(buffer);
     }
 
-    // Global controls
-    void setInputGain(float gainDB)
-    {
-        inputGainDB = juce::jlimit(-24.0f, 24.0f, gainDB);
-    }
 
-    void setOutputGain(float gainDB)
-    {
-        outputGainDB = juce::jlimit(-24.0f, 24.0f, gainDB);
-    }
-
-    void setChainEnabled(bool enabled)
-    {
-        chainEnabled = enabled;
-    }
-
-    // Module access
-    MasteringEQ& getEQ() { return eq; }
-    MultibandCompressor& getCompressor() { return compressor; }
-    StereoImager& getStereoImager() { return stereoImager; }
-    Limiter& getLimiter() { return limiter; }
-
-    const MasteringEQ& getEQ() const { return eq; }
-    const MultibandCompressor& getCompressor() const { return compressor; }
-    const StereoImager& getStereoImager() const { return stereoImager; }
-    const Limiter& getLimiter() const { return limiter; }
-
-    // Metering
-    const LoudnessMeter& getInputMeter() const { return inputMeter; }
-    const LoudnessMeter& getOutputMeter() const { return outputMeter; }
-
-    float getInputLUFS() const { return inputMeter.getShortTermLUFS(); }
-    float getOutputLUFS() const { return outputMeter.getShortTermLUFS(); }
-    float getIntegratedLUFS() const { return outputMeter.getIntegratedLUFS(); }
-    float getTruePeak() const { return outputMeter.getMaxTruePeak(); }
-    float getGainReduction() const { return limiter.getGainReduction() + compressor.getMaxGainReduction(); }
-
-    // Latency
-    int getLatencySamples() const { return limiter.getLatencySamples(); }
-
-    // Getters
-    float getInputGain() const { return inputGainDB; }
-    float getOutputGain() const { return outputGainDB; }
-    bool isChainEnabled() const { return chainEnabled; }
-
-    // Auto headroom control
-    void setAutoHeadroomEnabled(bool enabled) { autoHeadroomEnabled = enabled; }
-    bool isAutoHeadroomEnabled() const { return autoHeadroomEnabled; }
-    float getHeadroomReduction() const { return -currentHeadroomGainDB; }  // Return as positive dB
-
-private:
     double currentSampleRate = 44100.0;
     int currentBlockSize = 512;
+    juce::AudioChannelSet currentLayout;
+    juce::AudioProcessor::ProcessingPrecision currentPrecision = juce::AudioProcessor::singlePrecision;
+    bool isPrepared = false;
+
+    // Backing memory for the stages' delay lines and history buffers
+    DSPUtils::StateArena stateArena;
 
     // Processing modules
     MasteringEQ eq;
@@ -210,10 +261,6 @@ private:
     StereoImager stereoImager;
     Limiter limiter;
 
-    // Metering
-    LoudnessMeter inputMeter;
-    LoudnessMeter outputMeter;
-
     // Gain controls
     float inputGainDB = 0.0f;
     float outputGainDB = 0.0f;
@@ -228,4 +275,6 @@ private:
     DSPUtils::SmoothedValue headroomGainSmoothed;
 
     bool chainEnabled = true;
+
+    alignas(DSPUtils::CACHE_LINE_SIZE) std::atomic<float> inputTrimDB { 0.0f };
 };
@@ -21,65 +21,61 @@ public:
 
     void reset()
     {
-        for (int ch = 0; ch < 2; ++ch)
-        {
-            for (int stage = 0; stage < 4; ++stage)
-            {
-                hpfState[ch][stage].reset();
-                lpfState[ch][stage].reset();
-            }
-            lowShelfState[ch].reset();
-            highShelfState[ch].reset();
-            for (int band = 0; band < NUM_BANDS; ++band)
-                bandState[ch][band].reset();
-        }
+        filterStates.forEach([] (auto& states) { states.reset(); });
     }
 
-    void process(juce::AudioBuffer<float>& buffer)
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer)
     {
         if (bypassed)
             return;
 
         const int numSamples = buffer.getNumSamples();
-        const int numChannels = std::min(buffer.getNumChannels(), 2);
+        const int numChannels = std::min(buffer.getNumChannels(), DSPUtils::MAX_CHANNELS);
+        auto* const* channels = buffer.getArrayOfWritePointers();
+        auto& states = filterStates.get<SampleType>();
+
+        const auto& hpf = hpfCoeffs.get<SampleType>();
+        const auto& lpf = lpfCoeffs.get<SampleType>();
+        const auto& lowShelf = lowShelfCoeffs.get<SampleType>();
+        const auto& highShelf = highShelfCoeffs.get<SampleType>();
+
+        DSPUtils::ChannelFrame<SampleType> frame;
 
         for (int sample = 0; sample < numSamples; ++sample)
         {
-            for (int ch = 0; ch < numChannels; ++ch)
+            DSPUtils::readFrame(channels, numChannels, sample, frame);
+
+            // HPF (up to 4 cascaded stages for 24dB/oct)
+            if (hpfEnabled)
             {
-                float x = buffer.getSample(ch, sample);
-
-                // HPF (up to 4 cascaded stages for 24dB/oct)
-                if (hpfEnabled)
-                {
-                    for (int stage = 0; stage < hpfOrder; ++stage)
-                        x = hpfState[ch][stage].process(x, hpfCoeffs);
-                }
-
-                // Low shelf
-                if (std::abs(lowShelfGain) > 0.01f)
-                    x = lowShelfState[ch].process(x, lowShelfCoeffs);
-
-                // Parametric bands
-                for (int band = 0; band < NUM_BANDS; ++band)
-                {
-                    if (bandEnabled[band] && std::abs(bandGain[band]) > 0.01f)
-                        x = bandState[ch][band].process(x, bandCoeffs[band]);
-                }
-
-                // High shelf
-                if (std::abs(highShelfGain) > 0.01f)
-                    x = highShelfState[ch].process(x, highShelfCoeffs);
-
-                // LPF (up to 4 cascaded stages for 24dB/oct)
-                if (lpfEnabled)
-                {
-                    for (int stage = 0; stage < lpfOrder; ++stage)
-                        x = lpfState[ch][stage].process(x, lpfCoeffs);
-                }
-
-                buffer.setSample(ch, sample, x);
+                for (int stage = 0; stage < hpfOrder; ++stage)
+                    states.hpf[stage].process(frame, numChannels, hpf);
+            }
+
+            // Low shelf
+            if (std::abs(lowShelfGain) > 0.01f)
+                states.lowShelf.process(frame, numChannels, lowShelf);
+
+            // Parametric bands
+            for (int band = 0; band < NUM_BANDS; ++band)
+            {
+                if (bandEnabled[band] && std::abs(bandGain[band]) > 0.01f)
+                    states.bands[band].process(frame, numChannels, bandCoeffs[band].get<SampleType>());
             }
+
+            // High shelf
+            if (std::abs(highShelfGain) > 0.01f)
+                states.highShelf.process(frame, numChannels, highShelf);
+
+            // LPF (up to 4 cascaded stages for 24dB/oct)
+            if (lpfEnabled)
+            {
+                for (int stage = 0; stage < lpfOrder; ++stage)
+                    states.lpf[stage].process(frame, numChannels, lpf);
+            }
+
+            DSPUtils::writeFrame(channels, numChannels, sample, frame);
         }
     }
 
@@ -342,22 +338,22 @@ private:
 
     void updateHPF()
     {
-        hpfCoeffs.makeHighPass(currentSampleRate, hpfFreq, 0.707f);
+        hpfCoeffs.makeHighPass(currentSampleRate, hpfFreq, 0.707);
     }
 
     void updateLPF()
     {
-        lpfCoeffs.makeLowPass(currentSampleRate, lpfFreq, 0.707f);
+        lpfCoeffs.makeLowPass(currentSampleRate, lpfFreq, 0.707);
     }
 
     void updateLowShelf()
     {
-        lowShelfCoeffs.makeLowShelf(currentSampleRate, lowShelfFreq, lowShelfGain, 0.707f);
+        lowShelfCoeffs.makeLowShelf(currentSampleRate, lowShelfFreq, lowShelfGain, 0.707);
     }
 
     void updateHighShelf()
     {
-        highShelfCoeffs.makeHighShelf(currentSampleRate, highShelfFreq, highShelfGain, 0.707f);
+        highShelfCoeffs.makeHighShelf(currentSampleRate, highShelfFreq, highShelfGain, 0.707);
     }
 
     void updateBand(int band)
@@ -366,29 +362,54 @@ private:
             bandCoeffs[band].makePeaking(currentSampleRate, bandFreq[band], bandGain[band], bandQ[band]);
     }
 
-    float getFilterMagnitude(const DSPUtils::BiquadCoeffs& coeffs, float freq) const
+    float getFilterMagnitude(const DSPUtils::BiquadDesign& design, float freq) const
     {
         // Calculate magnitude response at given frequency
-        float w = DSPUtils::TWO_PI * freq / static_cast<float>(currentSampleRate);
-        float cosw = std::cos(w);
-        float cos2w = std::cos(2.0f * w);
-        float sinw = std::sin(w);
-        float sin2w = std::sin(2.0f * w);
+        const auto& coeffs = design.coeffs;
+        double w = juce::MathConstants<double>::twoPi * freq / currentSampleRate;
+        double cosw = std::cos(w);
+        double cos2w = std::cos(2.0 * w);
+        double sinw = std::sin(w);
+        double sin2w = std::sin(2.0 * w);
 
         // Numerator: b0 + b1*z^-1 + b2*z^-2 at z = e^(jw)
-        float numReal = coeffs.b0 + coeffs.b1 * cosw + coeffs.b2 * cos2w;
-        float numImag = -coeffs.b1 * sinw - coeffs.b2 * sin2w;
+        double numReal = coeffs.b0 + coeffs.b1 * cosw + coeffs.b2 * cos2w;
+        double numImag = -coeffs.b1 * sinw - coeffs.b2 * sin2w;
 
         // Denominator: 1 + a1*z^-1 + a2*z^-2 at z = e^(jw)
-        float denReal = 1.0f + coeffs.a1 * cosw + coeffs.a2 * cos2w;
-        float denImag = -coeffs.a1 * sinw - coeffs.a2 * sin2w;
+        double denReal = 1.0 + coeffs.a1 * cosw + coeffs.a2 * cos2w;
+        double denImag = -coeffs.a1 * sinw - coeffs.a2 * sin2w;
 
-        float numMag = std::sqrt(numReal * numReal + numImag * numImag);
-        float denMag = std::sqrt(denReal * denReal + denImag * denImag);
+        double numMag = std::sqrt(numReal * numReal + numImag * numImag);
+        double denMag = std::sqrt(denReal * denReal + denImag * denImag);
 
-        return denMag > 0.0f ? numMag / denMag : 0.0f;
+        return denMag > 0.0 ? static_cast<float>(numMag / denMag) : 0.0f;
     }
 
+    // Filter memory for one sample type
+    template <typename SampleType>
+    struct FilterStates
+    {
+        DSPUtils::MultiChannelBiquadState<SampleType> hpf[4];
+        DSPUtils::MultiChannelBiquadState<SampleType> lpf[4];
+        DSPUtils::MultiChannelBiquadState<SampleType> lowShelf;
+        DSPUtils::MultiChannelBiquadState<SampleType> highShelf;
+        DSPUtils::MultiChannelBiquadState<SampleType> bands[NUM_BANDS];
+
+        void reset()
+        {
+            for (int stage = 0; stage < 4; ++stage)
+            {
+                hpf[stage].reset();
+                lpf[stage].reset();
+            }
+            lowShelf.reset();
+            highShelf.reset();
+            for (auto& band : bands)
+                band.reset();
+        }
+    };
+
     double currentSampleRate = 44100.0;
     int currentBlockSize = 512;
     bool bypassed = false;
@@ -397,33 +418,30 @@ private:
     float hpfFreq = 30.0f;
     int hpfOrder = 2;  // 12dB/oct
     bool hpfEnabled = false;
-    DSPUtils::BiquadCoeffs hpfCoeffs;
-    DSPUtils::BiquadState hpfState[2][4];
+    DSPUtils::BiquadDesign hpfCoeffs;
 
     // LPF
     float lpfFreq = 18000.0f;
     int lpfOrder = 2;
     bool lpfEnabled = false;
-    DSPUtils::BiquadCoeffs lpfCoeffs;
-    DSPUtils::BiquadState lpfState[2][4];
+    DSPUtils::BiquadDesign lpfCoeffs;
 
     // Low shelf
     float lowShelfFreq = 100.0f;
     float lowShelfGain = 0.0f;
-    DSPUtils::BiquadCoeffs lowShelfCoeffs;
-    DSPUtils::BiquadState lowShelfState[2];
+    DSPUtils::BiquadDesign lowShelfCoeffs;
 
     // High shelf
     float highShelfFreq = 8000.0f;
     float highShelfGain = 0.0f;
-    DSPUtils::BiquadCoeffs highShelfCoeffs;
-    DSPUtils::BiquadState highShelfState[2];
+    DSPUtils::BiquadDesign highShelfCoeffs;
 
     // Parametric bands
     std::array<float, NUM_BANDS> bandFreq = { 200.0f, 800.0f, 2500.0f, 6000.0f };
     std::array<float, NUM_BANDS> bandGain = { 0.0f, 0.0f, 0.0f, 0.0f };
     std::array<float, NUM_BANDS> bandQ = { 1.0f, 1.0f, 1.0f, 1.0f };
     std::array<bool, NUM_BANDS> bandEnabled = { true, true, true, true };
-    std::array<DSPUtils::BiquadCoeffs, NUM_BANDS> bandCoeffs;
-    DSPUtils::BiquadState bandState[2][NUM_BANDS];
+    std::array<DSPUtils::BiquadDesign, NUM_BANDS> bandCoeffs;
+
+    DSPUtils::PerSampleType<FilterStates> filterStates;
 };
@@ -0,0 +1,3 @@
+// MeteringService implementation
+// All functionality is in the header file
+#include "MeteringService.h"
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "LoudnessMeter.h"
+#include "DSPUtils.h"
+
+// The plugin's loudness metering: one LoudnessMeter per tap point, each
+// running a single K-weighting and true-peak pass per block, shared by
+// every consumer.
+//
+//   Input  - the raw host input. AnalysisEngine reads it directly. Each
+//            chain's post-trim input (after input gain and auto headroom)
+//            is this tap offset by the chain's known trim; a fixed gain
+//            shifts peaks and LUFS by exactly its dB value, so no second
+//            meter is needed.
+//   Output - the plugin output after the comparison crossfade, i.e. what
+//            is actually heard.
+class MeteringService
+{
+public:
+    MeteringService()
+    {
+        inputMeter.setHistory(&inputHistory);
+        outputMeter.setHistory(&outputHistory);
+    }
+
+    // Same configuration: meters keep integrating across the re-prepare
+    void prepare(double sampleRate, int samplesPerBlock,
+                 const juce::AudioChannelSet& layout = juce::AudioChannelSet::stereo())
+    {
+        if (isPrepared && sampleRate == currentSampleRate && samplesPerBlock == currentBlockSize)
+        {
+            if (layout != currentLayout)
+            {
+                currentLayout = layout;
+                inputMeter.setChannelLayout(layout);
+                outputMeter.setChannelLayout(layout);
+            }
+            return;
+        }
+
+        currentSampleRate = sampleRate;
+        currentBlockSize = samplesPerBlock;
+        currentLayout = layout;
+        isPrepared = true;
+
+        inputMeter.prepare(sampleRate, samplesPerBlock, layout);
+        outputMeter.prepare(sampleRate, samplesPerBlock, layout);
+    }
+
+    void reset()
+    {
+        inputMeter.reset();
+        outputMeter.reset();
+    }
+
+    template <typename SampleType>
+    void processInput(const juce::AudioBuffer<SampleType>& buffer)
+    {
+        inputMeter.process(buffer);
+    }
+
+    template <typename SampleType>
+    void processOutput(const juce::AudioBuffer<SampleType>& buffer)
+    {
+        outputMeter.process(buffer);
+    }
+
+    // Starts a new program on both taps: integrated loudness, LRA, maxima
+    // and overs. For an offline bounce, so the report covers just the bounce.
+    void resetProgram()
+    {
+        inputMeter.resetIntegratedLoudness();
+        outputMeter.resetIntegratedLoudness();
+    }
+
+    // Delivery standards checked against the output over the current program
+    LoudnessCompliance::Report getComplianceReport() const { return outputMeter.getComplianceReport(); }
+
+    // Loudness over time for each tap; they keep running across reset()
+    const LoudnessHistory& getInputHistory() const { return inputHistory; }
+    const LoudnessHistory& getOutputHistory() const { return outputHistory; }
+
+    void resetHistory()
+    {
+        inputHistory.requestReset();
+        outputHistory.requestReset();
+    }
+
+    LoudnessMeter& getInputMeter() { return inputMeter; }
+    const LoudnessMeter& getInputMeter() const { return inputMeter; }
+    const LoudnessMeter& getOutputMeter() const { return outputMeter; }
+
+    // A level from the input tap as seen after a gain applied downstream of it
+    static float offsetLevel(float levelDB, float gainDB)
+    {
+        return levelDB <= DSPUtils::MINUS_INFINITY_DB ? levelDB : levelDB + gainDB;
+    }
+
+    float getTrimmedInputPeakL(float trimDB) const { return offsetLevel(inputMeter.getPeakLevelL(), trimDB); }
+    float getTrimmedInputPeakR(float trimDB) const { return offsetLevel(inputMeter.getPeakLevelR(), trimDB); }
+    float getTrimmedInputLUFS(float trimDB) const { return offsetLevel(inputMeter.getShortTermLUFS(), trimDB); }
+
+private:
+    double currentSampleRate = 44100.0;
+    int currentBlockSize = 512;
+    juce::AudioChannelSet currentLayout;
+    bool isPrepared = false;
+
+    LoudnessMeter inputMeter;
+    LoudnessMeter outputMeter;
+    LoudnessHistory inputHistory;
+    LoudnessHistory outputHistory;
+};
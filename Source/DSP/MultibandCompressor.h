@@ -16,21 +16,15 @@ public:
         currentBlockSize = samplesPerBlock;
 
         // Prepare crossovers
-        for (int ch = 0; ch < 2; ++ch)
-        {
-            crossover1[ch].prepare(sampleRate);
-            crossover2[ch].prepare(sampleRate);
-        }
+        crossover1.forEach([sampleRate] (auto& crossover) { crossover.prepare(sampleRate); });
+        crossover2.forEach([sampleRate] (auto& crossover) { crossover.prepare(sampleRate); });
 
-        // Prepare envelope followers
+        // Prepare envelope followers (one per band, linked across channels)
         for (int band = 0; band < NUM_BANDS; ++band)
         {
-            for (int ch = 0; ch < 2; ++ch)
-            {
-                envelopeFollowers[band][ch].prepare(sampleRate);
-                envelopeFollowers[band][ch].setAttackTime(bandAttack[band]);
-                envelopeFollowers[band][ch].setReleaseTime(bandRelease[band]);
-            }
+            envelopeFollowers[band].prepare(sampleRate);
+            envelopeFollowers[band].setAttackTime(bandAttack[band]);
+            envelopeFollowers[band].setReleaseTime(bandRelease[band]);
         }
 
         updateCrossovers();
@@ -39,100 +33,87 @@ public:
 
     void reset()
     {
-        for (int ch = 0; ch < 2; ++ch)
-        {
-            crossover1[ch].reset();
-            crossover2[ch].reset();
-        }
+        crossover1.forEach([] (auto& crossover) { crossover.reset(); });
+        crossover2.forEach([] (auto& crossover) { crossover.reset(); });
 
         for (int band = 0; band < NUM_BANDS; ++band)
         {
-            for (int ch = 0; ch < 2; ++ch)
-                envelopeFollowers[band][ch].reset();
+            envelopeFollowers[band].reset();
             gainReduction[band].store(0.0f);
         }
     }
 
-    void process(juce::AudioBuffer<float>& buffer)
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer)
     {
         if (bypassed)
             return;
 
         const int numSamples = buffer.getNumSamples();
-        const int numChannels = std::min(buffer.getNumChannels(), 2);
+        const int numChannels = std::min(buffer.getNumChannels(), DSPUtils::MAX_CHANNELS);
+        auto* const* channels = buffer.getArrayOfWritePointers();
 
-        // Process sample by sample
-        for (int sample = 0; sample < numSamples; ++sample)
-        {
-            std::array<float, 2> input;
-            for (int ch = 0; ch < numChannels; ++ch)
-                input[ch] = buffer.getSample(ch, sample);
+        auto& lowMidSplit = crossover1.get<SampleType>();
+        auto& midHighSplit = crossover2.get<SampleType>();
 
-            // Split into bands for each channel
-            std::array<std::array<float, NUM_BANDS>, 2> bands;
+        std::array<float, NUM_BANDS> thresholdLinear;
+        for (int band = 0; band < NUM_BANDS; ++band)
+            thresholdLinear[band] = DSPUtils::decibelsToLinear(bandThreshold[band]);
 
-            for (int ch = 0; ch < numChannels; ++ch)
-            {
-                float low, midHigh;
-                crossover1[ch].process(input[ch], low, midHigh);
+        DSPUtils::ChannelFrame<SampleType> input, midHigh;
+        std::array<DSPUtils::ChannelFrame<SampleType>, NUM_BANDS> bands;
+        std::array<float, NUM_BANDS> bandGR = { 0.0f, 0.0f, 0.0f };
 
-                float mid, high;
-                crossover2[ch].process(midHigh, mid, high);
+        // Process sample by sample, all channels at once
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            DSPUtils::readFrame(channels, numChannels, sample, input);
 
-                bands[ch][0] = low;
-                bands[ch][1] = mid;
-                bands[ch][2] = high;
-            }
+            // Split into bands
+            lowMidSplit.process(input, bands[0], midHigh, numChannels);
+            midHighSplit.process(midHigh, bands[1], bands[2], numChannels);
 
             // Compress each band
-            std::array<float, NUM_BANDS> bandGR = { 0.0f, 0.0f, 0.0f };
+            bandGR.fill(0.0f);
 
             for (int band = 0; band < NUM_BANDS; ++band)
             {
                 if (!bandEnabled[band])
                     continue;
 
-                float thresholdLinear = DSPUtils::decibelsToLinear(bandThreshold[band]);
+                // Linked detection: the loudest channel drives one shared envelope,
+                // so the image doesn't shift when a single channel peaks
+                float envelope = envelopeFollowers[band].process(static_cast<float>(bands[band].getMaxAbs(numChannels)));
 
-                for (int ch = 0; ch < numChannels; ++ch)
+                // Calculate gain reduction
+                float gr = 0.0f;
+                if (envelope > thresholdLinear[band])
                 {
-                    // Get envelope
-                    float envelope = envelopeFollowers[band][ch].process(bands[ch][band]);
-
-                    // Calculate gain reduction
-                    float gr = 0.0f;
-                    if (envelope > thresholdLinear)
-                    {
-                        float envelopeDB = DSPUtils::linearToDecibels(envelope);
-                        float threshDB = bandThreshold[band];
-                        float excessDB = envelopeDB - threshDB;
-
-                        // Apply compression ratio
-                        float compressedExcess = excessDB / bandRatio[band];
-                        gr = excessDB - compressedExcess;
-                    }
-
-                    // Apply gain reduction + makeup
-                    float gainDB = -gr + bandMakeup[band];
-                    float gainLinear = DSPUtils::decibelsToLinear(gainDB);
-                    bands[ch][band] *= gainLinear;
-
-                    // Track max GR for metering
-                    bandGR[band] = std::max(bandGR[band], gr);
+                    float envelopeDB = DSPUtils::linearToDecibels(envelope);
+                    float threshDB = bandThreshold[band];
+                    float excessDB = envelopeDB - threshDB;
+
+                    // Apply compression ratio
+                    float compressedExcess = excessDB / bandRatio[band];
+                    gr = excessDB - compressedExcess;
                 }
-            }
 
-            // Store gain reduction for metering
-            for (int band = 0; band < NUM_BANDS; ++band)
-                gainReduction[band].store(bandGR[band]);
+                // Apply gain reduction + makeup
+                float gainDB = -gr + bandMakeup[band];
+                bands[band].multiply(static_cast<SampleType>(DSPUtils::decibelsToLinear(gainDB)), numChannels);
+
+                bandGR[band] = gr;
+            }
 
             // Sum bands back together
             for (int ch = 0; ch < numChannels; ++ch)
-            {
-                float output = bands[ch][0] + bands[ch][1] + bands[ch][2];
-                buffer.setSample(ch, sample, output);
-            }
+                channels[ch][sample] = bands[0][ch] + bands[1][ch] + bands[2][ch];
         }
+
+        // Publish the last sample's gain reduction once per block rather than
+        // per sample, keeping the metering cache line out of the inner loop
+        for (int band = 0; band < NUM_BANDS; ++band)
+            gainReduction[band].store(bandGR[band]);
     }
 
     // Crossover controls
@@ -166,8 +147,7 @@ public:
         if (band >= 0 && band < NUM_BANDS)
         {
             bandAttack[band] = juce::jlimit(0.1f, 100.0f, attackMs);
-            for (int ch = 0; ch < 2; ++ch)
-                envelopeFollowers[band][ch].setAttackTime(bandAttack[band]);
+            envelopeFollowers[band].setAttackTime(bandAttack[band]);
         }
     }
 
@@ -176,8 +156,7 @@ public:
         if (band >= 0 && band < NUM_BANDS)
         {
             bandRelease[band] = juce::jlimit(10.0f, 1000.0f, releaseMs);
-            for (int ch = 0; ch < 2; ++ch)
-                envelopeFollowers[band][ch].setReleaseTime(bandRelease[band]);
+            envelopeFollowers[band].setReleaseTime(bandRelease[band]);
         }
     }
 
@@ -223,11 +202,8 @@ public:
 private:
     void updateCrossovers()
     {
-        for (int ch = 0; ch < 2; ++ch)
-        {
-            crossover1[ch].setCrossoverFrequency(lowMidCrossover);
-            crossover2[ch].setCrossoverFrequency(midHighCrossover);
-        }
+        crossover1.forEach([this] (auto& crossover) { crossover.setCrossoverFrequency(lowMidCrossover); });
+        crossover2.forEach([this] (auto& crossover) { crossover.setCrossoverFrequency(midHighCrossover); });
     }
 
     double currentSampleRate = 44100.0;
@@ -238,9 +214,9 @@ private:
     float lowMidCrossover = 200.0f;
     float midHighCrossover = 3000.0f;
 
-    // Crossover filters (Linkwitz-Riley 4th order)
-    DSPUtils::LinkwitzRileyCrossover crossover1[2];  // Low-Mid split
-    DSPUtils::LinkwitzRileyCrossover crossover2[2];  // Mid-High split
+    // Crossover filters (Linkwitz-Riley 4th order), one set per sample type
+    DSPUtils::PerSampleType<DSPUtils::MultiChannelCrossover> crossover1;  // Low-Mid split
+    DSPUtils::PerSampleType<DSPUtils::MultiChannelCrossover> crossover2;  // Mid-High split
 
     // Per-band compressor settings (gentler defaults to preserve macrodynamics)
     std::array<float, NUM_BANDS> bandThreshold = { -10.0f, -8.0f, -6.0f };
@@ -250,9 +226,9 @@ private:
     std::array<float, NUM_BANDS> bandMakeup = { 0.0f, 0.0f, 0.0f };
     std::array<bool, NUM_BANDS> bandEnabled = { true, true, true };
 
-    // Envelope followers per band per channel
-    DSPUtils::EnvelopeFollower envelopeFollowers[NUM_BANDS][2];
+    // Envelope followers per band (linked across channels)
+    DSPUtils::EnvelopeFollower envelopeFollowers[NUM_BANDS];
 
-    // Gain reduction metering
-    std::array<std::atomic<float>, NUM_BANDS> gainReduction = { 0.0f, 0.0f, 0.0f };
+    // Gain reduction metering (own cache line: written by the audio thread, polled by the UI)
+    alignas(DSPUtils::CACHE_LINE_SIZE) std::array<std::atomic<float>, NUM_BANDS> gainReduction = { 0.0f, 0.0f, 0.0f };
 };
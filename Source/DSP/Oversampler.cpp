@@ -0,0 +1,3 @@
+// Oversampler implementation
+// All functionality is in the header file
+#include "Oversampler.h"
@@ -0,0 +1,280 @@
+#pragma once
+
+#include "DSPUtils.h"
+#include <juce_dsp/juce_dsp.h>
+#include <vector>
+
+// 4x oversampler: two cascaded 2x half-band equiripple FIR stages, with the
+// same filter specs as juce::dsp::Oversampling in max-quality FIR mode.
+//
+// The FIR designs are the expensive part of preparing an oversampler. They
+// are normalised to the sample rate, so one design per sample type serves
+// every instance in the process at any rate; it is computed the first time
+// it's needed and shared from then on. Per-instance state (delay lines and
+// the oversampled buffer) comes from the owner's StateArena.
+template <typename SampleType>
+class Oversampler
+{
+public:
+    static constexpr int NUM_STAGES = 2;
+    static constexpr int FACTOR = 1 << NUM_STAGES;
+
+    // Records the size of the state; nothing is allocated until allocateState()
+    void prepare(int numChannels, int maxSamplesPerBlock)
+    {
+        currentNumChannels = juce::jlimit(1, DSPUtils::MAX_CHANNELS, numChannels);
+        maxBlockSize = std::max(1, maxSamplesPerBlock);
+    }
+
+    void allocateState(DSPUtils::StateArena& arena)
+    {
+        const auto& designs = getSharedDesigns();
+        int samplesIn = maxBlockSize;
+
+        for (int s = 0; s < NUM_STAGES; ++s)
+        {
+            stages[s].allocate(arena, designs[s], currentNumChannels, samplesIn);
+            samplesIn *= 2;
+        }
+    }
+
+    void reset()
+    {
+        for (auto& stage : stages)
+            stage.reset();
+    }
+
+    // Drops the views into an arena that is about to be rebuilt
+    void releaseState()
+    {
+        stages = {};
+    }
+
+    bool isAllocated() const { return !stages[0].buffer.isEmpty(); }
+
+    // Filter latency at the original rate (fractional, like juce::dsp::Oversampling)
+    SampleType getLatencyInSamples() const
+    {
+        const auto& designs = getSharedDesigns();
+        SampleType latency = 0;
+        int order = 1;
+
+        for (const auto& design : designs)
+        {
+            order *= 2;
+            latency += static_cast<SampleType>(design.up.order + design.down.order) * SampleType(0.5) / static_cast<SampleType>(order);
+        }
+
+        return latency;
+    }
+
+    juce::dsp::AudioBlock<SampleType> processSamplesUp(const juce::dsp::AudioBlock<SampleType>& inputBlock)
+    {
+        const int numChannels = std::min(static_cast<int>(inputBlock.getNumChannels()), currentNumChannels);
+        int numSamples = static_cast<int>(inputBlock.getNumSamples());
+        jassert(numSamples <= maxBlockSize);
+
+        std::array<const SampleType*, DSPUtils::MAX_CHANNELS> input {};
+        for (int ch = 0; ch < numChannels; ++ch)
+            input[static_cast<size_t>(ch)] = inputBlock.getChannelPointer(static_cast<size_t>(ch));
+
+        for (int s = 0; s < NUM_STAGES; ++s)
+        {
+            stages[s].processUp(input.data(), numChannels, numSamples);
+            numSamples *= 2;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                input[static_cast<size_t>(ch)] = stages[s].getChannel(ch);
+        }
+
+        auto& last = stages[NUM_STAGES - 1];
+        return juce::dsp::AudioBlock<SampleType>(last.channelPointers.data(),
+                                                 static_cast<size_t>(numChannels),
+                                                 static_cast<size_t>(numSamples));
+    }
+
+    void processSamplesDown(juce::dsp::AudioBlock<SampleType>& outputBlock)
+    {
+        const int numChannels = std::min(static_cast<int>(outputBlock.getNumChannels()), currentNumChannels);
+        const int numSamples = static_cast<int>(outputBlock.getNumSamples());
+
+        // Each stage decimates the buffer of the stage above it; the last
+        // stage's own buffer holds the (already processed) 4x signal
+        for (int s = NUM_STAGES - 1; s > 0; --s)
+            stages[s].processDown(stages[s - 1].channelPointers.data(), numChannels, numSamples << s);
+
+        std::array<SampleType*, DSPUtils::MAX_CHANNELS> output {};
+        for (int ch = 0; ch < numChannels; ++ch)
+            output[static_cast<size_t>(ch)] = outputBlock.getChannelPointer(static_cast<size_t>(ch));
+
+        stages[0].processDown(output.data(), numChannels, numSamples);
+    }
+
+private:
+    struct HalfBandFilter
+    {
+        std::vector<SampleType> coefficients;
+        int order = 0;
+
+        void design(SampleType normalisedTransitionWidth, SampleType amplitudedB)
+        {
+            auto fir = juce::dsp::FilterDesign<SampleType>::designFIRLowpassHalfBandEquirippleMethod(
+                normalisedTransitionWidth, amplitudedB);
+
+            order = static_cast<int>(fir->getFilterOrder());
+            coefficients.assign(fir->getRawCoefficients(), fir->getRawCoefficients() + order + 1);
+        }
+    };
+
+    struct StageDesign
+    {
+        HalfBandFilter up, down;
+    };
+
+    // Designed once per process; same transition widths and stopband levels
+    // juce::dsp::Oversampling uses for isMaxQuality
+    static const std::array<StageDesign, NUM_STAGES>& getSharedDesigns()
+    {
+        static const std::array<StageDesign, NUM_STAGES> designs = []
+        {
+            std::array<StageDesign, NUM_STAGES> result;
+
+            for (int n = 0; n < NUM_STAGES; ++n)
+            {
+                const SampleType widthUp = SampleType(0.10) * (n == 0 ? SampleType(0.5) : SampleType(1));
+                const SampleType widthDown = SampleType(0.12) * (n == 0 ? SampleType(0.5) : SampleType(1));
+
+                result[static_cast<size_t>(n)].up.design(widthUp, SampleType(-90) + SampleType(10) * n);
+                result[static_cast<size_t>(n)].down.design(widthDown, SampleType(-75) + SampleType(10) * n);
+            }
+
+            return result;
+        }();
+
+        return designs;
+    }
+
+    // One 2x stage: polyphase half-band interpolation up, decimation down
+    struct Stage
+    {
+        const StageDesign* design = nullptr;
+        int numChannels = 0;
+        int bufferLength = 0;
+        int upLength = 0;
+        int downLength = 0;
+        int down2Length = 0;
+
+        // Channel-major arena memory
+        DSPUtils::StateArray<SampleType> buffer;
+        DSPUtils::StateArray<SampleType> stateUp;
+        DSPUtils::StateArray<SampleType> stateDown;
+        DSPUtils::StateArray<SampleType> stateDown2;
+        DSPUtils::StateArray<int> position;
+        std::array<SampleType*, DSPUtils::MAX_CHANNELS> channelPointers {};
+
+        void allocate(DSPUtils::StateArena& arena, const StageDesign& stageDesign, int channels, int maxSamplesIn)
+        {
+            design = &stageDesign;
+            numChannels = channels;
+            bufferLength = maxSamplesIn * 2;
+            upLength = stageDesign.up.order + 1;
+            downLength = stageDesign.down.order + 1;
+            down2Length = downLength / 4 + 1;
+
+            buffer = arena.allocate<SampleType>(numChannels * bufferLength);
+            stateUp = arena.allocate<SampleType>(numChannels * upLength);
+            stateDown = arena.allocate<SampleType>(numChannels * downLength);
+            stateDown2 = arena.allocate<SampleType>(numChannels * down2Length);
+            position = arena.allocate<int>(numChannels);
+
+            channelPointers.fill(nullptr);
+            if (!buffer.isEmpty())
+                for (int ch = 0; ch < numChannels; ++ch)
+                    channelPointers[static_cast<size_t>(ch)] = buffer.data + ch * bufferLength;
+        }
+
+        void reset()
+        {
+            std::fill(buffer.begin(), buffer.end(), SampleType(0));
+            std::fill(stateUp.begin(), stateUp.end(), SampleType(0));
+            std::fill(stateDown.begin(), stateDown.end(), SampleType(0));
+            std::fill(stateDown2.begin(), stateDown2.end(), SampleType(0));
+            std::fill(position.begin(), position.end(), 0);
+        }
+
+        SampleType* getChannel(int ch) { return channelPointers[static_cast<size_t>(ch)]; }
+
+        void processUp(const SampleType* const* input, int channels, int numSamples)
+        {
+            const SampleType* fir = design->up.coefficients.data();
+            const int N = upLength;
+            const int Ndiv2 = N / 2;
+
+            for (int ch = 0; ch < channels; ++ch)
+            {
+                SampleType* out = getChannel(ch);
+                SampleType* buf = stateUp.data + ch * upLength;
+                const SampleType* samples = input[ch];
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    buf[N - 1] = 2 * samples[i];
+
+                    // Symmetric taps; odd taps of a half-band filter are zero
+                    SampleType acc = 0;
+                    for (int k = 0; k < Ndiv2; k += 2)
+                        acc += (buf[k] + buf[N - k - 1]) * fir[k];
+
+                    out[i << 1] = acc;
+                    out[(i << 1) + 1] = buf[Ndiv2 + 1] * fir[Ndiv2];
+
+                    for (int k = 0; k < N - 2; k += 2)
+                        buf[k] = buf[k + 2];
+                }
+            }
+        }
+
+        // Decimates this stage's buffer into output
+        void processDown(SampleType* const* output, int channels, int numSamples)
+        {
+            const SampleType* fir = design->down.coefficients.data();
+            const int N = downLength;
+            const int Ndiv2 = N / 2;
+            const int Ndiv4 = Ndiv2 / 2;
+
+            for (int ch = 0; ch < channels; ++ch)
+            {
+                const SampleType* in = getChannel(ch);
+                SampleType* buf = stateDown.data + ch * downLength;
+                SampleType* buf2 = stateDown2.data + ch * down2Length;
+                SampleType* samples = output[ch];
+                int pos = position[ch];
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    buf[N - 1] = in[i << 1];
+
+                    SampleType acc = 0;
+                    for (int k = 0; k < Ndiv2; k += 2)
+                        acc += (buf[k] + buf[N - k - 1]) * fir[k];
+
+                    acc += buf2[pos] * fir[Ndiv2];
+                    buf2[pos] = in[(i << 1) + 1];
+
+                    samples[i] = acc;
+
+                    for (int k = 0; k < N - 2; ++k)
+                        buf[k] = buf[k + 2];
+
+                    pos = (pos == 0 ? Ndiv4 : pos - 1);
+                }
+
+                position[ch] = pos;
+            }
+        }
+    };
+
+    int currentNumChannels = 2;
+    int maxBlockSize = 512;
+    std::array<Stage, NUM_STAGES> stages;
+};
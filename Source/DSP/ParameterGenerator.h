@@ -382,8 +382,10 @@ private:
     LimiterParameters generateLimiterToMatchReference(const AnalysisEngine::AnalysisResults& analysis,
                                                        const ReferenceProfile& reference)
     {
-        // Target the reference's loudness
-        float targetLUFS = reference.getLoudnessRMS() + 4.0f;  // Rough conversion RMS to LUFS
+        // Target the reference's loudness; genre presets only have an RMS
+        float targetLUFS = reference.getIntegratedLoudness() > -70.0f
+                               ? reference.getIntegratedLoudness()
+                               : reference.getLoudnessRMS() + 4.0f;  // Rough conversion RMS to LUFS
         targetLUFS = juce::jlimit(-24.0f, -6.0f, targetLUFS);
 
         return generateLimiterParameters(analysis, targetLUFS);
@@ -0,0 +1,3 @@
+// ParameterHistory implementation
+// All functionality is in the header file
+#include "ParameterHistory.h"
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "ParameterSnapshot.h"
+#include <array>
+#include <cstdint>
+
+// Undo/redo history of parameter snapshots, stored as deltas.
+//
+// Each entry records only the values that changed, with the value before
+// and after, so stepping either way costs one pass over that entry's
+// changes. Entries and changes live in two fixed rings. Recording never
+// allocates; once the rings are full the oldest entries are dropped.
+class ParameterHistory
+{
+public:
+    static constexpr int MAX_ENTRIES = 256;
+    static constexpr int MAX_CHANGES = 4096;
+
+    enum class Source : uint8_t
+    {
+        User,
+        AutoMaster,
+        Recall
+    };
+
+    // Starts a new history at the given state
+    void reset(const ParameterSnapshot& initial)
+    {
+        current = initial;
+        firstEntry = 0;
+        numEntries = 0;
+        numApplied = 0;
+        firstChange = 0;
+        changeEnd = 0;
+    }
+
+    // Appends the difference from the current state; returns false if nothing
+    // changed. Any redo steps past the current position are discarded.
+    bool record(const ParameterSnapshot& snapshot, Source source)
+    {
+        int numChanges = 0;
+        for (int i = 0; i < ParameterSnapshot::NUM_VALUES; ++i)
+            if (snapshot[i] != current[i])
+                ++numChanges;
+
+        if (numChanges == 0)
+            return false;
+
+        // Drop the redo tail
+        numEntries = numApplied;
+        changeEnd = numEntries > 0 ? getEntry(numEntries - 1).end() : firstChange;
+
+        // Make room in both rings
+        while (numEntries > 0 && (numEntries == MAX_ENTRIES || changeEnd + numChanges - firstChange > MAX_CHANGES))
+            dropOldestEntry();
+
+        if (numEntries == 0)
+            firstChange = changeEnd;
+
+        Entry& entry = entries[static_cast<size_t>((firstEntry + numEntries) % MAX_ENTRIES)];
+        entry.firstChange = changeEnd;
+        entry.numChanges = numChanges;
+        entry.source = source;
+
+        for (int i = 0; i < ParameterSnapshot::NUM_VALUES; ++i)
+        {
+            if (snapshot[i] != current[i])
+            {
+                changes[static_cast<size_t>(changeEnd % MAX_CHANGES)] = { static_cast<uint8_t>(i), current[i], snapshot[i] };
+                ++changeEnd;
+            }
+        }
+
+        ++numEntries;
+        numApplied = numEntries;
+        current = snapshot;
+        return true;
+    }
+
+    bool canUndo() const { return numApplied > 0; }
+    bool canRedo() const { return numApplied < numEntries; }
+
+    // Steps back one entry and returns the resulting state
+    const ParameterSnapshot& undo()
+    {
+        if (canUndo())
+        {
+            const Entry& entry = getEntry(--numApplied);
+            for (int64_t c = entry.firstChange; c < entry.end(); ++c)
+            {
+                const Change& change = changes[static_cast<size_t>(c % MAX_CHANGES)];
+                current[change.index] = change.before;
+            }
+        }
+
+        return current;
+    }
+
+    // Steps forward one entry and returns the resulting state
+    const ParameterSnapshot& redo()
+    {
+        if (canRedo())
+        {
+            const Entry& entry = getEntry(numApplied++);
+            for (int64_t c = entry.firstChange; c < entry.end(); ++c)
+            {
+                const Change& change = changes[static_cast<size_t>(c % MAX_CHANGES)];
+                current[change.index] = change.after;
+            }
+        }
+
+        return current;
+    }
+
+    const ParameterSnapshot& getCurrent() const { return current; }
+
+    // Source of the entry the next undo() would revert
+    Source getUndoSource() const { return canUndo() ? getEntry(numApplied - 1).source : Source::User; }
+
+    int getNumEntries() const { return numEntries; }
+    int getPosition() const { return numApplied; }
+
+private:
+    struct Change
+    {
+        uint8_t index;
+        float before;
+        float after;
+    };
+
+    struct Entry
+    {
+        int64_t firstChange = 0;  // Running position in the change ring
+        int numChanges = 0;
+        Source source = Source::User;
+
+        int64_t end() const { return firstChange + numChanges; }
+    };
+
+    const Entry& getEntry(int i) const { return entries[static_cast<size_t>((firstEntry + i) % MAX_ENTRIES)]; }
+
+    void dropOldestEntry()
+    {
+        firstChange = getEntry(0).end();
+        firstEntry = (firstEntry + 1) % MAX_ENTRIES;
+        --numEntries;
+        numApplied = std::max(0, numApplied - 1);
+    }
+
+    ParameterSnapshot current;
+
+    std::array<Entry, MAX_ENTRIES> entries {};
+    int firstEntry = 0;
+    int numEntries = 0;
+    int numApplied = 0;  // Entries [0, numApplied) are reflected in current
+
+    std::array<Change, MAX_CHANGES> changes {};
+    int64_t firstChange = 0;  // Running position of the oldest entry's first change
+    int64_t changeEnd = 0;
+};
@@ -0,0 +1,3 @@
+// ParameterSnapshot implementation
+// All functionality is in the header file
+#include "ParameterSnapshot.h"
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "ParameterGenerator.h"
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+// Every plugin parameter as one flat, trivially copyable block of floats:
+// the GeneratedParameters fields plus global gains, bypasses and the
+// limiter's auto-gain. Switches are stored as 0/1. Comparison slots, the
+// undo history and learning all use this one format, so copying, comparing
+// and storing a full parameter set never touches the heap.
+struct ParameterSnapshot
+{
+    enum Index : uint8_t
+    {
+        // Global
+        InputGain, OutputGain, TargetLUFS, AutoMasterEnabled,
+
+        // EQ
+        HPFFreq, HPFEnabled, LPFFreq, LPFEnabled,
+        LowShelfFreq, LowShelfGain, HighShelfFreq, HighShelfGain,
+        BandFreq1, BandFreq2, BandFreq3, BandFreq4,
+        BandGain1, BandGain2, BandGain3, BandGain4,
+        BandQ1, BandQ2, BandQ3, BandQ4,
+        EQBypass,
+
+        // Compressor
+        LowMidCrossover, MidHighCrossover,
+        CompThreshold1, CompThreshold2, CompThreshold3,
+        CompRatio1, CompRatio2, CompRatio3,
+        CompAttack1, CompAttack2, CompAttack3,
+        CompRelease1, CompRelease2, CompRelease3,
+        CompMakeup1, CompMakeup2, CompMakeup3,
+        CompBypass,
+
+        // Stereo
+        GlobalWidth, LowWidth, MidWidth, HighWidth, MonoBassFreq, MonoBassEnabled, StereoBypass,
+
+        // Limiter
+        Ceiling, LimiterRelease, LimiterBypass,
+
+        // Host-visible parameters end here; the rest is processor state
+        NUM_PARAMETERS,
+        LimiterAutoGain = NUM_PARAMETERS,
+
+        NUM_VALUES
+    };
+
+    std::array<float, NUM_VALUES> values {};
+
+    float& operator[](int index) { return values[static_cast<size_t>(index)]; }
+    float operator[](int index) const { return values[static_cast<size_t>(index)]; }
+
+    bool operator==(const ParameterSnapshot& other) const { return values == other.values; }
+    bool operator!=(const ParameterSnapshot& other) const { return values != other.values; }
+
+    // Fills every field GeneratedParameters carries; confidence isn't a parameter
+    ParameterGenerator::GeneratedParameters toGeneratedParameters() const
+    {
+        ParameterGenerator::GeneratedParameters params;
+        const auto& v = *this;
+
+        params.eq.hpfEnabled = v[HPFEnabled] > 0.5f;
+        params.eq.hpfFreq = v[HPFFreq];
+        params.eq.lpfEnabled = v[LPFEnabled] > 0.5f;
+        params.eq.lpfFreq = v[LPFFreq];
+        params.eq.lowShelfFreq = v[LowShelfFreq];
+        params.eq.lowShelfGain = v[LowShelfGain];
+        params.eq.highShelfFreq = v[HighShelfFreq];
+        params.eq.highShelfGain = v[HighShelfGain];
+
+        for (int i = 0; i < 4; ++i)
+        {
+            params.eq.bandFreq[i] = v[BandFreq1 + i];
+            params.eq.bandGain[i] = v[BandGain1 + i];
+            params.eq.bandQ[i] = v[BandQ1 + i];
+        }
+
+        params.comp.lowMidCrossover = v[LowMidCrossover];
+        params.comp.midHighCrossover = v[MidHighCrossover];
+
+        for (int i = 0; i < 3; ++i)
+        {
+            params.comp.threshold[i] = v[CompThreshold1 + i];
+            params.comp.ratio[i] = v[CompRatio1 + i];
+            params.comp.attack[i] = v[CompAttack1 + i];
+            params.comp.release[i] = v[CompRelease1 + i];
+            params.comp.makeup[i] = v[CompMakeup1 + i];
+        }
+
+        params.stereo.globalWidth = v[GlobalWidth];
+        params.stereo.lowWidth = v[LowWidth];
+        params.stereo.midWidth = v[MidWidth];
+        params.stereo.highWidth = v[HighWidth];
+        params.stereo.monoBassEnabled = v[MonoBassEnabled] > 0.5f;
+        params.stereo.monoBassFreq = v[MonoBassFreq];
+
+        params.limiter.ceiling = v[Ceiling];
+        params.limiter.release = v[LimiterRelease];
+        params.limiter.targetLUFS = v[TargetLUFS];
+        params.limiter.autoGain = v[LimiterAutoGain];
+
+        return params;
+    }
+
+    // Overwrites the fields GeneratedParameters carries; gains and bypasses keep their values
+    void setGeneratedParameters(const ParameterGenerator::GeneratedParameters& params)
+    {
+        auto& v = *this;
+
+        v[HPFEnabled] = params.eq.hpfEnabled ? 1.0f : 0.0f;
+        v[HPFFreq] = params.eq.hpfFreq;
+        v[LPFEnabled] = params.eq.lpfEnabled ? 1.0f : 0.0f;
+        v[LPFFreq] = params.eq.lpfFreq;
+        v[LowShelfFreq] = params.eq.lowShelfFreq;
+        v[LowShelfGain] = params.eq.lowShelfGain;
+        v[HighShelfFreq] = params.eq.highShelfFreq;
+        v[HighShelfGain] = params.eq.highShelfGain;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            v[BandFreq1 + i] = params.eq.bandFreq[i];
+            v[BandGain1 + i] = params.eq.bandGain[i];
+            v[BandQ1 + i] = params.eq.bandQ[i];
+        }
+
+        v[LowMidCrossover] = params.comp.lowMidCrossover;
+        v[MidHighCrossover] = params.comp.midHighCrossover;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            v[CompThreshold1 + i] = params.comp.threshold[i];
+            v[CompRatio1 + i] = params.comp.ratio[i];
+            v[CompAttack1 + i] = params.comp.attack[i];
+            v[CompRelease1 + i] = params.comp.release[i];
+            v[CompMakeup1 + i] = params.comp.makeup[i];
+        }
+
+        v[GlobalWidth] = params.stereo.globalWidth;
+        v[LowWidth] = params.stereo.lowWidth;
+        v[MidWidth] = params.stereo.midWidth;
+        v[HighWidth] = params.stereo.highWidth;
+        v[MonoBassEnabled] = params.stereo.monoBassEnabled ? 1.0f : 0.0f;
+        v[MonoBassFreq] = params.stereo.monoBassFreq;
+
+        v[Ceiling] = params.limiter.ceiling;
+        v[LimiterRelease] = params.limiter.release;
+        v[TargetLUFS] = params.limiter.targetLUFS;
+        v[LimiterAutoGain] = params.limiter.autoGain;
+    }
+};
+
+static_assert(std::is_trivially_copyable_v<ParameterSnapshot>, "Snapshots are copied and stored as raw memory");
@@ -0,0 +1,3 @@
+// ReferenceCache implementation
+// All functionality is in the header file
+#include "ReferenceCache.h"
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "ReferenceProfile.h"
+#include "WaveformPyramid.h"
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Analysed references kept on disk, so loading the same file again skips
+// the decode. One small binary file per reference under the app data
+// directory, shared by every plugin instance and session.
+//
+// Entries are keyed by the audio file's path, size and modification time:
+// a hash of the three names the cache file, and the file repeats them in
+// full so a hash collision or an edited file reads as a miss. Files with
+// another FORMAT_VERSION are misses too and get overwritten. Writes go
+// through a temporary file, so another instance never reads half an entry.
+// write() doesn't bound the directory, since listing it per write would
+// make a library scan quadratic; callers trim() once after their writes.
+class ReferenceCache
+{
+public:
+    static constexpr int FORMAT_VERSION = 2;
+    static constexpr int MAX_ENTRIES = 4096;  // Room for a whole library; oldest-written entries go first
+
+    struct Entry
+    {
+        ReferenceProfile profile;
+        WaveformPyramid waveform;
+        double durationSeconds = 0.0;
+    };
+
+    static juce::File getDefaultDirectory()
+    {
+        juce::File appData = juce::File::getSpecialLocation(
+            juce::File::userApplicationDataDirectory);
+        return appData.getChildFile("Automaster").getChildFile("ReferenceCache");
+    }
+
+    // True and fills dest if audioFile, as it is now, has a cached entry
+    static bool read(const juce::File& audioFile, Entry& dest, const juce::File& directory = getDefaultDirectory())
+    {
+        const juce::File cacheFile = getCacheFile(audioFile, directory);
+        if (!cacheFile.existsAsFile())
+            return false;
+
+        juce::FileInputStream stream(cacheFile);
+        if (!stream.openedOk())
+            return false;
+
+        if (stream.readInt() != MAGIC || stream.readInt() != FORMAT_VERSION)
+            return false;
+
+        if (stream.readString() != audioFile.getFullPathName()
+            || stream.readInt64() != audioFile.getSize()
+            || stream.readInt64() != audioFile.getLastModificationTime().toMilliseconds())
+            return false;
+
+        Entry entry;
+        entry.durationSeconds = stream.readDouble();
+        entry.profile.readFrom(stream);
+
+        if (!entry.waveform.readFrom(stream))
+            return false;
+
+        // Truncated files fail here rather than yielding zeros
+        if (stream.readInt() != MAGIC)
+            return false;
+
+        dest = std::move(entry);
+        return true;
+    }
+
+    // Stores the analysis of audioFile as it is now; false if it couldn't be written
+    static bool write(const juce::File& audioFile, const Entry& entry, const juce::File& directory = getDefaultDirectory())
+    {
+        if (!directory.createDirectory())
+            return false;
+
+        // The temporary file gets its own extension, so a trim() running
+        // meanwhile doesn't take it for an entry and delete it
+        const juce::File cacheFile = getCacheFile(audioFile, directory);
+        juce::TemporaryFile temp(cacheFile, cacheFile.withFileExtension(TEMP_EXTENSION).getNonexistentSibling(false));
+
+        {
+            juce::FileOutputStream stream(temp.getFile());
+            if (!stream.openedOk())
+                return false;
+
+            stream.writeInt(MAGIC);
+            stream.writeInt(FORMAT_VERSION);
+            stream.writeString(audioFile.getFullPathName());
+            stream.writeInt64(audioFile.getSize());
+            stream.writeInt64(audioFile.getLastModificationTime().toMilliseconds());
+
+            stream.writeDouble(entry.durationSeconds);
+            entry.profile.writeTo(stream);
+
+            entry.waveform.writeTo(stream);
+
+            stream.writeInt(MAGIC);
+            stream.flush();
+        }
+
+        return temp.overwriteTargetFileWithTemporary();
+    }
+
+    // Keeps the newest MAX_ENTRIES entries
+    static void trim(const juce::File& directory = getDefaultDirectory())
+    {
+        auto files = directory.findChildFiles(juce::File::findFiles, false, "*.amref");
+        if (static_cast<int>(files.size()) <= MAX_ENTRIES)
+            return;
+
+        std::sort(files.begin(), files.end(), [](const juce::File& a, const juce::File& b)
+        {
+            return a.getLastModificationTime() > b.getLastModificationTime();
+        });
+
+        for (int i = MAX_ENTRIES; i < static_cast<int>(files.size()); ++i)
+            files[i].deleteFile();
+    }
+
+private:
+    static constexpr int MAGIC = 0x50524d41;  // "AMRP"
+    static constexpr const char* TEMP_EXTENSION = ".amtmp";
+
+    static juce::File getCacheFile(const juce::File& audioFile, const juce::File& directory)
+    {
+        const juce::String key = audioFile.getFullPathName() + "|" + juce::String(audioFile.getSize())
+                                 + "|" + juce::String(audioFile.getLastModificationTime().toMilliseconds());
+        return directory.getChildFile(juce::String::toHexString(key.hashCode64()) + ".amref");
+    }
+};
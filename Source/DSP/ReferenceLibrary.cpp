@@ -0,0 +1,3 @@
+// ReferenceLibrary implementation
+// All functionality is in the header file
+#include "ReferenceLibrary.h"
@@ -0,0 +1,227 @@
+#pragma once
+
+#include "ReferenceCache.h"
+#include "ReferenceLoader.h"
+#include "ReferenceProfile.h"
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A folder of reference tracks, profiled once into an index that can be
+// searched for the references closest to the current mix.
+//
+// scanFolder() indexes on a background thread: the folder's audio files are
+// shared out to up to MAX_THREADS workers, one file each at a time. Files
+// analysed before come from ReferenceCache, and new analyses go into it, so
+// a rescan of an unchanged library costs only the cache reads.
+//
+// The index keeps every reference's ReferenceProfile::MatchFeatures in one
+// flat array. findClosest() scores all of them with
+// ReferenceProfile::scoreMatch() in a brute-force pass. Features are a few
+// dozen floats, so even several thousand references take well under a
+// millisecond; a spatial tree wouldn't pay off at this dimensionality.
+class ReferenceLibrary : private juce::Thread
+{
+public:
+    static constexpr int MAX_THREADS = 8;
+    static constexpr const char* FILE_PATTERN = "*.wav;*.aif;*.aiff;*.flac;*.mp3;*.ogg";
+
+    struct Match
+    {
+        juce::File file;
+        float score = 0.0f;  // 0-100, as calculateMatchScore()
+    };
+
+    ReferenceLibrary()
+        : juce::Thread("Reference library")
+    {
+    }
+
+    ~ReferenceLibrary() override
+    {
+        cancel();
+    }
+
+    // Called on the indexing thread when a scan has replaced the index (not
+    // when cancelled). Set before the first scan.
+    std::function<void()> onScanComplete;
+
+    // Indexes the audio files in folder and its subfolders, replacing the
+    // current index when done. False if folder isn't a directory.
+    bool scanFolder(const juce::File& folder)
+    {
+        cancel();
+
+        if (!folder.isDirectory())
+            return false;
+
+        scanningFolder = folder;
+        progress.store(0.0f);
+        scanning.store(true);
+        startThread(juce::Thread::Priority::low);
+        return true;
+    }
+
+    void cancel()
+    {
+        stopThread(4000);
+        scanning.store(false);
+    }
+
+    bool isScanning() const { return scanning.load(); }
+    float getProgress() const { return progress.load(); }
+
+    // True once after each completed scan
+    bool takeScanCompleted() { return scanCompleted.exchange(false); }
+
+    juce::File getFolder() const
+    {
+        const std::lock_guard<std::mutex> lock(indexMutex);
+        return indexedFolder;
+    }
+
+    int getNumReferences() const
+    {
+        const std::lock_guard<std::mutex> lock(indexMutex);
+        return static_cast<int>(files.size());
+    }
+
+    // The best maxMatches references for the given features, best first.
+    // Any thread but the audio thread.
+    std::vector<Match> findClosest(const ReferenceProfile::MatchFeatures& current, int maxMatches = 1) const
+    {
+        const std::lock_guard<std::mutex> lock(indexMutex);
+
+        const size_t numReferences = files.size();
+        scores.resize(numReferences);
+
+        const float* row = features.data();
+        for (size_t i = 0; i < numReferences; ++i, row += ReferenceProfile::NUM_MATCH_FEATURES)
+            scores[i] = ReferenceProfile::scoreMatch(row, current.data());
+
+        order.resize(numReferences);
+        for (size_t i = 0; i < numReferences; ++i)
+            order[i] = i;
+
+        const size_t count = std::min(numReferences, static_cast<size_t>(std::max(0, maxMatches)));
+        std::partial_sort(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(count), order.end(),
+                          [this](size_t a, size_t b) { return scores[a] > scores[b]; });
+
+        std::vector<Match> matches(count);
+        for (size_t i = 0; i < count; ++i)
+            matches[i] = { files[order[i]], scores[order[i]] };
+
+        return matches;
+    }
+
+private:
+    void run() override
+    {
+        auto found = scanningFolder.findChildFiles(juce::File::findFiles, true, FILE_PATTERN);
+        std::sort(found.begin(), found.end());
+
+        const size_t numFiles = static_cast<size_t>(found.size());
+        std::vector<ReferenceProfile::MatchFeatures> profiled(numFiles);
+        std::vector<char> valid(numFiles, 0);  // Written by one worker each, read after the join
+
+        std::atomic<size_t> nextFile { 0 };
+        std::atomic<size_t> filesDone { 0 };
+        std::atomic<bool> cacheWritten { false };
+
+        const auto work = [&]
+        {
+            for (size_t i = nextFile.fetch_add(1); i < numFiles && !threadShouldExit(); i = nextFile.fetch_add(1))
+            {
+                const juce::File file = found[static_cast<int>(i)];
+                ReferenceCache::Entry entry;
+                bool analysed = ReferenceCache::read(file, entry);
+
+                if (!analysed)
+                {
+                    auto reader = ReferenceLoader::createReader(file);
+                    if (reader != nullptr && reader->sampleRate > 0.0 && reader->lengthInSamples > 0)
+                    {
+                        analysed = ReferenceLoader::analyzeFile(file, std::move(reader), 1, entry, [this] { return threadShouldExit(); });
+                        if (analysed && ReferenceCache::write(file, entry))
+                            cacheWritten.store(true);
+                    }
+                }
+
+                if (analysed && entry.profile.isProfileValid())
+                {
+                    profiled[i] = entry.profile.getMatchFeatures();
+                    valid[i] = 1;
+                }
+
+                progress.store(static_cast<float>(filesDone.fetch_add(1) + 1) / static_cast<float>(numFiles));
+            }
+        };
+
+        const int numThreads = juce::jlimit(1, MAX_THREADS, std::min(juce::SystemStats::getNumCpus(), static_cast<int>(numFiles)));
+
+        std::vector<std::thread> threads;
+        for (int t = 1; t < numThreads; ++t)
+            threads.emplace_back(work);
+
+        work();
+
+        for (auto& thread : threads)
+            thread.join();
+
+        // Once per scan rather than per write
+        if (cacheWritten.load())
+            ReferenceCache::trim();
+
+        if (threadShouldExit())
+        {
+            scanning.store(false);
+            return;
+        }
+
+        // Compact into the flat index
+        std::vector<juce::File> indexFiles;
+        std::vector<float> indexFeatures;
+        for (size_t i = 0; i < numFiles; ++i)
+        {
+            if (valid[i] == 0)
+                continue;
+
+            indexFiles.push_back(found[static_cast<int>(i)]);
+            indexFeatures.insert(indexFeatures.end(), profiled[i].begin(), profiled[i].end());
+        }
+
+        {
+            const std::lock_guard<std::mutex> lock(indexMutex);
+            files = std::move(indexFiles);
+            features = std::move(indexFeatures);
+            indexedFolder = scanningFolder;
+        }
+
+        progress.store(1.0f);
+        scanCompleted.store(true);
+        scanning.store(false);
+
+        if (onScanComplete)
+            onScanComplete();
+    }
+
+    juce::File scanningFolder;
+
+    // The index; row i of features (NUM_MATCH_FEATURES floats) is files[i]
+    mutable std::mutex indexMutex;
+    std::vector<juce::File> files;
+    std::vector<float> features;
+    juce::File indexedFolder;
+
+    // Query scratch, guarded by indexMutex
+    mutable std::vector<float> scores;
+    mutable std::vector<size_t> order;
+
+    std::atomic<float> progress { 0.0f };
+    std::atomic<bool> scanning { false };
+    std::atomic<bool> scanCompleted { false };
+};
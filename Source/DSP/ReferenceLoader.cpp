@@ -0,0 +1,3 @@
+// ReferenceLoader implementation
+// All functionality is in the header file
+#include "ReferenceLoader.h"
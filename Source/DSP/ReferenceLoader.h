@@ -0,0 +1,243 @@
+#pragma once
+
+#include "ReferenceCache.h"
+#include "ReferenceProfile.h"
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Loads a reference track on a background thread: one decode of the whole
+// file, streamed in chunks through the profile accumulator and the waveform
+// pyramid together. Long files are split into stretches decoded on several
+// threads and merged (ReferenceProfile::Accumulator is additive). WAV and
+// AIFF are read through memory-mapped readers; other formats through their
+// normal reader. Positions are 64-bit throughout.
+//
+// The message thread starts and cancels loads and takes the result; the
+// loader thread reports progress and calls onLoadComplete when done.
+class ReferenceLoader : private juce::Thread
+{
+public:
+    static constexpr int MAX_THREADS = 8;
+    static constexpr double MIN_SECONDS_PER_THREAD = 20.0;
+
+    struct Result : ReferenceCache::Entry
+    {
+        juce::File file;
+    };
+
+    ReferenceLoader()
+        : juce::Thread("Reference loader")
+    {
+    }
+
+    ~ReferenceLoader() override
+    {
+        cancel();
+    }
+
+    // Called on the loader thread once a result is ready to take (not when
+    // cancelled). Set before the first load.
+    std::function<void()> onLoadComplete;
+
+    // Replaces any load in progress. Returns false if the file can't be
+    // opened; otherwise decoding carries on in the background.
+    bool load(const juce::File& file)
+    {
+        cancel();
+
+        reader = createReader(file);
+        if (reader == nullptr || reader->sampleRate <= 0.0 || reader->lengthInSamples < 1)
+        {
+            reader.reset();
+            return false;
+        }
+
+        loadingFile = file;
+        progress.store(0.0f);
+        loading.store(true);
+        startThread(juce::Thread::Priority::low);
+        return true;
+    }
+
+    // Also drops a finished result nobody has taken yet, so a cleared or
+    // replaced reference doesn't come back
+    void cancel()
+    {
+        stopThread(2000);
+        reader.reset();
+        loading.store(false);
+
+        const std::lock_guard<std::mutex> lock(resultMutex);
+        result = Result();
+        hasResult = false;
+    }
+
+    bool isLoading() const { return loading.load(); }
+    float getProgress() const { return progress.load(); }
+    const juce::File& getLoadingFile() const { return loadingFile; }
+
+    // Moves the finished result into dest, once per load
+    bool takeResult(Result& dest)
+    {
+        const std::lock_guard<std::mutex> lock(resultMutex);
+        if (!hasResult)
+            return false;
+
+        dest = std::move(result);
+        hasResult = false;
+        return true;
+    }
+
+    // A memory-mapped reader where the format has one, else the regular reader
+    static std::unique_ptr<juce::AudioFormatReader> createReader(const juce::File& file)
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        if (auto* format = formatManager.findFormatForFileExtension(file.getFileExtension()))
+        {
+            std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(format->createMemoryMappedReader(file));
+            if (mapped != nullptr && mapped->mapEntireFile())
+                return mapped;
+        }
+
+        return std::unique_ptr<juce::AudioFormatReader>(formatManager.createReaderFor(file));
+    }
+
+    // Decodes and analyses a whole file: the profile and the waveform pyramid.
+    // The file is split across up to maxThreads workers (the calling thread
+    // is the first), each with its own reader, accumulator and pyramid, merged
+    // at the end. reader is the first worker's. onProgress (0-1) is called
+    // from the workers. False if stopped or a reader couldn't be opened.
+    static bool analyzeFile(const juce::File& file, std::unique_ptr<juce::AudioFormatReader> reader, int maxThreads,
+                            ReferenceCache::Entry& dest, const std::function<bool()>& shouldStop = {},
+                            const std::function<void(float)>& onProgress = {})
+    {
+        const double sampleRate = reader->sampleRate;
+        const int64_t length = reader->lengthInSamples;
+
+        // At least MIN_SECONDS_PER_THREAD of audio each
+        const int64_t minSamplesPerThread = static_cast<int64_t>(sampleRate * MIN_SECONDS_PER_THREAD);
+        const int numThreads = static_cast<int>(juce::jlimit(int64_t { 1 }, static_cast<int64_t>(juce::jlimit(1, MAX_THREADS, maxThreads)),
+                                                             std::min(static_cast<int64_t>(juce::SystemStats::getNumCpus()),
+                                                                      length / std::max(int64_t { 1 }, minSamplesPerThread))));
+
+        std::vector<std::unique_ptr<juce::AudioFormatReader>> readers;
+        readers.push_back(std::move(reader));
+        for (int t = 1; t < numThreads; ++t)
+        {
+            readers.push_back(createReader(file));
+            if (readers.back() == nullptr)
+                return false;
+        }
+
+        std::vector<ReferenceProfile::Accumulator> accumulators(static_cast<size_t>(numThreads));
+        std::vector<WaveformPyramid::Builder> waveforms(static_cast<size_t>(numThreads));
+        std::atomic<int64_t> samplesRead { 0 };
+        std::array<bool, MAX_THREADS> completed {};  // One per worker, read after the join
+
+        const auto work = [&](int t)
+        {
+            const int64_t start = length * t / numThreads;
+            const int64_t end = length * (t + 1) / numThreads;
+            auto& waveform = waveforms[static_cast<size_t>(t)];
+            waveform.prepare(start);
+
+            const auto onChunk = [&](const float* left, const float* right, int64_t position, int count)
+            {
+                waveform.process(left, right, position, count);
+
+                const int64_t read = samplesRead.fetch_add(count) + count;
+                if (onProgress)
+                    onProgress(static_cast<float>(read) / static_cast<float>(length));
+            };
+
+            completed[static_cast<size_t>(t)] = ReferenceProfile::accumulateFromReader(*readers[static_cast<size_t>(t)], start, end,
+                                                                                       accumulators[static_cast<size_t>(t)], shouldStop, onChunk);
+        };
+
+        std::vector<std::thread> threads;
+        for (int t = 1; t < numThreads; ++t)
+            threads.emplace_back(work, t);
+
+        work(0);
+
+        for (auto& thread : threads)
+            thread.join();
+
+        for (int t = 0; t < numThreads; ++t)
+            if (!completed[static_cast<size_t>(t)])
+                return false;
+
+        // Reduce
+        for (int t = 1; t < numThreads; ++t)
+        {
+            accumulators[0].merge(accumulators[static_cast<size_t>(t)]);
+            waveforms[0].merge(waveforms[static_cast<size_t>(t)]);
+        }
+
+        if (!accumulators[0].finish(dest.profile))
+            return false;
+
+        waveforms[0].finish(dest.waveform, length, sampleRate);
+
+        dest.durationSeconds = static_cast<double>(length) / sampleRate;
+        return true;
+    }
+
+private:
+    // A file analysed before comes straight from the cache
+    void run() override
+    {
+        Result loaded;
+        bool ready = ReferenceCache::read(loadingFile, loaded);
+
+        if (!ready && analyzeFile(loadingFile, std::move(reader), MAX_THREADS, loaded,
+                                  [this] { return threadShouldExit(); },
+                                  [this](float fraction) { progress.store(fraction); }))
+        {
+            if (ReferenceCache::write(loadingFile, loaded))
+                ReferenceCache::trim();
+
+            ready = true;
+        }
+
+        if (ready)
+        {
+            loaded.profile.setName(loadingFile.getFileNameWithoutExtension().toStdString());
+            loaded.file = loadingFile;
+
+            {
+                const std::lock_guard<std::mutex> lock(resultMutex);
+                result = std::move(loaded);
+                hasResult = true;
+            }
+
+            progress.store(1.0f);
+            loading.store(false);
+
+            if (onLoadComplete)
+                onLoadComplete();
+        }
+        else
+        {
+            loading.store(false);
+        }
+    }
+
+    // Opened by load(), handed to analyzeFile()
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    juce::File loadingFile;
+
+    std::mutex resultMutex;
+    Result result;
+    bool hasResult = false;
+
+    std::atomic<float> progress { 0.0f };
+    std::atomic<bool> loading { false };
+};
@@ -1,11 +1,17 @@
 #pragma once
 
 #include "DSPUtils.h"
+#include "LoudnessMeter.h"
 #include "SpectralAnalyzer.h"
 #include <juce_audio_formats/juce_audio_formats.h>
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <memory>
+#include <utility>
+#include <vector>
 
 class ReferenceProfile
 {
@@ -28,111 +34,373 @@ public:
         Custom
     };
 
-    ReferenceProfile() = default;
-
-    // Load reference from audio file
-    bool loadFromFile(const juce::File& file)
+    // Profile statistics for one stretch of a track. Everything is a sum, so
+    // stretches analysed on separate threads merge into the statistics of
+    // the whole: spectral power per FFT bin, K-weighted energy per 100 ms
+    // loudness block, and the level and stereo moments.
+    //
+    // Positions are absolute within the track. FFT frames sit on a fixed hop
+    // grid and loudness blocks on a fixed 100 ms grid, so a stretch primed
+    // with the PREROLL_SAMPLES before it carries on exactly where the
+    // previous stretch stopped.
+    class Accumulator
     {
-        juce::AudioFormatManager formatManager;
-        formatManager.registerBasicFormats();
+    public:
+        static constexpr int FFT_ORDER = SpectralAnalyzer::FFT_ORDER;
+        static constexpr int FFT_SIZE = 1 << FFT_ORDER;
+        static constexpr int NUM_BINS = FFT_SIZE / 2;
+        static constexpr int HOP_SIZE = FFT_SIZE / 4;
+        static constexpr int PREROLL_SAMPLES = FFT_SIZE;  // Fills the window and settles the K-weighting
+
+        Accumulator()
+            : fft(FFT_ORDER)
+        {
+        }
 
-        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
-        if (!reader)
-            return false;
+        // startSample is where the first sample given to process() sits in the track
+        void prepare(double sampleRate, int channels, int64_t startSample)
+        {
+            currentSampleRate = sampleRate;
+            numChannels = std::max(1, std::min(channels, 2));
+            blockLength = std::max(1, static_cast<int>(std::round(sampleRate * 0.1)));
+            LoudnessMeter::designKWeighting(sampleRate, shelfCoeffs, highPassCoeffs);
+
+            for (auto& state : shelfStates)
+                state.reset();
+            for (auto& state : highPassStates)
+                state.reset();
+
+            inputRing.fill(0.0f);
+            ringIndex = 0;
+            samplesInRing = 0;
+            powerSum.fill(0.0);
+            numFrames = 0;
+
+            firstBlock = startSample / blockLength;
+            blockEnergy.clear();
+
+            startPosition = position = startSample;
+            sumSquared = 0.0;
+            peakValue = 0.0f;
+            sumMid2 = sumSide2 = sumL2 = sumR2 = sumLR = 0.0;
+        }
 
-        // Read entire file (or first 60 seconds for long files)
-        int maxSamples = static_cast<int>(std::min(reader->lengthInSamples,
-                                                    static_cast<juce::int64>(reader->sampleRate * 60)));
+        // The audio just before startSample: fills the FFT window and the
+        // filters without counting anything
+        void prime(const float* left, const float* right, int count)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                const float r = numChannels >= 2 ? right[i] : left[i];
+                pushToRing((left[i] + r) * 0.5f);
+                kWeight(left[i], r);
+            }
+        }
 
-        juce::AudioBuffer<float> buffer(reader->numChannels, maxSamples);
-        reader->read(&buffer, 0, maxSamples, 0, true, true);
+        // right is ignored for a mono source
+        void process(const float* left, const float* right, int count)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                const float l = left[i];
+                const float r = numChannels >= 2 ? right[i] : l;
 
-        return analyzeBuffer(buffer, reader->sampleRate);
-    }
+                pushToRing((l + r) * 0.5f);
+                ++position;
 
-    // Analyze audio buffer to create profile
-    bool analyzeBuffer(const juce::AudioBuffer<float>& buffer, double sampleRate)
-    {
-        if (buffer.getNumSamples() < 1024)
-            return false;
+                if (position % HOP_SIZE == 0 && samplesInRing == FFT_SIZE)
+                    addFrame();
 
-        profileSampleRate = sampleRate;
-        profileDurationSeconds = buffer.getNumSamples() / sampleRate;
+                // K-weighted energy into the current 100 ms block
+                const auto [kLeft, kRight] = kWeight(l, r);
+                const size_t block = static_cast<size_t>((position - 1) / blockLength - firstBlock);
+                if (block >= blockEnergy.size())
+                    blockEnergy.resize(block + 1, 0.0);
+                blockEnergy[block] += numChannels >= 2 ? kLeft * kLeft + kRight * kRight : kLeft * kLeft;
+            }
 
-        // Set up analyzer
-        SpectralAnalyzer analyzer;
-        analyzer.prepare(sampleRate, 4096);
+            for (int i = 0; i < count; ++i)
+            {
+                sumSquared += left[i] * left[i];
+                peakValue = std::max(peakValue, std::abs(left[i]));
+            }
 
-        // Analyze spectral content
-        int numChannels = buffer.getNumChannels();
-        int numSamples = buffer.getNumSamples();
+            if (numChannels >= 2)
+            {
+                for (int i = 0; i < count; ++i)
+                {
+                    const float mid = (left[i] + right[i]) * 0.5f;
+                    const float side = (left[i] - right[i]) * 0.5f;
+                    sumMid2 += mid * mid;
+                    sumSide2 += side * side;
+                    sumL2 += left[i] * left[i];
+                    sumR2 += right[i] * right[i];
+                    sumLR += left[i] * right[i];
+
+                    sumSquared += right[i] * right[i];
+                    peakValue = std::max(peakValue, std::abs(right[i]));
+                }
+            }
+        }
 
-        if (numChannels >= 2)
+        // Adds another stretch of the same track (prepared with the same
+        // rate and channels); stretches may come in any order
+        void merge(const Accumulator& other)
         {
-            analyzer.pushStereoSamples(buffer.getReadPointer(0),
-                                        buffer.getReadPointer(1),
-                                        numSamples);
+            for (int i = 0; i < NUM_BINS; ++i)
+                powerSum[static_cast<size_t>(i)] += other.powerSum[static_cast<size_t>(i)];
+            numFrames += other.numFrames;
+
+            const int64_t mergedFirst = std::min(firstBlock, other.firstBlock);
+            const int64_t mergedEnd = std::max(firstBlock + static_cast<int64_t>(blockEnergy.size()),
+                                               other.firstBlock + static_cast<int64_t>(other.blockEnergy.size()));
+
+            std::vector<double> merged(static_cast<size_t>(mergedEnd - mergedFirst), 0.0);
+            for (size_t b = 0; b < blockEnergy.size(); ++b)
+                merged[static_cast<size_t>(firstBlock - mergedFirst) + b] += blockEnergy[b];
+            for (size_t b = 0; b < other.blockEnergy.size(); ++b)
+                merged[static_cast<size_t>(other.firstBlock - mergedFirst) + b] += other.blockEnergy[b];
+
+            blockEnergy = std::move(merged);
+            firstBlock = mergedFirst;
+
+            startPosition = std::min(startPosition, other.startPosition);
+            position = std::max(position, other.position);
+
+            sumSquared += other.sumSquared;
+            peakValue = std::max(peakValue, other.peakValue);
+            sumMid2 += other.sumMid2;
+            sumSide2 += other.sumSide2;
+            sumL2 += other.sumL2;
+            sumR2 += other.sumR2;
+            sumLR += other.sumLR;
         }
-        else
+
+        int64_t getNumSamples() const { return position - startPosition; }
+
+        // Fills in the profile; false if there wasn't enough audio
+        bool finish(ReferenceProfile& profile) const
         {
-            analyzer.pushSamples(buffer.getReadPointer(0), numSamples);
+            const int64_t numSamples = getNumSamples();
+            if (numSamples < 1024)
+                return false;
+
+            profile.profileSampleRate = currentSampleRate;
+            profile.profileDurationSeconds = static_cast<float>(static_cast<double>(numSamples) / currentSampleRate);
+
+            // Spectral envelope of the average power spectrum over every frame
+            if (numFrames > 0)
+            {
+                std::array<float, NUM_BINS> magnitudes {};
+                for (int i = 0; i < NUM_BINS; ++i)
+                    magnitudes[static_cast<size_t>(i)] = static_cast<float>(std::sqrt(powerSum[static_cast<size_t>(i)] / static_cast<double>(numFrames)));
+
+                const auto features = DSPUtils::calculateSpectralFeatures(magnitudes.data(),
+                                                                          DSPUtils::SpectralFeatureTables::get(FFT_SIZE, currentSampleRate));
+                profile.spectralEnvelope = features.bandEnergies;
+                profile.spectralCentroid = features.centroid;
+                profile.spectralSlope = features.slope;
+                profile.spectralFlatness = features.flatness;
+            }
+
+            // Loudness (simple RMS-based for profile)
+            const float rms = static_cast<float>(std::sqrt(sumSquared / (static_cast<double>(numSamples) * numChannels)));
+            profile.loudnessRMS = DSPUtils::linearToDecibels(rms);
+            profile.peakLevel = DSPUtils::linearToDecibels(peakValue);
+            profile.crestFactor = profile.peakLevel - profile.loudnessRMS;
+            profile.integratedLUFS = computeIntegratedLoudness();
+
+            // Stereo characteristics
+            if (numChannels >= 2)
+            {
+                profile.stereoWidth = sumMid2 > 1e-10 ? static_cast<float>(std::sqrt(sumSide2 / sumMid2)) : 1.0f;
+                const double denom = std::sqrt(sumL2 * sumR2);
+                profile.stereoCorrelation = denom > 1e-10 ? static_cast<float>(sumLR / denom) : 1.0f;
+            }
+
+            profile.isValid = true;
+            return true;
         }
 
-        // Store spectral envelope
-        auto features = analyzer.getSpectralFeatures();
-        spectralEnvelope = features.bandEnergies;
-        spectralCentroid = features.centroid;
-        spectralSlope = features.slope;
-        spectralFlatness = features.flatness;
+    private:
+        void pushToRing(float sample)
+        {
+            inputRing[static_cast<size_t>(ringIndex)] = sample;
+            ringIndex = (ringIndex + 1) & (FFT_SIZE - 1);
+            samplesInRing = std::min(samplesInRing + 1, FFT_SIZE);
+        }
 
-        // Calculate loudness (simple RMS-based for profile)
-        float sumSquared = 0.0f;
-        float peakValue = 0.0f;
+        std::pair<float, float> kWeight(float left, float right)
+        {
+            const float kLeft = highPassStates[0].process(shelfStates[0].process(left, shelfCoeffs), highPassCoeffs);
+            const float kRight = highPassStates[1].process(shelfStates[1].process(right, shelfCoeffs), highPassCoeffs);
+            return { kLeft, kRight };
+        }
 
-        for (int ch = 0; ch < numChannels; ++ch)
+        // Same window and scaling as SpectralAnalyzer
+        void addFrame()
         {
-            const float* samples = buffer.getReadPointer(ch);
-            for (int i = 0; i < numSamples; ++i)
+            const auto& window = DSPUtils::getBlackmanHarrisWindow<FFT_SIZE>();
+            const int firstPart = FFT_SIZE - ringIndex;
+
+            for (int i = 0; i < firstPart; ++i)
+                fftData[static_cast<size_t>(i)] = inputRing[static_cast<size_t>(ringIndex + i)] * window[static_cast<size_t>(i)];
+
+            for (int i = firstPart; i < FFT_SIZE; ++i)
+                fftData[static_cast<size_t>(i)] = inputRing[static_cast<size_t>(i - firstPart)] * window[static_cast<size_t>(i)];
+
+            fft.performRealOnlyForwardTransform(fftData.data(), true);
+
+            constexpr float scale = 2.0f / FFT_SIZE;
+            for (int i = 0; i < NUM_BINS; ++i)
             {
-                sumSquared += samples[i] * samples[i];
-                peakValue = std::max(peakValue, std::abs(samples[i]));
+                const float re = fftData[static_cast<size_t>(2 * i)] * scale;
+                const float im = fftData[static_cast<size_t>(2 * i + 1)] * scale;
+                powerSum[static_cast<size_t>(i)] += re * re + im * im;
             }
-        }
 
-        float rms = std::sqrt(sumSquared / (numSamples * numChannels));
-        loudnessRMS = DSPUtils::linearToDecibels(rms);
-        peakLevel = DSPUtils::linearToDecibels(peakValue);
-        crestFactor = peakLevel - loudnessRMS;
+            ++numFrames;
+        }
 
-        // Calculate stereo characteristics
-        if (numChannels >= 2)
+        // BS.1770-4 over the complete 100 ms blocks: 400 ms gating blocks
+        // at 75% overlap, absolute then relative gate
+        float computeIntegratedLoudness() const
         {
-            float sumMid2 = 0.0f, sumSide2 = 0.0f;
-            float sumL2 = 0.0f, sumR2 = 0.0f, sumLR = 0.0f;
+            const auto toLoudness = [](double meanSquare) { return -0.691 + 10.0 * std::log10(std::max(meanSquare, 1e-20)); };
 
-            const float* left = buffer.getReadPointer(0);
-            const float* right = buffer.getReadPointer(1);
+            // The last block only counts if the track fills it
+            const int64_t completeBlocks = std::min(static_cast<int64_t>(blockEnergy.size()), position / blockLength - firstBlock);
 
-            for (int i = 0; i < numSamples; ++i)
+            std::vector<double> gatingBlocks;
+            for (int64_t b = 0; b + 4 <= completeBlocks; ++b)
             {
-                float mid = (left[i] + right[i]) * 0.5f;
-                float side = (left[i] - right[i]) * 0.5f;
-                sumMid2 += mid * mid;
-                sumSide2 += side * side;
-                sumL2 += left[i] * left[i];
-                sumR2 += right[i] * right[i];
-                sumLR += left[i] * right[i];
+                double energy = 0.0;
+                for (int64_t j = b; j < b + 4; ++j)
+                    energy += blockEnergy[static_cast<size_t>(j)];
+
+                const double meanSquare = energy / (4.0 * blockLength);
+                if (toLoudness(meanSquare) > -70.0)
+                    gatingBlocks.push_back(meanSquare);
             }
 
-            stereoWidth = sumMid2 > 1e-10f ? std::sqrt(sumSide2 / sumMid2) : 1.0f;
-            float denom = std::sqrt(sumL2 * sumR2);
-            stereoCorrelation = denom > 1e-10f ? sumLR / denom : 1.0f;
+            if (gatingBlocks.empty())
+                return -100.0f;
+
+            double ungated = 0.0;
+            for (double meanSquare : gatingBlocks)
+                ungated += meanSquare;
+            const double relativeGate = toLoudness(ungated / gatingBlocks.size()) - 10.0;
+
+            double gated = 0.0;
+            int gatedCount = 0;
+            for (double meanSquare : gatingBlocks)
+            {
+                if (toLoudness(meanSquare) > relativeGate)
+                {
+                    gated += meanSquare;
+                    ++gatedCount;
+                }
+            }
+
+            return gatedCount > 0 ? static_cast<float>(toLoudness(gated / gatedCount)) : -100.0f;
+        }
+
+        double currentSampleRate = 44100.0;
+        int numChannels = 2;
+        int64_t startPosition = 0;
+        int64_t position = 0;  // Track position of the next sample
+
+        // Average spectrum
+        juce::dsp::FFT fft;
+        std::array<float, FFT_SIZE * 2> fftData {};
+        std::array<float, FFT_SIZE> inputRing {};
+        int ringIndex = 0;
+        int samplesInRing = 0;
+        std::array<double, NUM_BINS> powerSum {};
+        int64_t numFrames = 0;
+
+        // Integrated loudness
+        DSPUtils::BiquadCoeffs shelfCoeffs, highPassCoeffs;
+        std::array<DSPUtils::BiquadState, 2> shelfStates, highPassStates;
+        int blockLength = 4410;
+        int64_t firstBlock = 0;
+        std::vector<double> blockEnergy;  // Summed K-weighted squares per 100 ms block
+
+        // Level and stereo moments
+        double sumSquared = 0.0;
+        float peakValue = 0.0f;
+        double sumMid2 = 0.0, sumSide2 = 0.0;
+        double sumL2 = 0.0, sumR2 = 0.0, sumLR = 0.0;
+    };
+
+    static constexpr int READ_CHUNK_SIZE = 32768;
+
+    ReferenceProfile() = default;
+
+    // Feeds samples [start, end) of a file into accumulator, primed with
+    // the audio before start. onChunk sees each chunk as it is read (left,
+    // right, track position, count); mono files come through in both
+    // channels. False if shouldStop returned true.
+    static bool accumulateFromReader(juce::AudioFormatReader& reader, int64_t start, int64_t end, Accumulator& accumulator,
+                                     const std::function<bool()>& shouldStop = {},
+                                     const std::function<void(const float*, const float*, int64_t, int)>& onChunk = {})
+    {
+        accumulator.prepare(reader.sampleRate, static_cast<int>(reader.numChannels), start);
+
+        juce::AudioBuffer<float> buffer(2, READ_CHUNK_SIZE);
+
+        const int preroll = static_cast<int>(std::min(start, static_cast<int64_t>(Accumulator::PREROLL_SAMPLES)));
+        if (preroll > 0)
+        {
+            reader.read(&buffer, 0, preroll, start - preroll, true, true);
+            accumulator.prime(buffer.getReadPointer(0), buffer.getReadPointer(1), preroll);
+        }
+
+        for (int64_t position = start; position < end; position += READ_CHUNK_SIZE)
+        {
+            if (shouldStop && shouldStop())
+                return false;
+
+            const int count = static_cast<int>(std::min(static_cast<int64_t>(READ_CHUNK_SIZE), end - position));
+            reader.read(&buffer, 0, count, position, true, true);
+            accumulator.process(buffer.getReadPointer(0), buffer.getReadPointer(1), count);
+
+            if (onChunk)
+                onChunk(buffer.getReadPointer(0), buffer.getReadPointer(1), position, count);
         }
 
-        isValid = true;
         return true;
     }
 
+    // Load reference from audio file, the whole track on the calling
+    // thread. ReferenceLoader splits the file across threads instead.
+    bool loadFromFile(const juce::File& file)
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        if (!reader)
+            return false;
+
+        Accumulator accumulator;
+        accumulateFromReader(*reader, 0, reader->lengthInSamples, accumulator);
+        return accumulator.finish(*this);
+    }
+
+    // Analyze audio buffer to create profile
+    bool analyzeBuffer(const juce::AudioBuffer<float>& buffer, double sampleRate)
+    {
+        const int numChannels = buffer.getNumChannels();
+        if (numChannels < 1)
+            return false;
+
+        Accumulator accumulator;
+        accumulator.prepare(sampleRate, numChannels, 0);
+        accumulator.process(buffer.getReadPointer(0), buffer.getReadPointer(numChannels > 1 ? 1 : 0), buffer.getNumSamples());
+        return accumulator.finish(*this);
+    }
+
     // Create preset profile for genre
     static ReferenceProfile createGenrePreset(Genre genre)
     {
@@ -269,50 +537,82 @@ public:
         return profile;
     }
 
-    // Compare current audio to reference and return match score (0-100)
-    float calculateMatchScore(const std::array<float, NUM_BANDS>& currentSpectrum,
-                              float currentLoudness,
-                              float currentWidth,
-                              float currentCorrelation) const
+    // What a match is scored on: the band spectrum, then loudness, width
+    // and correlation. Flat, so a library can keep many side by side.
+    // Loudness is integrated LUFS, so compare against the mix's integrated
+    // loudness; genre presets, which have none, use their RMS target.
+    static constexpr int NUM_MATCH_FEATURES = NUM_BANDS + 3;
+    using MatchFeatures = std::array<float, NUM_MATCH_FEATURES>;
+
+    static MatchFeatures makeMatchFeatures(const std::array<float, NUM_BANDS>& spectrum,
+                                           float loudness, float width, float correlation)
     {
-        if (!isValid)
-            return 0.0f;
+        MatchFeatures features {};
+        std::copy(spectrum.begin(), spectrum.end(), features.begin());
+        features[NUM_BANDS] = loudness;
+        features[NUM_BANDS + 1] = width;
+        features[NUM_BANDS + 2] = correlation;
+        return features;
+    }
+
+    MatchFeatures getMatchFeatures() const
+    {
+        return makeMatchFeatures(spectralEnvelope, getMatchLoudness(), stereoWidth, stereoCorrelation);
+    }
 
+    float getMatchLoudness() const { return integratedLUFS > -70.0f ? integratedLUFS : loudnessRMS; }
+
+    // Match score (0-100) between two feature sets
+    static float scoreMatch(const float* reference, const float* current)
+    {
         float score = 0.0f;
 
-        // Spectral match (40% weight)
+        // Spectral match (40% weight); a branch-free loop the compiler vectorises
         float spectralDiff = 0.0f;
         for (int i = 0; i < NUM_BANDS; ++i)
-        {
-            float diff = std::abs(currentSpectrum[i] - spectralEnvelope[i]);
-            spectralDiff += std::min(diff, 12.0f);  // Cap at 12dB difference
-        }
+            spectralDiff += std::min(std::abs(current[i] - reference[i]), 12.0f);  // Cap at 12dB difference
+
         float spectralScore = std::max(0.0f, 100.0f - (spectralDiff / NUM_BANDS) * 8.33f);
         score += spectralScore * 0.4f;
 
         // Loudness match (25% weight)
-        float loudnessDiff = std::abs(currentLoudness - loudnessRMS);
+        float loudnessDiff = std::abs(current[NUM_BANDS] - reference[NUM_BANDS]);
         float loudnessScore = std::max(0.0f, 100.0f - loudnessDiff * 5.0f);
         score += loudnessScore * 0.25f;
 
         // Stereo width match (20% weight)
-        float widthDiff = std::abs(currentWidth - stereoWidth);
+        float widthDiff = std::abs(current[NUM_BANDS + 1] - reference[NUM_BANDS + 1]);
         float widthScore = std::max(0.0f, 100.0f - widthDiff * 50.0f);
         score += widthScore * 0.2f;
 
         // Correlation match (15% weight)
-        float corrDiff = std::abs(currentCorrelation - stereoCorrelation);
+        float corrDiff = std::abs(current[NUM_BANDS + 2] - reference[NUM_BANDS + 2]);
         float corrScore = std::max(0.0f, 100.0f - corrDiff * 100.0f);
         score += corrScore * 0.15f;
 
         return score;
     }
 
+    // Compare current audio to reference and return match score (0-100);
+    // currentLoudness is the mix's integrated LUFS
+    float calculateMatchScore(const std::array<float, NUM_BANDS>& currentSpectrum,
+                              float currentLoudness,
+                              float currentWidth,
+                              float currentCorrelation) const
+    {
+        if (!isValid)
+            return 0.0f;
+
+        const auto current = makeMatchFeatures(currentSpectrum, currentLoudness, currentWidth, currentCorrelation);
+        return scoreMatch(getMatchFeatures().data(), current.data());
+    }
+
     // Getters
     bool isProfileValid() const { return isValid; }
     Genre getGenre() const { return genre; }
     const std::array<float, NUM_BANDS>& getSpectralEnvelope() const { return spectralEnvelope; }
     float getLoudnessRMS() const { return loudnessRMS; }
+    float getIntegratedLoudness() const { return integratedLUFS; }  // -100 for genre presets
     float getPeakLevel() const { return peakLevel; }
     float getCrestFactor() const { return crestFactor; }
     float getStereoWidth() const { return stereoWidth; }
@@ -324,6 +624,41 @@ public:
 
     void setName(const std::string& name) { profileName = name; }
 
+    // Compact binary form, used by ReferenceCache. Changing the fields means
+    // bumping ReferenceCache::FORMAT_VERSION.
+    void writeTo(juce::OutputStream& stream) const
+    {
+        stream.writeBool(isValid);
+        stream.writeInt(static_cast<int>(genre));
+        stream.writeString(juce::String(profileName));
+        stream.writeDouble(profileSampleRate);
+        stream.writeFloat(profileDurationSeconds);
+
+        for (float energy : spectralEnvelope)
+            stream.writeFloat(energy);
+
+        for (float value : { spectralCentroid, spectralSlope, spectralFlatness, loudnessRMS, peakLevel,
+                             crestFactor, integratedLUFS, stereoWidth, stereoCorrelation })
+            stream.writeFloat(value);
+    }
+
+    // Reads what writeTo() wrote; the caller checks the stream held it all
+    void readFrom(juce::InputStream& stream)
+    {
+        isValid = stream.readBool();
+        genre = static_cast<Genre>(juce::jlimit(0, static_cast<int>(Genre::Custom), stream.readInt()));
+        profileName = stream.readString().toStdString();
+        profileSampleRate = stream.readDouble();
+        profileDurationSeconds = stream.readFloat();
+
+        for (float& energy : spectralEnvelope)
+            energy = stream.readFloat();
+
+        for (float* value : { &spectralCentroid, &spectralSlope, &spectralFlatness, &loudnessRMS, &peakLevel,
+                              &crestFactor, &integratedLUFS, &stereoWidth, &stereoCorrelation })
+            *value = stream.readFloat();
+    }
+
 private:
     bool isValid = false;
     Genre genre = Genre::Auto;
@@ -342,6 +677,7 @@ private:
     float loudnessRMS = -18.0f;
     float peakLevel = -1.0f;
     float crestFactor = 12.0f;
+    float integratedLUFS = -100.0f;  // BS.1770 over the whole track
 
     // Stereo characteristics
     float stereoWidth = 1.0f;
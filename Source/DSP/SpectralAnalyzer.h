@@ -3,8 +3,6 @@
 #include "DSPUtils.h"
 #include <juce_dsp/juce_dsp.h>
 #include <array>
-#include <atomic>
-#include <mutex>
 
 class SpectralAnalyzer
 {
@@ -13,99 +11,108 @@ public:
     static constexpr int FFT_SIZE = 1 << FFT_ORDER;  // 4096
     static constexpr int NUM_BINS = FFT_SIZE / 2;
     static constexpr int NUM_BANDS = 32;
+    static constexpr int MIN_HOP = FFT_SIZE / 8;  // 87.5% overlap
+    static constexpr int MAX_HOP = FFT_SIZE / 2;  // 50% overlap
 
     SpectralAnalyzer()
-        : fft(FFT_ORDER)
+        : fft(FFT_ORDER),
+          featureTables(&DSPUtils::SpectralFeatureTables::get(FFT_SIZE, 44100.0))
     {
+        setOverlap(0.75f);
     }
 
     void prepare(double sampleRate, int samplesPerBlock)
     {
         currentSampleRate = sampleRate;
+        featureTables = &DSPUtils::SpectralFeatureTables::get(FFT_SIZE, sampleRate);
+        DSPUtils::getBlackmanHarrisWindow<FFT_SIZE>();  // Built here rather than on the audio thread
         reset();
     }
 
-    void reset()
+    // Fraction of each frame shared with the next (0.5 - 0.875). Display
+    // smoothing is scaled so the spectrum moves at the same speed at any
+    // overlap. Call before prepare(), not while audio is running.
+    void setOverlap(float overlap)
     {
-        fftBuffer.fill(0.0f);
-        fftBufferIndex = 0;
+        overlap = juce::jlimit(0.5f, 0.875f, overlap);
+        hopSize = juce::jlimit(MIN_HOP, MAX_HOP, static_cast<int>(std::round(FFT_SIZE * (1.0f - overlap))));
 
-        magnitudeSpectrum.fill(-100.0f);
-        smoothedSpectrum.fill(-100.0f);
-        peakSpectrum.fill(-100.0f);
+        const float framesPerWindow = static_cast<float>(FFT_SIZE) / static_cast<float>(hopSize);
+        spectrumSmoothing = std::pow(0.7f, 1.0f / framesPerWindow);
+        peakDecay = std::pow(0.995f, 1.0f / framesPerWindow);
+    }
 
-        for (auto& band : bandEnergies)
-            band.store(-100.0f);
+    int getHopSize() const { return hopSize; }
 
-        spectralCentroid.store(0.0f);
-        spectralSlope.store(0.0f);
-        spectralFlatness.store(0.0f);
+    void reset()
+    {
+        inputRing.fill(0.0f);
+        ringIndex = 0;
+        samplesCollected = 0;
+        samplesSinceFrame = 0;
+        frameStage = FrameStage::Idle;
+
+        display.smoothed.fill(-100.0f);
+        display.peak.fill(-100.0f);
+        publishedDisplay.publish(display);
+
+        DSPUtils::SpectralFeatures silent;
+        silent.bandEnergies.fill(-100.0f);
+        publishedFeatures.publish(silent);
     }
 
     void pushSamples(const float* samples, int numSamples)
     {
         // Mono mix input
         for (int i = 0; i < numSamples; ++i)
-        {
-            fftBuffer[fftBufferIndex] = samples[i];
-            fftBufferIndex++;
+            pushSample(samples[i]);
 
-            if (fftBufferIndex >= FFT_SIZE)
-            {
-                processFFT();
-                fftBufferIndex = 0;
-            }
-        }
+        advanceFrame();
     }
 
     void pushStereoSamples(const float* left, const float* right, int numSamples)
     {
         for (int i = 0; i < numSamples; ++i)
-        {
-            fftBuffer[fftBufferIndex] = (left[i] + right[i]) * 0.5f;
-            fftBufferIndex++;
+            pushSample((left[i] + right[i]) * 0.5f);
 
-            if (fftBufferIndex >= FFT_SIZE)
-            {
-                processFFT();
-                fftBufferIndex = 0;
-            }
-        }
+        advanceFrame();
     }
 
-    // Get smoothed magnitude spectrum for UI display
-    std::array<float, NUM_BINS> getMagnitudeSpectrum() const
+    // Completes a frame still in progress, for offline callers that read the
+    // results straight after their last push
+    void flush()
     {
-        std::lock_guard<std::mutex> lock(spectrumMutex);
-        return smoothedSpectrum;
+        while (frameStage != FrameStage::Idle)
+            advanceFrame();
     }
 
-    // Get peak-held spectrum for UI
-    std::array<float, NUM_BINS> getPeakSpectrum() const
+    // Smoothed and peak-held spectra for the UI, from the same frame
+    struct DisplaySpectrum
     {
-        std::lock_guard<std::mutex> lock(spectrumMutex);
-        return peakSpectrum;
-    }
+        std::array<float, NUM_BINS> smoothed;
+        std::array<float, NUM_BINS> peak;
+    };
+
+    DisplaySpectrum getDisplaySpectrum() const { return publishedDisplay.read(); }
+
+    // Bumps whenever a new display frame is published
+    uint32_t getDisplayVersion() const { return publishedDisplay.getVersion(); }
+
+    // Get smoothed magnitude spectrum for UI display
+    std::array<float, NUM_BINS> getMagnitudeSpectrum() const { return getDisplaySpectrum().smoothed; }
+
+    // Get peak-held spectrum for UI
+    std::array<float, NUM_BINS> getPeakSpectrum() const { return getDisplaySpectrum().peak; }
 
     // Get 32-band energy distribution
-    std::array<float, NUM_BANDS> getBandEnergies() const
-    {
-        std::array<float, NUM_BANDS> result;
-        for (int i = 0; i < NUM_BANDS; ++i)
-            result[i] = bandEnergies[i].load();
-        return result;
-    }
+    std::array<float, NUM_BANDS> getBandEnergies() const { return getSpectralFeatures().bandEnergies; }
 
     // Spectral features
-    float getSpectralCentroid() const { return spectralCentroid.load(); }
-    float getSpectralSlope() const { return spectralSlope.load(); }
-    float getSpectralFlatness() const { return spectralFlatness.load(); }
+    float getSpectralCentroid() const { return getSpectralFeatures().centroid; }
+    float getSpectralSlope() const { return getSpectralFeatures().slope; }
+    float getSpectralFlatness() const { return getSpectralFeatures().flatness; }
 
-    DSPUtils::SpectralFeatures getSpectralFeatures() const
-    {
-        std::lock_guard<std::mutex> lock(spectrumMutex);
-        return lastFeatures;
-    }
+    DSPUtils::SpectralFeatures getSpectralFeatures() const { return publishedFeatures.read(); }
 
     // Utility: frequency to bin index
     int frequencyToBin(float frequency) const
@@ -119,89 +126,131 @@ public:
     }
 
 private:
-    void processFFT()
+    // A frame's work is split into stages, one per pushSamples() call, so a
+    // block that completes a hop doesn't also pay for the whole transform
+    enum class FrameStage
     {
-        // Copy and apply window
-        std::array<float, FFT_SIZE * 2> fftData;
-        fftData.fill(0.0f);
+        Idle,
+        Transform,
+        Features,
+        Display
+    };
 
-        for (int i = 0; i < FFT_SIZE; ++i)
+    inline void pushSample(float sample)
+    {
+        inputRing[static_cast<size_t>(ringIndex)] = sample;
+        ringIndex = (ringIndex + 1) & (FFT_SIZE - 1);
+        samplesCollected = std::min(samplesCollected + 1, FFT_SIZE);
+
+        if (++samplesSinceFrame >= hopSize)
         {
-            // Blackman-Harris window for better frequency resolution
-            float window = 0.35875f
-                         - 0.48829f * std::cos(DSPUtils::TWO_PI * i / (FFT_SIZE - 1))
-                         + 0.14128f * std::cos(2.0f * DSPUtils::TWO_PI * i / (FFT_SIZE - 1))
-                         - 0.01168f * std::cos(3.0f * DSPUtils::TWO_PI * i / (FFT_SIZE - 1));
-            fftData[i] = fftBuffer[i] * window;
+            samplesSinceFrame = 0;
+
+            // Wait for a full window before the first frame
+            if (samplesCollected == FFT_SIZE)
+            {
+                // Big blocks can complete hops faster than one stage per call
+                flush();
+                captureFrame();
+            }
         }
+    }
 
-        // Perform FFT
-        fft.performFrequencyOnlyForwardTransform(fftData.data());
+    // Windowed copy of the ring, oldest sample first
+    void captureFrame()
+    {
+        const auto& window = DSPUtils::getBlackmanHarrisWindow<FFT_SIZE>();
+        const int firstPart = FFT_SIZE - ringIndex;
 
-        // Calculate magnitude spectrum
-        std::array<float, NUM_BINS> newMagnitudes;
+        for (int i = 0; i < firstPart; ++i)
+            fftData[static_cast<size_t>(i)] = inputRing[static_cast<size_t>(ringIndex + i)] * window[static_cast<size_t>(i)];
+
+        for (int i = firstPart; i < FFT_SIZE; ++i)
+            fftData[static_cast<size_t>(i)] = inputRing[static_cast<size_t>(i - firstPart)] * window[static_cast<size_t>(i)];
+
+        frameStage = FrameStage::Transform;
+    }
+
+    void advanceFrame()
+    {
+        switch (frameStage)
+        {
+            case FrameStage::Transform:
+                // Real-input transform; only the non-negative half is needed
+                fft.performRealOnlyForwardTransform(fftData.data(), true);
+                frameStage = FrameStage::Features;
+                break;
+
+            case FrameStage::Features:
+                computeFeatures();
+                frameStage = FrameStage::Display;
+                break;
+
+            case FrameStage::Display:
+                updateDisplaySpectrum();
+                frameStage = FrameStage::Idle;
+                break;
+
+            case FrameStage::Idle:
+                break;
+        }
+    }
+
+    void computeFeatures()
+    {
+        // Magnitudes from the interleaved (re, im) output
         for (int i = 0; i < NUM_BINS; ++i)
         {
-            float magnitude = fftData[i] / FFT_SIZE * 2.0f;  // Normalize
-            newMagnitudes[i] = magnitude;
+            const float re = fftData[static_cast<size_t>(2 * i)];
+            const float im = fftData[static_cast<size_t>(2 * i + 1)];
+            magnitudes[static_cast<size_t>(i)] = std::sqrt(re * re + im * im) / FFT_SIZE * 2.0f;  // Normalize
         }
 
         // Calculate spectral features
-        DSPUtils::SpectralFeatures features = DSPUtils::calculateSpectralFeatures(
-            newMagnitudes.data(), FFT_SIZE, currentSampleRate);
-
-        // Update atomic feature values
-        spectralCentroid.store(features.centroid);
-        spectralSlope.store(features.slope);
-        spectralFlatness.store(features.flatness);
-
-        // Update band energies
-        for (int i = 0; i < NUM_BANDS; ++i)
-            bandEnergies[i].store(features.bandEnergies[i]);
+        publishedFeatures.publish(DSPUtils::calculateSpectralFeatures(magnitudes.data(), *featureTables));
+    }
 
-        // Update spectrum with thread safety
+    void updateDisplaySpectrum()
+    {
+        for (int i = 0; i < NUM_BINS; ++i)
         {
-            std::lock_guard<std::mutex> lock(spectrumMutex);
+            float magDB = DSPUtils::linearToDecibels(magnitudes[static_cast<size_t>(i)]);
 
-            lastFeatures = features;
+            // Smoothing
+            display.smoothed[i] = display.smoothed[i] * spectrumSmoothing + magDB * (1.0f - spectrumSmoothing);
 
-            for (int i = 0; i < NUM_BINS; ++i)
-            {
-                float magDB = DSPUtils::linearToDecibels(newMagnitudes[i]);
-                magnitudeSpectrum[i] = magDB;
-
-                // Smoothing
-                float smoothing = 0.7f;
-                smoothedSpectrum[i] = smoothedSpectrum[i] * smoothing + magDB * (1.0f - smoothing);
-
-                // Peak hold with decay
-                if (magDB > peakSpectrum[i])
-                    peakSpectrum[i] = magDB;
-                else
-                    peakSpectrum[i] = peakSpectrum[i] * 0.995f + magDB * 0.005f;
-            }
+            // Peak hold with decay
+            if (magDB > display.peak[i])
+                display.peak[i] = magDB;
+            else
+                display.peak[i] = display.peak[i] * peakDecay + magDB * (1.0f - peakDecay);
         }
+
+        publishedDisplay.publish(display);
     }
 
     double currentSampleRate = 44100.0;
 
     // FFT
     juce::dsp::FFT fft;
-    std::array<float, FFT_SIZE> fftBuffer;
-    int fftBufferIndex = 0;
-
-    // Spectrum data (protected by mutex)
-    mutable std::mutex spectrumMutex;
-    std::array<float, NUM_BINS> magnitudeSpectrum;
-    std::array<float, NUM_BINS> smoothedSpectrum;
-    std::array<float, NUM_BINS> peakSpectrum;
-    DSPUtils::SpectralFeatures lastFeatures;
-
-    // Thread-safe atomic band energies
-    std::array<std::atomic<float>, NUM_BANDS> bandEnergies;
-
-    // Atomic spectral features
-    std::atomic<float> spectralCentroid { 0.0f };
-    std::atomic<float> spectralSlope { 0.0f };
-    std::atomic<float> spectralFlatness { 0.0f };
+    const DSPUtils::SpectralFeatureTables* featureTables;  // Shared, per sample rate
+    std::array<float, FFT_SIZE * 2> fftData {};  // Transform works in place on 2x the size
+    std::array<float, NUM_BINS> magnitudes {};
+    FrameStage frameStage = FrameStage::Idle;
+
+    // Input ring; a frame starts every hopSize samples
+    std::array<float, FFT_SIZE> inputRing {};
+    int ringIndex = 0;
+    int samplesCollected = 0;
+    int samplesSinceFrame = 0;
+    int hopSize = FFT_SIZE / 4;
+    float spectrumSmoothing = 0.7f;
+    float peakDecay = 0.995f;
+
+    // Display spectrum, audio thread only
+    DisplaySpectrum display {};
+
+    // Results for other threads
+    DSPUtils::SeqLock<DisplaySpectrum> publishedDisplay;
+    DSPUtils::SeqLock<DSPUtils::SpectralFeatures> publishedFeatures;
 };
@@ -2,16 +2,29 @@
 
 #include "DSPUtils.h"
 #include <array>
-#include <atomic>
-#include <deque>
-#include <mutex>
 
+// Global and per-band correlation, width and balance. The low band (below
+// 200 Hz) is split off decimated copies of L and R running at 4 kHz or
+// more; correlation and width are ratios of sums, so its sums come out the
+// same at the lower rate for a fraction of the filtering.
+//
+// Global figures come from running sums over the last CORRELATION_WINDOW
+// samples. Vectorscope points go to the UI through a single-producer,
+// single-consumer FIFO, so the audio thread never takes a lock.
 class StereoAnalyzer
 {
 public:
     static constexpr int NUM_BANDS = 3;
-    static constexpr int CORRELATION_WINDOW = 2048;
-    static constexpr int VECTORSCOPE_SIZE = 512;
+    static constexpr int CORRELATION_WINDOW = 2048;   // Power of two
+    static constexpr int VECTORSCOPE_FIFO_SIZE = 4096;
+    static constexpr double VECTORSCOPE_POINT_RATE = 11025.0;
+    static constexpr double MIN_LOW_BAND_RATE = 4000.0;
+
+    struct VectorscopePoint
+    {
+        float left;
+        float right;
+    };
 
     StereoAnalyzer() = default;
 
@@ -19,7 +32,18 @@ public:
     {
         currentSampleRate = sampleRate;
 
-        // Prepare crossovers for multiband analysis
+        // Low band: decimated L/R, low side of the 200 Hz split at that rate
+        const int lowBandStages = DSPUtils::DecimationCascade::getNumStagesFor(sampleRate, MIN_LOW_BAND_RATE);
+        lowBandDecimatorL.setNumStages(lowBandStages);
+        lowBandDecimatorR.setNumStages(lowBandStages);
+        const double lowBandRate = sampleRate / lowBandDecimatorL.getFactor();
+
+        lowCrossoverL.prepare(lowBandRate);
+        lowCrossoverR.prepare(lowBandRate);
+        lowCrossoverL.setCrossoverFrequency(200.0f);
+        lowCrossoverR.setCrossoverFrequency(200.0f);
+
+        // Mid and high: high side of the 200 Hz split, then the 3 kHz split, at full rate
         crossover1L.prepare(sampleRate);
         crossover1R.prepare(sampleRate);
         crossover2L.prepare(sampleRate);
@@ -30,38 +54,51 @@ public:
         crossover2L.setCrossoverFrequency(3000.0f);
         crossover2R.setCrossoverFrequency(3000.0f);
 
+        vectorscopeDecimation = std::max(1, static_cast<int>(std::round(sampleRate / VECTORSCOPE_POINT_RATE)));
+
         reset();
     }
 
     void reset()
     {
+        lowBandDecimatorL.reset();
+        lowBandDecimatorR.reset();
+        lowCrossoverL.reset();
+        lowCrossoverR.reset();
         crossover1L.reset();
         crossover1R.reset();
         crossover2L.reset();
         crossover2R.reset();
 
-        correlationBufferL.clear();
-        correlationBufferR.clear();
+        std::fill(correlationBufferL.begin(), correlationBufferL.end(), 0.0f);
+        std::fill(correlationBufferR.begin(), correlationBufferR.end(), 0.0f);
+        correlationIndex = 0;
+        windowSumL2 = windowSumR2 = windowSumLR = 0.0;
 
-        globalCorrelation.store(1.0f);
-        globalWidth.store(1.0f);
-        balance.store(0.0f);
+        features = StereoFeatures {};
+        publishedFeatures.publish(features);
 
-        for (int band = 0; band < NUM_BANDS; ++band)
-        {
-            bandCorrelation[band].store(1.0f);
-            bandWidth[band].store(1.0f);
-        }
+        vectorscopeFifo.reset();
+        vectorscopePhase = 0;
+    }
 
-        vectorscopeBuffer.fill({ 0.0f, 0.0f });
-        vectorscopeIndex = 0;
+    // Correlation history lives in the owner's arena; call after prepare()
+    void allocateState(DSPUtils::StateArena& arena)
+    {
+        correlationBufferL = arena.allocate<float>(CORRELATION_WINDOW);
+        correlationBufferR = arena.allocate<float>(CORRELATION_WINDOW);
     }
 
     void process(const float* left, const float* right, int numSamples)
     {
-        float sumL = 0.0f, sumR = 0.0f;
-        float sumL2 = 0.0f, sumR2 = 0.0f, sumLR = 0.0f;
-        float sumMid2 = 0.0f, sumSide2 = 0.0f;
+        if (correlationBufferL.isEmpty())
+            return;
+
+        // Room for this block's vectorscope points; any that don't fit are dropped
+        int start1, size1, start2, size2;
+        vectorscopeFifo.prepareToWrite((vectorscopePhase + numSamples) / vectorscopeDecimation,
+                                       start1, size1, start2, size2);
+        int pointsWritten = 0;
 
         // Per-band accumulators
         std::array<float, NUM_BANDS> bandSumL2 = {}, bandSumR2 = {}, bandSumLR = {};
@@ -72,40 +109,56 @@ public:
             float L = left[i];
             float R = right[i];
 
-            // Global statistics
-            sumL += L;
-            sumR += R;
-            sumL2 += L * L;
-            sumR2 += R * R;
-            sumLR += L * R;
-
-            float mid = (L + R) * 0.5f;
-            float side = (L - R) * 0.5f;
-            sumMid2 += mid * mid;
-            sumSide2 += side * side;
-
-            // Store for correlation calculation
-            correlationBufferL.push_back(L);
-            correlationBufferR.push_back(R);
-            while (correlationBufferL.size() > CORRELATION_WINDOW)
+            // Global statistics: slide the window by one sample
+            const float oldL = correlationBufferL[correlationIndex];
+            const float oldR = correlationBufferR[correlationIndex];
+            windowSumL2 += static_cast<double>(L * L) - static_cast<double>(oldL * oldL);
+            windowSumR2 += static_cast<double>(R * R) - static_cast<double>(oldR * oldR);
+            windowSumLR += static_cast<double>(L * R) - static_cast<double>(oldL * oldR);
+
+            correlationBufferL[correlationIndex] = L;
+            correlationBufferR[correlationIndex] = R;
+            correlationIndex = (correlationIndex + 1) & (CORRELATION_WINDOW - 1);
+
+            // Once per lap, recompute the sums so rounding can't build up
+            if (correlationIndex == 0)
+                resumWindow();
+
+            // Vectorscope point every vectorscopeDecimation samples
+            if (++vectorscopePhase == vectorscopeDecimation)
             {
-                correlationBufferL.pop_front();
-                correlationBufferR.pop_front();
+                vectorscopePhase = 0;
+
+                if (pointsWritten < size1)
+                    vectorscopePoints[static_cast<size_t>(start1 + pointsWritten)] = { L, R };
+                else if (pointsWritten < size1 + size2)
+                    vectorscopePoints[static_cast<size_t>(start2 + pointsWritten - size1)] = { L, R };
+
+                ++pointsWritten;
             }
 
-            // Split into bands
-            float lowL, midHighL, lowR, midHighR;
-            crossover1L.process(L, lowL, midHighL);
-            crossover1R.process(R, lowR, midHighR);
+            // Split into bands, the low band at its reduced rate (both
+            // decimators share a phase, so they deliver on the same sample)
+            float decimatedL, decimatedR;
+            const bool lowBandReady = lowBandDecimatorL.process(L, decimatedL);
+            lowBandDecimatorR.process(R, decimatedR);
 
             float midL, highL, midR, highR;
-            crossover2L.process(midHighL, midL, highL);
-            crossover2R.process(midHighR, midR, highR);
+            crossover2L.process(crossover1L.processHigh(L), midL, highL);
+            crossover2R.process(crossover1R.processHigh(R), midR, highR);
+
+            float bandsL[NUM_BANDS] = { 0.0f, midL, highL };
+            float bandsR[NUM_BANDS] = { 0.0f, midR, highR };
+            int firstBand = 1;
 
-            float bandsL[NUM_BANDS] = { lowL, midL, highL };
-            float bandsR[NUM_BANDS] = { lowR, midR, highR };
+            if (lowBandReady)
+            {
+                bandsL[0] = lowCrossoverL.processLow(decimatedL);
+                bandsR[0] = lowCrossoverR.processLow(decimatedR);
+                firstBand = 0;
+            }
 
-            for (int band = 0; band < NUM_BANDS; ++band)
+            for (int band = firstBand; band < NUM_BANDS; ++band)
             {
                 bandSumL2[band] += bandsL[band] * bandsL[band];
                 bandSumR2[band] += bandsR[band] * bandsR[band];
@@ -117,118 +170,136 @@ public:
                 bandSumSide2[band] += bSide * bSide;
             }
 
-            // Update vectorscope (downsampled)
-            if ((i % 4) == 0)
-            {
-                std::lock_guard<std::mutex> lock(vectorscopeMutex);
-                vectorscopeBuffer[vectorscopeIndex] = { L, R };
-                vectorscopeIndex = (vectorscopeIndex + 1) % VECTORSCOPE_SIZE;
-            }
         }
 
+        vectorscopeFifo.finishedWrite(std::min(pointsWritten, size1 + size2));
+
+        // Global figures over the window; mid and side energies follow from
+        // the L/R sums: M^2 = (L^2 + 2LR + R^2) / 4, S^2 = (L^2 - 2LR + R^2) / 4
+        const double sumL2 = std::max(0.0, windowSumL2);
+        const double sumR2 = std::max(0.0, windowSumR2);
+        const double sumLR = windowSumLR;
+        const double sumMid2 = std::max(0.0, (sumL2 + 2.0 * sumLR + sumR2) * 0.25);
+        const double sumSide2 = std::max(0.0, (sumL2 - 2.0 * sumLR + sumR2) * 0.25);
+
         // Calculate global correlation
-        float denom = std::sqrt(sumL2 * sumR2);
-        if (denom > 1e-10f)
-            globalCorrelation.store(sumLR / denom);
+        double denom = std::sqrt(sumL2 * sumR2);
+        if (denom > 1e-10)
+            features.correlation = static_cast<float>(sumLR / denom);
 
         // Calculate global stereo width (side/mid ratio)
-        if (sumMid2 > 1e-10f)
+        if (sumMid2 > 1e-10)
         {
-            float width = std::sqrt(sumSide2 / sumMid2);
-            globalWidth.store(std::min(2.0f, width));
+            float width = static_cast<float>(std::sqrt(sumSide2 / sumMid2));
+            features.width = std::min(2.0f, width);
         }
 
         // Calculate balance
-        float totalEnergy = sumL2 + sumR2;
-        if (totalEnergy > 1e-10f)
-        {
-            float bal = (sumR2 - sumL2) / totalEnergy;  // -1 = left, +1 = right
-            balance.store(bal);
-        }
+        double totalEnergy = sumL2 + sumR2;
+        if (totalEnergy > 1e-10)
+            features.balance = static_cast<float>((sumR2 - sumL2) / totalEnergy);  // -1 = left, +1 = right
 
         // Per-band calculations
         for (int band = 0; band < NUM_BANDS; ++band)
         {
             float bandDenom = std::sqrt(bandSumL2[band] * bandSumR2[band]);
             if (bandDenom > 1e-10f)
-                bandCorrelation[band].store(bandSumLR[band] / bandDenom);
+                features.bandCorrelation[band] = bandSumLR[band] / bandDenom;
 
             if (bandSumMid2[band] > 1e-10f)
             {
                 float bWidth = std::sqrt(bandSumSide2[band] / bandSumMid2[band]);
-                bandWidth[band].store(std::min(2.0f, bWidth));
+                features.bandWidth[band] = std::min(2.0f, bWidth);
             }
         }
+
+        publishedFeatures.publish(features);
     }
 
+    // Get all stereo features
+    struct StereoFeatures
+    {
+        float correlation = 1.0f;
+        float width = 1.0f;
+        float balance = 0.0f;
+        std::array<float, NUM_BANDS> bandCorrelation { 1.0f, 1.0f, 1.0f };
+        std::array<float, NUM_BANDS> bandWidth { 1.0f, 1.0f, 1.0f };
+    };
+
+    // One consistent set, as of the end of the last processed block
+    StereoFeatures getFeatures() const { return publishedFeatures.read(); }
+
     // Getters
-    float getCorrelation() const { return globalCorrelation.load(); }
-    float getWidth() const { return globalWidth.load(); }
-    float getBalance() const { return balance.load(); }
+    float getCorrelation() const { return getFeatures().correlation; }
+    float getWidth() const { return getFeatures().width; }
+    float getBalance() const { return getFeatures().balance; }
 
     float getBandCorrelation(int band) const
     {
-        return (band >= 0 && band < NUM_BANDS) ? bandCorrelation[band].load() : 1.0f;
+        return (band >= 0 && band < NUM_BANDS) ? getFeatures().bandCorrelation[band] : 1.0f;
     }
 
     float getBandWidth(int band) const
     {
-        return (band >= 0 && band < NUM_BANDS) ? bandWidth[band].load() : 1.0f;
+        return (band >= 0 && band < NUM_BANDS) ? getFeatures().bandWidth[band] : 1.0f;
     }
 
-    // Get all stereo features
-    struct StereoFeatures
+    // Drains up to maxPoints vectorscope points, oldest first, and returns
+    // how many were copied. Call from one thread only (the UI).
+    int readVectorscopePoints(VectorscopePoint* dest, int maxPoints)
     {
-        float correlation;
-        float width;
-        float balance;
-        std::array<float, NUM_BANDS> bandCorrelation;
-        std::array<float, NUM_BANDS> bandWidth;
-    };
+        int start1, size1, start2, size2;
+        vectorscopeFifo.prepareToRead(maxPoints, start1, size1, start2, size2);
 
-    StereoFeatures getFeatures() const
-    {
-        StereoFeatures features;
-        features.correlation = globalCorrelation.load();
-        features.width = globalWidth.load();
-        features.balance = balance.load();
-        for (int band = 0; band < NUM_BANDS; ++band)
-        {
-            features.bandCorrelation[band] = bandCorrelation[band].load();
-            features.bandWidth[band] = bandWidth[band].load();
-        }
-        return features;
+        std::copy_n(vectorscopePoints.begin() + start1, size1, dest);
+        std::copy_n(vectorscopePoints.begin() + start2, size2, dest + size1);
+
+        vectorscopeFifo.finishedRead(size1 + size2);
+        return size1 + size2;
     }
 
-    // Vectorscope data for UI
-    std::array<std::pair<float, float>, VECTORSCOPE_SIZE> getVectorscopeBuffer() const
+    int getNumVectorscopePointsReady() const { return vectorscopeFifo.getNumReady(); }
+
+private:
+    void resumWindow()
     {
-        std::lock_guard<std::mutex> lock(vectorscopeMutex);
-        return vectorscopeBuffer;
+        windowSumL2 = windowSumR2 = windowSumLR = 0.0;
+
+        for (int i = 0; i < CORRELATION_WINDOW; ++i)
+        {
+            const float L = correlationBufferL[i];
+            const float R = correlationBufferR[i];
+            windowSumL2 += static_cast<double>(L * L);
+            windowSumR2 += static_cast<double>(R * R);
+            windowSumLR += static_cast<double>(L * R);
+        }
     }
 
-private:
     double currentSampleRate = 44100.0;
 
-    // Crossover filters for multiband analysis
+    // Crossover filters for multiband analysis; the low band is split off the decimated input
+    DSPUtils::DecimationCascade lowBandDecimatorL, lowBandDecimatorR;
+    DSPUtils::LinkwitzRileyCrossover lowCrossoverL, lowCrossoverR;
     DSPUtils::LinkwitzRileyCrossover crossover1L, crossover1R;
     DSPUtils::LinkwitzRileyCrossover crossover2L, crossover2R;
 
-    // Correlation buffers
-    std::deque<float> correlationBufferL;
-    std::deque<float> correlationBufferR;
-
-    // Global measurements
-    std::atomic<float> globalCorrelation { 1.0f };
-    std::atomic<float> globalWidth { 1.0f };
-    std::atomic<float> balance { 0.0f };
-
-    // Per-band measurements
-    std::array<std::atomic<float>, NUM_BANDS> bandCorrelation = { 1.0f, 1.0f, 1.0f };
-    std::array<std::atomic<float>, NUM_BANDS> bandWidth = { 1.0f, 1.0f, 1.0f };
-
-    // Vectorscope
-    mutable std::mutex vectorscopeMutex;
-    std::array<std::pair<float, float>, VECTORSCOPE_SIZE> vectorscopeBuffer;
-    int vectorscopeIndex = 0;
+    // Correlation history (arena memory)
+    DSPUtils::StateArray<float> correlationBufferL;
+    DSPUtils::StateArray<float> correlationBufferR;
+    int correlationIndex = 0;
+
+    // Running sums over the correlation window
+    double windowSumL2 = 0.0;
+    double windowSumR2 = 0.0;
+    double windowSumLR = 0.0;
+
+    // Vectorscope points for the UI (audio thread writes, UI reads)
+    juce::AbstractFifo vectorscopeFifo { VECTORSCOPE_FIFO_SIZE };
+    std::array<VectorscopePoint, VECTORSCOPE_FIFO_SIZE> vectorscopePoints {};
+    int vectorscopeDecimation = 4;
+    int vectorscopePhase = 0;
+
+    // Results: working copy (audio thread) and the last published set
+    StereoFeatures features;
+    DSPUtils::SeqLock<StereoFeatures> publishedFeatures;
 };
@@ -14,15 +14,11 @@ public:
         currentBlockSize = samplesPerBlock;
 
         // Prepare crossovers for multiband width
-        for (int ch = 0; ch < 2; ++ch)
-        {
-            crossover1[ch].prepare(sampleRate);
-            crossover2[ch].prepare(sampleRate);
-        }
+        crossover1.forEach([sampleRate] (auto& crossover) { crossover.prepare(sampleRate); });
+        crossover2.forEach([sampleRate] (auto& crossover) { crossover.prepare(sampleRate); });
 
         // Mono bass filter
-        for (int ch = 0; ch < 2; ++ch)
-            monoBassFilter[ch].makeLowPass(sampleRate, monoBassFreq, 0.707f);
+        monoBassCoeffs.makeLowPass(sampleRate, monoBassFreq, 0.707);
 
         updateCrossovers();
         reset();
@@ -30,23 +26,27 @@ public:
 
     void reset()
     {
-        for (int ch = 0; ch < 2; ++ch)
-        {
-            crossover1[ch].reset();
-            crossover2[ch].reset();
-            monoBassState[ch].reset();
-        }
+        crossover1.forEach([] (auto& crossover) { crossover.reset(); });
+        crossover2.forEach([] (auto& crossover) { crossover.reset(); });
+        monoBassState.forEach([] (auto& state) { state.reset(); });
 
-        correlationBuffer.fill(0.0f);
-        correlationBufferL.fill(0.0f);
-        correlationBufferR.fill(0.0f);
+        std::fill(correlationBufferL.begin(), correlationBufferL.end(), 0.0f);
+        std::fill(correlationBufferR.begin(), correlationBufferR.end(), 0.0f);
         correlationIndex = 0;
         correlation.store(1.0f);
     }
 
-    void process(juce::AudioBuffer<float>& buffer)
+    // Correlation history lives in the owner's arena; call after prepare()
+    void allocateState(DSPUtils::StateArena& arena)
     {
-        if (bypassed)
+        correlationBufferL = arena.allocate<float>(CORRELATION_BUFFER_SIZE);
+        correlationBufferR = arena.allocate<float>(CORRELATION_BUFFER_SIZE);
+    }
+
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer)
+    {
+        if (bypassed || correlationBufferL.isEmpty())
             return;
 
         const int numSamples = buffer.getNumSamples();
@@ -55,63 +55,66 @@ public:
         if (numChannels < 2)
             return;  // Stereo processing requires 2 channels
 
+        // The L/R pair travels through the filters as a two-lane frame
+        auto& lowMidSplit = crossover1.get<SampleType>();
+        auto& midHighSplit = crossover2.get<SampleType>();
+        auto& bassState = monoBassState.get<SampleType>();
+        const auto& bassCoeffs = monoBassCoeffs.get<SampleType>();
+
+        auto* leftChannel = buffer.getWritePointer(0);
+        auto* rightChannel = buffer.getWritePointer(1);
+
+        DSPUtils::ChannelFrame<SampleType> frame, low, midHigh, mid, high, bass;
+
         for (int sample = 0; sample < numSamples; ++sample)
         {
-            float left = buffer.getSample(0, sample);
-            float right = buffer.getSample(1, sample);
+            SampleType left = leftChannel[sample];
+            SampleType right = rightChannel[sample];
 
             // Calculate correlation for metering
-            updateCorrelation(left, right);
-
-            // Convert to M/S
-            float mid = (left + right) * 0.5f;
-            float side = (left - right) * 0.5f;
+            updateCorrelation(static_cast<float>(left), static_cast<float>(right));
 
             if (multibandEnabled)
             {
                 // Split into bands
-                float lowL, midHighL, lowR, midHighR;
-                crossover1[0].process(left, lowL, midHighL);
-                crossover1[1].process(right, lowR, midHighR);
-
-                float midL, highL, midR, highR;
-                crossover2[0].process(midHighL, midL, highL);
-                crossover2[1].process(midHighR, midR, highR);
+                frame[0] = left;
+                frame[1] = right;
+                lowMidSplit.process(frame, low, midHigh, 2);
+                midHighSplit.process(midHigh, mid, high, 2);
 
                 // Process each band with its own width
-                processWidthBand(lowL, lowR, lowWidth);
-                processWidthBand(midL, midR, midWidth);
-                processWidthBand(highL, highR, highWidth);
+                processWidthBand(low[0], low[1], static_cast<SampleType>(lowWidth));
+                processWidthBand(mid[0], mid[1], static_cast<SampleType>(midWidth));
+                processWidthBand(high[0], high[1], static_cast<SampleType>(highWidth));
 
                 // Recombine bands
-                left = lowL + midL + highL;
-                right = lowR + midR + highR;
+                left = low[0] + mid[0] + high[0];
+                right = low[1] + mid[1] + high[1];
             }
             else
             {
                 // Global width processing
-                side *= globalWidth;
-                left = mid + side;
-                right = mid - side;
+                processWidthBand(left, right, static_cast<SampleType>(globalWidth));
             }
 
             // Mono bass if enabled
             if (monoBassEnabled)
             {
                 // Extract bass content
-                float bassL = monoBassState[0].process(left, monoBassCoeffs);
-                float bassR = monoBassState[1].process(right, monoBassCoeffs);
+                bass[0] = left;
+                bass[1] = right;
+                bassState.process(bass, 2, bassCoeffs);
 
                 // Make bass mono
-                float bassMono = (bassL + bassR) * 0.5f;
+                SampleType bassMono = (bass[0] + bass[1]) * SampleType(0.5);
 
                 // Remove original bass and add mono bass
-                left = (left - bassL) + bassMono;
-                right = (right - bassR) + bassMono;
+                left = (left - bass[0]) + bassMono;
+                right = (right - bass[1]) + bassMono;
             }
 
-            buffer.setSample(0, sample, left);
-            buffer.setSample(1, sample, right);
+            leftChannel[sample] = left;
+            rightChannel[sample] = right;
         }
     }
 
@@ -158,8 +161,7 @@ public:
     void setMonoBassFrequency(float freqHz)
     {
         monoBassFreq = juce::jlimit(60.0f, 300.0f, freqHz);
-        for (int ch = 0; ch < 2; ++ch)
-            monoBassCoeffs.makeLowPass(currentSampleRate, monoBassFreq, 0.707f);
+        monoBassCoeffs.makeLowPass(currentSampleRate, monoBassFreq, 0.707);
     }
 
     void setMonoBassEnabled(bool enabled)
@@ -184,17 +186,15 @@ public:
 private:
     void updateCrossovers()
     {
-        for (int ch = 0; ch < 2; ++ch)
-        {
-            crossover1[ch].setCrossoverFrequency(lowMidCrossover);
-            crossover2[ch].setCrossoverFrequency(midHighCrossover);
-        }
+        crossover1.forEach([this] (auto& crossover) { crossover.setCrossoverFrequency(lowMidCrossover); });
+        crossover2.forEach([this] (auto& crossover) { crossover.setCrossoverFrequency(midHighCrossover); });
     }
 
-    void processWidthBand(float& left, float& right, float width)
+    template <typename SampleType>
+    static void processWidthBand(SampleType& left, SampleType& right, SampleType width)
     {
-        float mid = (left + right) * 0.5f;
-        float side = (left - right) * 0.5f;
+        SampleType mid = (left + right) * SampleType(0.5);
+        SampleType side = (left - right) * SampleType(0.5);
         side *= width;
         left = mid + side;
         right = mid - side;
@@ -205,7 +205,6 @@ private:
         // Store samples in circular buffer
         correlationBufferL[correlationIndex] = left;
         correlationBufferR[correlationIndex] = right;
-        correlationBuffer[correlationIndex] = left * right;
         correlationIndex = (correlationIndex + 1) % CORRELATION_BUFFER_SIZE;
 
         // Calculate correlation every CORRELATION_BUFFER_SIZE samples
@@ -241,20 +240,20 @@ private:
     // Crossover settings
     float lowMidCrossover = 200.0f;
     float midHighCrossover = 3000.0f;
-    DSPUtils::LinkwitzRileyCrossover crossover1[2];
-    DSPUtils::LinkwitzRileyCrossover crossover2[2];
+    DSPUtils::PerSampleType<DSPUtils::MultiChannelCrossover> crossover1;
+    DSPUtils::PerSampleType<DSPUtils::MultiChannelCrossover> crossover2;
 
     // Mono bass
     float monoBassFreq = 120.0f;
     bool monoBassEnabled = false;
-    DSPUtils::BiquadCoeffs monoBassCoeffs;
-    DSPUtils::BiquadState monoBassState[2];
-    DSPUtils::BiquadCoeffs monoBassFilter[2];
-
-    // Correlation metering
-    std::array<float, CORRELATION_BUFFER_SIZE> correlationBuffer;
-    std::array<float, CORRELATION_BUFFER_SIZE> correlationBufferL;
-    std::array<float, CORRELATION_BUFFER_SIZE> correlationBufferR;
+    DSPUtils::BiquadDesign monoBassCoeffs;
+    DSPUtils::PerSampleType<DSPUtils::MultiChannelBiquadState> monoBassState;
+
+    // Correlation history (arena memory)
+    DSPUtils::StateArray<float> correlationBufferL;
+    DSPUtils::StateArray<float> correlationBufferR;
     int correlationIndex = 0;
-    std::atomic<float> correlation { 1.0f };
+
+    // Metering (own cache line: written by the audio thread, polled by the UI)
+    alignas(DSPUtils::CACHE_LINE_SIZE) std::atomic<float> correlation { 1.0f };
 };
@@ -0,0 +1,3 @@
+// WaveformPyramid implementation
+// All functionality is in the header file
+#include "WaveformPyramid.h"
@@ -0,0 +1,298 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Waveform overview of a whole track as a min/max/RMS pyramid, for drawing
+// at any width or zoom.
+//
+// Level 0 has one entry per BASE_SAMPLES samples; each level above merges
+// LEVEL_FACTOR entries of the one below, up to a single entry. Entries are
+// 16-bit, 6 bytes each, so an hour at 48 kHz takes about 1.3 MB in all.
+// getRange() reads from the coarsest level no wider than a pixel, so a
+// repaint costs O(pixels) however long the track.
+//
+// Built by Builder during the reference decode; the cache stores level 0
+// only and the levels above are rebuilt on load.
+class WaveformPyramid
+{
+public:
+    static constexpr int BASE_SAMPLES = 1024;
+    static constexpr int LEVEL_FACTOR = 4;
+
+    // One pixel's worth, linear -1 to 1
+    struct Peak
+    {
+        float min = 0.0f;
+        float max = 0.0f;
+        float rms = 0.0f;
+    };
+
+    // Level 0 for one stretch of a track. Entries sit on a fixed grid in
+    // track positions, so stretches built on separate threads merge into
+    // the whole.
+    class Builder
+    {
+    public:
+        void prepare(int64_t startSample)
+        {
+            firstEntry = startSample / BASE_SAMPLES;
+            mins.clear();
+            maxs.clear();
+            squares.clear();
+        }
+
+        // position is the track position of the first sample; right may
+        // repeat left for a mono track
+        void process(const float* left, const float* right, int64_t position, int count)
+        {
+            for (int i = 0; i < count;)
+            {
+                const int64_t samplePosition = position + i;
+                const size_t entry = static_cast<size_t>(samplePosition / BASE_SAMPLES - firstEntry);
+                const int run = static_cast<int>(std::min(static_cast<int64_t>(count - i), BASE_SAMPLES - samplePosition % BASE_SAMPLES));
+
+                if (entry >= mins.size())
+                {
+                    mins.resize(entry + 1, std::numeric_limits<float>::max());
+                    maxs.resize(entry + 1, std::numeric_limits<float>::lowest());
+                    squares.resize(entry + 1, 0.0);
+                }
+
+                float low = mins[entry];
+                float high = maxs[entry];
+                float sumSquares = 0.0f;
+
+                for (int k = i; k < i + run; ++k)
+                {
+                    low = std::min(low, std::min(left[k], right[k]));
+                    high = std::max(high, std::max(left[k], right[k]));
+                    sumSquares += left[k] * left[k] + right[k] * right[k];
+                }
+
+                mins[entry] = low;
+                maxs[entry] = high;
+                squares[entry] += 0.5 * sumSquares;
+                i += run;
+            }
+        }
+
+        // Adds another stretch of the same track, in any order
+        void merge(const Builder& other)
+        {
+            const int64_t mergedFirst = std::min(firstEntry, other.firstEntry);
+            const int64_t mergedEnd = std::max(firstEntry + static_cast<int64_t>(mins.size()),
+                                               other.firstEntry + static_cast<int64_t>(other.mins.size()));
+            const size_t size = static_cast<size_t>(mergedEnd - mergedFirst);
+
+            std::vector<float> mergedMins(size, std::numeric_limits<float>::max());
+            std::vector<float> mergedMaxs(size, std::numeric_limits<float>::lowest());
+            std::vector<double> mergedSquares(size, 0.0);
+
+            for (const Builder* source : { static_cast<const Builder*>(this), &other })
+            {
+                const size_t offset = static_cast<size_t>(source->firstEntry - mergedFirst);
+                for (size_t e = 0; e < source->mins.size(); ++e)
+                {
+                    mergedMins[offset + e] = std::min(mergedMins[offset + e], source->mins[e]);
+                    mergedMaxs[offset + e] = std::max(mergedMaxs[offset + e], source->maxs[e]);
+                    mergedSquares[offset + e] += source->squares[e];
+                }
+            }
+
+            firstEntry = mergedFirst;
+            mins = std::move(mergedMins);
+            maxs = std::move(mergedMaxs);
+            squares = std::move(mergedSquares);
+        }
+
+        // Once every stretch of the track has been merged in
+        void finish(WaveformPyramid& dest, int64_t lengthInSamples, double sampleRate) const
+        {
+            dest.length = lengthInSamples;
+            dest.sampleRate = sampleRate;
+
+            const size_t numEntries = static_cast<size_t>((lengthInSamples + BASE_SAMPLES - 1) / BASE_SAMPLES);
+            std::vector<Entry> base(numEntries);
+
+            for (size_t e = 0; e < numEntries; ++e)
+            {
+                const int64_t index = static_cast<int64_t>(e) - firstEntry;
+                if (index < 0 || index >= static_cast<int64_t>(mins.size()) || mins[static_cast<size_t>(index)] > maxs[static_cast<size_t>(index)])
+                    continue;
+
+                const int64_t entrySamples = std::min(static_cast<int64_t>(BASE_SAMPLES), lengthInSamples - static_cast<int64_t>(e) * BASE_SAMPLES);
+                const auto i = static_cast<size_t>(index);
+                base[e] = makeEntry(mins[i], maxs[i], static_cast<float>(std::sqrt(squares[i] / static_cast<double>(entrySamples))));
+            }
+
+            dest.setBaseLevel(std::move(base));
+        }
+
+    private:
+        int64_t firstEntry = 0;
+        std::vector<float> mins, maxs;
+        std::vector<double> squares;  // Mean of the channels' squares, summed
+    };
+
+    bool isEmpty() const { return levels.empty(); }
+    int64_t getLengthInSamples() const { return length; }
+    double getSampleRate() const { return sampleRate; }
+    double getDurationSeconds() const { return sampleRate > 0.0 ? static_cast<double>(length) / sampleRate : 0.0; }
+
+    // One peak per pixel across samples [startSample, endSample)
+    void getRange(int64_t startSample, int64_t endSample, Peak* dest, int numPixels) const
+    {
+        if (numPixels <= 0)
+            return;
+
+        if (levels.empty() || endSample <= startSample)
+        {
+            std::fill(dest, dest + numPixels, Peak {});
+            return;
+        }
+
+        const double pixelSamples = static_cast<double>(endSample - startSample) / numPixels;
+
+        // The coarsest level whose entries are no wider than a pixel
+        size_t level = 0;
+        int64_t entrySamples = BASE_SAMPLES;
+        while (level + 1 < levels.size() && entrySamples * LEVEL_FACTOR <= pixelSamples)
+        {
+            ++level;
+            entrySamples *= LEVEL_FACTOR;
+        }
+
+        const auto& entries = levels[level];
+        const int64_t numEntries = static_cast<int64_t>(entries.size());
+
+        for (int pixel = 0; pixel < numPixels; ++pixel)
+        {
+            const double pixelStart = static_cast<double>(startSample) + pixel * pixelSamples;
+            const int64_t first = juce::jlimit(int64_t { 0 }, numEntries, static_cast<int64_t>(std::floor(pixelStart / entrySamples)));
+            const int64_t end = juce::jlimit(first, numEntries,
+                                             std::max(first + 1, static_cast<int64_t>(std::ceil((pixelStart + pixelSamples) / entrySamples))));
+
+            Peak peak;
+            if (first < end)
+            {
+                float low = 1.0f, high = -1.0f, sumSquares = 0.0f;
+                for (int64_t e = first; e < end; ++e)
+                {
+                    const Entry& entry = entries[static_cast<size_t>(e)];
+                    low = std::min(low, toFloat(entry.min));
+                    high = std::max(high, toFloat(entry.max));
+                    const float rms = entry.rms / 32767.0f;
+                    sumSquares += rms * rms;
+                }
+
+                peak = { low, high, std::sqrt(sumSquares / static_cast<float>(end - first)) };
+            }
+
+            dest[pixel] = peak;
+        }
+    }
+
+    // Level 0 only; readFrom() rebuilds the rest
+    void writeTo(juce::OutputStream& stream) const
+    {
+        stream.writeInt64(length);
+        stream.writeDouble(sampleRate);
+
+        const auto& base = levels.empty() ? std::vector<Entry>() : levels.front();
+        stream.writeInt(static_cast<int>(base.size()));
+        for (const Entry& entry : base)
+        {
+            stream.writeShort(entry.min);
+            stream.writeShort(entry.max);
+            stream.writeShort(static_cast<short>(entry.rms));
+        }
+    }
+
+    // False if the stream doesn't hold a consistent pyramid
+    bool readFrom(juce::InputStream& stream)
+    {
+        const int64_t storedLength = stream.readInt64();
+        const double storedRate = stream.readDouble();
+        const int numEntries = stream.readInt();
+
+        if (storedLength < 0 || numEntries != static_cast<int>((storedLength + BASE_SAMPLES - 1) / BASE_SAMPLES))
+            return false;
+
+        std::vector<Entry> base(static_cast<size_t>(numEntries));
+        for (Entry& entry : base)
+        {
+            entry.min = stream.readShort();
+            entry.max = stream.readShort();
+            entry.rms = static_cast<uint16_t>(stream.readShort());
+        }
+
+        length = storedLength;
+        sampleRate = storedRate;
+        setBaseLevel(std::move(base));
+        return true;
+    }
+
+private:
+    struct Entry
+    {
+        int16_t min = 0;
+        int16_t max = 0;
+        uint16_t rms = 0;
+    };
+
+    static int16_t quantize(float value)
+    {
+        return static_cast<int16_t>(std::lround(juce::jlimit(-1.0f, 1.0f, value) * 32767.0f));
+    }
+
+    static float toFloat(int16_t value) { return value / 32767.0f; }
+
+    static Entry makeEntry(float min, float max, float rms)
+    {
+        return { quantize(min), quantize(max), static_cast<uint16_t>(std::lround(juce::jlimit(0.0f, 1.0f, rms) * 32767.0f)) };
+    }
+
+    void setBaseLevel(std::vector<Entry> base)
+    {
+        levels.clear();
+        if (base.empty())
+            return;
+
+        levels.push_back(std::move(base));
+
+        while (levels.back().size() > 1)
+        {
+            const auto& below = levels.back();
+            std::vector<Entry> level((below.size() + LEVEL_FACTOR - 1) / LEVEL_FACTOR);
+
+            for (size_t e = 0; e < level.size(); ++e)
+            {
+                const size_t first = e * LEVEL_FACTOR;
+                const size_t end = std::min(first + LEVEL_FACTOR, below.size());
+
+                int16_t low = below[first].min, high = below[first].max;
+                float sumSquares = 0.0f;
+                for (size_t b = first; b < end; ++b)
+                {
+                    low = std::min(low, below[b].min);
+                    high = std::max(high, below[b].max);
+                    const float rms = below[b].rms / 32767.0f;
+                    sumSquares += rms * rms;
+                }
+
+                level[e] = { low, high, static_cast<uint16_t>(std::lround(std::sqrt(sumSquares / static_cast<float>(end - first)) * 32767.0f)) };
+            }
+
+            levels.push_back(std::move(level));
+        }
+    }
+
+    int64_t length = 0;
+    double sampleRate = 44100.0;
+    std::vector<std::vector<Entry>> levels;
+};
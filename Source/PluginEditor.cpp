@@ -206,12 +206,17 @@ AutomasterAudioProcessorEditor::AutomasterAudioProcessorEditor(AutomasterAudioPr
     addKeyListener(this);  // Listen for keys from all child components
     setSize(kWindowWidth, kWindowHeight);
 
+    // Detailed analysis only runs while something is displaying it
+    proc.getAnalysisEngine().addConsumer(AnalysisEngine::Consumer::Editor);
+
     // Start meter update timer
     startTimerHz(30);
 }
 
 AutomasterAudioProcessorEditor::~AutomasterAudioProcessorEditor()
 {
+    proc.getAnalysisEngine().removeConsumer(AnalysisEngine::Consumer::Editor);
+
     // Clear custom LookAndFeels before components are destroyed
     autoMasterButton.setLookAndFeel(nullptr);
     analyzeButton.setLookAndFeel(nullptr);
@@ -323,10 +328,26 @@ void AutomasterAudioProcessorEditor::setupTopBar()
         abcdButtons[i].setButtonText(labels[i]);
         abcdButtons[i].onClick = [this, i]()
         {
+            // Alt-click empties another slot, so its chain stops running
+            if (juce::ModifierKeys::currentModifiers.isAltDown() && i != proc.getSelectedSlot())
+            {
+                proc.clearState(i);
+                abcdButtons[i].setToggleState(false, juce::dontSendNotification);
+                return;
+            }
+
             if (abcdButtons[i].getToggleState())
+            {
                 proc.recallState(i);
+
+                // Each slot has its own chain; follow the one now selected
+                chainView.setChain(&proc.getMasteringChain());
+                spectrumAnalyzer.setEQ(&proc.getMasteringChain().getEQ());
+            }
             else
+            {
                 proc.storeState(i);
+            }
             abcdButtons[i].setToggleState(true, juce::dontSendNotification);
             for (int j = 0; j < 4; ++j)
                 if (j != i) abcdButtons[j].setToggleState(false, juce::dontSendNotification);
@@ -334,7 +355,7 @@ void AutomasterAudioProcessorEditor::setupTopBar()
         abcdButtons[i].setClickingTogglesState(true);
         addAndMakeVisible(abcdButtons[i]);
     }
-    abcdButtons[0].setToggleState(true, juce::dontSendNotification);
+    abcdButtons[proc.getSelectedSlot()].setToggleState(true, juce::dontSendNotification);
 
     // Settings button with consistent style
     settingsButton.setButtonText("Settings");
@@ -384,13 +405,7 @@ void AutomasterAudioProcessorEditor::setupReferenceSection()
         {
             auto file = fc.getResult();
             if (file.existsAsFile())
-            {
-                if (proc.loadReferenceFile(file))
-                {
-                    referenceWaveform.loadFile(file);
-                    referenceWaveform.setProfile(&proc.getReferenceProfile());
-                }
-            }
+                proc.loadReferenceFile(file);
         });
     };
     addAndMakeVisible(loadRefButton);
@@ -508,6 +523,10 @@ void AutomasterAudioProcessorEditor::setupMeterSection()
     // Make LUFS meter clickable to show target popup
     lufsMeter.onClick = [this]() { showTargetLUFSPopup(); };
 
+    complianceReportLabel.setFont(juce::FontOptions(juce::Font::getDefaultMonospacedFontName(), 10.0f, juce::Font::plain));
+    complianceReportLabel.setColour(juce::Label::textColourId, juce::Colour(0xFFcccccc));
+    complianceReportLabel.setJustificationType(juce::Justification::topLeft);
+
     inputLabel.setText("IN", juce::dontSendNotification);
     inputLabel.setJustificationType(juce::Justification::centred);
     inputLabel.setFont(juce::FontOptions(10.0f).withStyle("Bold"));
@@ -1494,11 +1513,13 @@ void AutomasterAudioProcessorEditor::updateMeters()
     auto& chain = proc.getMasteringChain();
     auto& analysis = proc.getAnalysisEngine();
 
-    auto& inputMeter = chain.getInputMeter();
-    auto& outputMeter = chain.getOutputMeter();
+    auto& metering = proc.getMeteringService();
+    auto& outputMeter = metering.getOutputMeter();
 
-    inputMeterL.setLevel(inputMeter.getPeakLevelL());
-    inputMeterR.setLevel(inputMeter.getPeakLevelR());
+    // Input meters show the level the chain's stages receive
+    const float inputTrim = chain.getInputTrimDB();
+    inputMeterL.setLevel(metering.getTrimmedInputPeakL(inputTrim));
+    inputMeterR.setLevel(metering.getTrimmedInputPeakR(inputTrim));
     outputMeterL.setLevel(outputMeter.getPeakLevelL());
     outputMeterR.setLevel(outputMeter.getPeakLevelR());
 
@@ -1529,32 +1550,49 @@ bool AutomasterAudioProcessorEditor::isInterestedInFileDrag(const juce::StringAr
         if (file.endsWith(".wav") || file.endsWith(".aiff") ||
             file.endsWith(".mp3") || file.endsWith(".flac"))
             return true;
+
+        // A folder becomes the reference library
+        if (juce::File(file).isDirectory())
+            return true;
     }
     return false;
 }
 
-void AutomasterAudioProcessorEditor::filesDropped(const juce::StringArray& files, int, int)
+void AutomasterAudioProcessorEditor::filesDropped(const juce::StringArray& files, int x, int y)
 {
+    // A mix dropped onto the spectrum is analyzed and auto-mastered from
+    // (alt: the whole file rather than its loudest stretch); anywhere else
+    // a file becomes the reference
+    const bool ontoMixAnalysis = spectrumAnalyzer.isVisible() && spectrumAnalyzer.getBounds().contains(x, y);
+
     for (const auto& filePath : files)
     {
         juce::File file(filePath);
-        if (file.existsAsFile())
+        if (ontoMixAnalysis)
+        {
+            if (file.existsAsFile()
+                && proc.autoMasterFromFile(file, !juce::ModifierKeys::currentModifiers.isAltDown()))
+                break;
+        }
+        else if (file.isDirectory())
+        {
+            if (proc.scanReferenceLibrary(file))
+                break;
+        }
+        else if (file.existsAsFile())
         {
             if (proc.loadReferenceFile(file))
-            {
-                referenceWaveform.loadFile(file);
-                referenceWaveform.setProfile(&proc.getReferenceProfile());
                 break;
-            }
         }
     }
 }
 
 void AutomasterAudioProcessorEditor::showTargetLUFSPopup()
 {
-    // Create a component to hold the target LUFS knob
+    // Create a component to hold the target LUFS knob and, below it, how the
+    // output measures against the delivery standards so far
     auto* popupContent = new juce::Component();
-    popupContent->setSize(120, 100);
+    popupContent->setSize(640, 210);
 
     // Add a label
     auto* label = new juce::Label();
@@ -1562,14 +1600,22 @@ void AutomasterAudioProcessorEditor::showTargetLUFSPopup()
     label->setFont(juce::FontOptions(12.0f).withStyle("Bold"));
     label->setColour(juce::Label::textColourId, juce::Colour(0xFFcccccc));
     label->setJustificationType(juce::Justification::centred);
-    label->setBounds(0, 5, 120, 18);
+    label->setBounds(260, 5, 120, 18);
     popupContent->addAndMakeVisible(label);
 
     // Make the target knob visible and add to popup
     targetLUFSKnob.setVisible(true);
-    targetLUFSKnob.setBounds(38, 25, 44, 56);
+    targetLUFSKnob.setBounds(298, 25, 44, 56);
     popupContent->addAndMakeVisible(targetLUFSKnob);
 
+    // A snapshot of the report; reopen the popup to refresh it
+    const auto report = proc.getComplianceReport();
+    complianceReportLabel.setText(report.hasProgram ? juce::String(report.toText())
+                                                    : juce::String("Compliance: nothing above the gate measured yet"),
+                                  juce::dontSendNotification);
+    complianceReportLabel.setBounds(5, 88, 630, 117);
+    popupContent->addAndMakeVisible(complianceReportLabel);
+
     // Show as callout
     auto& callout = juce::CallOutBox::launchAsynchronously(
         std::unique_ptr<juce::Component>(popupContent),
@@ -1585,12 +1631,38 @@ void AutomasterAudioProcessorEditor::timerCallback()
     updateMeters();
     spectrumAnalyzer.repaint();  // Update EQ curve display
 
+    // Library indexing and reference decoding run in the background; show
+    // the reference once applied
+    if (proc.isReferenceLibraryScanning())
+        referenceWaveform.setLoading("Indexing reference library", proc.getReferenceLibraryProgress());
+    else if (proc.isReferenceLoading())
+        referenceWaveform.setLoading("Loading " + proc.getLoadingReferenceName(), proc.getReferenceLoadProgress());
+    else
+        referenceWaveform.stopLoading();
+
+    if (proc.getReferenceVersion() != shownReferenceVersion)
+    {
+        shownReferenceVersion = proc.getReferenceVersion();
+
+        if (proc.hasReference())
+        {
+            referenceWaveform.setWaveform(proc.getReferenceWaveform(), proc.getReferenceFileName(), proc.getReferenceDuration());
+            referenceWaveform.setProfile(&proc.getReferenceProfile());
+        }
+        else
+        {
+            referenceWaveform.clear();
+        }
+    }
+
     // Update analysis state (Ozone-style workflow)
     bool isAnalyzing = proc.isAnalyzing();
     bool hasAnalysis = proc.hasValidAnalysis();
 
-    // Update progress bar
-    analysisProgress = proc.getAnalysisProgress();
+    // Update progress bar; an offline analysis (dropped mix or captured
+    // input) reports its own progress
+    analysisProgress = proc.isOfflineAnalysisRunning() ? proc.getOfflineAnalysisProgress()
+                                                       : proc.getAnalysisProgress();
 
     // Update button state
     if (isAnalyzing)
@@ -34,12 +34,14 @@ private:
 
     // Reference section
     ReferenceWaveform referenceWaveform;
+    int shownReferenceVersion = -1;  // Processor reference version on display
     juce::TextButton loadRefButton;
     MatchIndicator matchIndicator;
     juce::ComboBox profileCombo;
 
     // Mode section
     gin::Knob targetLUFSKnob;
+    juce::Label complianceReportLabel;  // Shown with the target knob in the LUFS popup
     juce::TextButton autoMasterButton;
 
     // Analysis section (Ozone-style workflow)
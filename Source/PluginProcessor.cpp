@@ -8,6 +8,12 @@ static const char* percentTextFunction (const gin::Parameter&, float v)
     return txt;
 }
 
+// Less captured input than this isn't worth analyzing in place of the live readings
+static constexpr double minCapturedSecondsForAutoMaster = 5.0;
+
+// Stretch of a dropped mix file the auto-master analyzes: about a chorus
+static constexpr double mixFileSectionSeconds = 30.0;
+
 AutomasterAudioProcessor::AutomasterAudioProcessor()
     : gin::Processor(BusesProperties()
                      .withInput("Input", juce::AudioChannelSet::stereo(), true)
@@ -184,12 +190,51 @@ AutomasterAudioProcessor::AutomasterAudioProcessor()
     // Initialize Gin
     init();
 
+    analysisEngine.useSharedLoudnessMeter(metering.getInputMeter());
+
+    // Same order as ParameterSnapshot::Index
+    snapshotParameters = {
+        inputGain, outputGain, targetLUFS, autoMasterEnabled,
+        hpfFreq, hpfEnabled, lpfFreq, lpfEnabled,
+        lowShelfFreq, lowShelfGain, highShelfFreq, highShelfGain,
+        bandFreq[0], bandFreq[1], bandFreq[2], bandFreq[3],
+        bandGain[0], bandGain[1], bandGain[2], bandGain[3],
+        bandQ[0], bandQ[1], bandQ[2], bandQ[3],
+        eqBypass,
+        lowMidXover, midHighXover,
+        compThreshold[0], compThreshold[1], compThreshold[2],
+        compRatio[0], compRatio[1], compRatio[2],
+        compAttack[0], compAttack[1], compAttack[2],
+        compRelease[0], compRelease[1], compRelease[2],
+        compMakeup[0], compMakeup[1], compMakeup[2],
+        compBypass,
+        globalWidth, lowWidth, midWidth, highWidth, monoBassFreq, monoBassEnabled, stereoBypass,
+        ceiling, limiterRelease, limiterBypass
+    };
+
+    for (auto* param : snapshotParameters)
+        param->juce::AudioProcessorParameter::addListener(this);
+
+    lastAutoMasterSnapshot = captureSnapshot();
+    parameterHistory.reset(lastAutoMasterSnapshot);
+
+    // Runs on the analysis thread; hop over to the message thread
+    analysisEngine.onOfflineAnalysisComplete = [this] { triggerAsyncUpdate(); };
+    referenceLoader.onLoadComplete = [this] { triggerAsyncUpdate(); };
+    referenceLibrary.onScanComplete = [this] { triggerAsyncUpdate(); };
+
     // Load learning data
     learningSystem.loadFromFile(LearningSystem::getDefaultFilePath());
 }
 
 AutomasterAudioProcessor::~AutomasterAudioProcessor()
 {
+    referenceLoader.cancel();
+    referenceLibrary.cancel();
+
+    for (auto* param : snapshotParameters)
+        param->juce::AudioProcessorParameter::removeListener(this);
+
     // Save learning data
     if (learningSystem.hasUnsavedChanges())
     {
@@ -203,22 +248,31 @@ void AutomasterAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBl
 {
     gin::Processor::prepareToPlay(sampleRate, samplesPerBlock);
 
-    masteringChain.prepare(sampleRate, samplesPerBlock);
-    analysisEngine.prepare(sampleRate, samplesPerBlock);
+    auto layout = getChannelLayoutOfBus(true, 0);
+    comparisonChains.prepare(sampleRate, samplesPerBlock, layout, getProcessingPrecision());
+    metering.prepare(sampleRate, samplesPerBlock, layout);
+
+    // A bounce is a program of its own; prepare() alone keeps integrating
+    if (isNonRealtime())
+        metering.resetProgram();
+    analysisEngine.prepare(sampleRate, samplesPerBlock, layout);
 
     // Report limiter latency to host for delay compensation
-    setLatencySamples(masteringChain.getLatencySamples());
+    setLatencySamples(comparisonChains.getLatencySamples());
 }
 
 void AutomasterAudioProcessor::releaseResources()
 {
-    masteringChain.reset();
+    comparisonChains.releaseResources();
+    metering.reset();
     analysisEngine.reset();
 }
 
 bool AutomasterAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
 {
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Mono, stereo and immersive layouts (5.1, 7.1.4, ...) up to MAX_CHANNELS
+    const auto& output = layouts.getMainOutputChannelSet();
+    if (output.isDisabled() || output.size() > DSPUtils::MAX_CHANNELS)
         return false;
 
     if (layouts.getMainInputChannelSet() != layouts.getMainOutputChannelSet())
@@ -227,28 +281,49 @@ bool AutomasterAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts
     return true;
 }
 
-void AutomasterAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+void AutomasterAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    processSamples(buffer);
+}
+
+void AutomasterAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    processSamples(buffer);
+}
+
+template <typename SampleType>
+void AutomasterAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer)
 {
     juce::ScopedNoDenormals noDenormals;
 
-    // Update processing parameters from Gin parameters
-    updateProcessingFromParameters();
+    // Continuous auto-master keeps the detailed analysis running with the editor closed
+    analysisEngine.setConsumerActive(AnalysisEngine::Consumer::ContinuousAutoMaster,
+                                     autoMasterEnabled->isOn());
+
+    // Update processing parameters from Gin parameters; other comparison
+    // slots keep the settings they were stored with
+    comparisonChains.forEachChainFollowingParameters([this] (MasteringChain& chain)
+    {
+        updateProcessingFromParameters(chain);
+    });
 
     // Run analysis on input
+    metering.processInput(buffer);
     analysisEngine.process(buffer);
 
-    // Apply mastering chain
-    masteringChain.process(buffer);
+    // Apply mastering chain(s)
+    comparisonChains.process(buffer);
+    metering.processOutput(buffer);
 }
 
-void AutomasterAudioProcessor::updateProcessingFromParameters()
+void AutomasterAudioProcessor::updateProcessingFromParameters(MasteringChain& chain)
 {
     // Global
-    masteringChain.setInputGain(inputGain->getProcValue());
-    masteringChain.setOutputGain(outputGain->getProcValue());
+    chain.setInputGain(inputGain->getProcValue());
+    chain.setOutputGain(outputGain->getProcValue());
 
     // EQ
-    auto& eq = masteringChain.getEQ();
+    auto& eq = chain.getEQ();
     eq.setHPFFrequency(hpfFreq->getProcValue());
     eq.setHPFEnabled(hpfEnabled->isOn());
     eq.setLPFFrequency(lpfFreq->getProcValue());
@@ -267,7 +342,7 @@ void AutomasterAudioProcessor::updateProcessingFromParameters()
     eq.setBypass(eqBypass->isOn());
 
     // Compressor
-    auto& comp = masteringChain.getCompressor();
+    auto& comp = chain.getCompressor();
     comp.setLowMidCrossover(lowMidXover->getProcValue());
     comp.setMidHighCrossover(midHighXover->getProcValue());
 
@@ -282,7 +357,7 @@ void AutomasterAudioProcessor::updateProcessingFromParameters()
     comp.setBypass(compBypass->isOn());
 
     // Stereo
-    auto& stereo = masteringChain.getStereoImager();
+    auto& stereo = chain.getStereoImager();
     stereo.setGlobalWidth(globalWidth->getProcValue());
     stereo.setLowWidth(lowWidth->getProcValue());
     stereo.setMidWidth(midWidth->getProcValue());
@@ -292,7 +367,7 @@ void AutomasterAudioProcessor::updateProcessingFromParameters()
     stereo.setBypass(stereoBypass->isOn());
 
     // Limiter
-    auto& limiter = masteringChain.getLimiter();
+    auto& limiter = chain.getLimiter();
     limiter.setCeiling(ceiling->getProcValue());
     limiter.setRelease(limiterRelease->getProcValue());
     limiter.setTargetLUFS(targetLUFS->getProcValue());
@@ -301,21 +376,47 @@ void AutomasterAudioProcessor::updateProcessingFromParameters()
 
 bool AutomasterAudioProcessor::loadReferenceFile(const juce::File& file)
 {
-    ReferenceProfile newProfile;
-    if (newProfile.loadFromFile(file))
-    {
-        newProfile.setName(file.getFileNameWithoutExtension().toStdString());
-        currentReference = newProfile;
-        analysisEngine.setReferenceProfile(currentReference);
-        rulesEngine.setReferenceProfile(currentReference);
-        rulesEngine.setMode(RulesEngine::Mode::Reference);
-        return true;
-    }
-    return false;
+    return referenceLoader.load(file);
+}
+
+bool AutomasterAudioProcessor::loadBestMatchingReference()
+{
+    const auto results = analysisEngine.getResults();
+    const float loudness = AnalysisEngine::getMatchLoudness(results.integratedLUFS, results.shortTermLUFS);
+    if (loudness <= DSPUtils::MINUS_INFINITY_DB)
+        return false;
+
+    // Same features the live match score uses
+    const auto current = ReferenceProfile::makeMatchFeatures(results.bandEnergies, loudness,
+                                                             results.stereo.width, results.stereo.correlation);
+    const auto matches = referenceLibrary.findClosest(current);
+    if (matches.empty())
+        return false;
+
+    return loadReferenceFile(matches.front().file);
+}
+
+void AutomasterAudioProcessor::applyLoadedReference(ReferenceLoader::Result& loaded)
+{
+    currentReference = loaded.profile;
+    analysisEngine.setReferenceProfile(currentReference);
+    rulesEngine.setReferenceProfile(currentReference);
+    rulesEngine.setMode(RulesEngine::Mode::Reference);
+
+    referenceWaveform = std::make_shared<const WaveformPyramid>(std::move(loaded.waveform));
+    referenceFile = loaded.file;
+    referenceDuration = loaded.durationSeconds;
+    ++referenceVersion;
 }
 
 void AutomasterAudioProcessor::clearReference()
 {
+    referenceLoader.cancel();
+    referenceWaveform.reset();
+    referenceFile = juce::File();
+    referenceDuration = 0.0;
+    ++referenceVersion;
+
     currentReference = ReferenceProfile();
     analysisEngine.clearReferenceProfile();
     rulesEngine.setMode(RulesEngine::Mode::Instant);
@@ -331,13 +432,49 @@ void AutomasterAudioProcessor::stopAnalysis()
     analysisEngine.stopAccumulation();
 }
 
-void AutomasterAudioProcessor::triggerAutoMaster()
+bool AutomasterAudioProcessor::triggerAutoMaster()
+{
+    return runAutoMaster(false);
+}
+
+bool AutomasterAudioProcessor::runAutoMaster(bool offlineAnalysisLanded)
 {
+    // An analysis is already under way; its result applies when it lands
+    if (analysisEngine.isOfflineAnalysisRunning())
+        return false;
+
+    autoMasterPending = false;
+
+    // The analysis this run waited for has been superseded since
+    if (offlineAnalysisLanded && !analysisEngine.hasValidAccumulation())
+        return false;
+
+    // The loudest section of what has played (the chorus or drop, usually)
+    // sets the processing and the level; failing that the whole-track
+    // average. Copies the timeline, which is fine on the message thread.
+    const auto loudestSection = offlineAnalysisLanded ? AnalysisEngine::AccumulatedAnalysis {}
+                                                      : analysisEngine.getLoudestSectionAnalysis();
+
+    // Nothing to go on: analyze what already played rather than asking for a replay
+    if (!loudestSection.isValid
+        && !analysisEngine.hasValidAccumulation()
+        && analysisEngine.getCapturedSeconds() >= minCapturedSecondsForAutoMaster
+        && analysisEngine.analyzeCapturedInput())
+    {
+        autoMasterPending = true;
+        return false;
+    }
+
     // Use accumulated analysis if available (Ozone-style), otherwise use real-time
     AnalysisEngine::AnalysisResults results;
     float lufsForAutoGain;
 
-    if (analysisEngine.hasValidAccumulation())
+    if (loudestSection.isValid)
+    {
+        results = analysisEngine.getResultsFor(loudestSection);
+        lufsForAutoGain = results.shortTermLUFS;  // The section's average LUFS
+    }
+    else if (analysisEngine.hasValidAccumulation())
     {
         results = analysisEngine.getAccumulatedResults();
         lufsForAutoGain = results.shortTermLUFS;  // Use accumulated average LUFS
@@ -359,10 +496,49 @@ void AutomasterAudioProcessor::triggerAutoMaster()
 
     lastGeneratedParams = params;
     applyGeneratedParameters(params, lufsForAutoGain);
+    return true;
+}
+
+bool AutomasterAudioProcessor::autoMasterFromFile(const juce::File& file, bool loudestSectionOnly)
+{
+    const bool started = loudestSectionOnly ? analysisEngine.analyzeLoudestSection(file, mixFileSectionSeconds)
+                                            : analysisEngine.analyzeFile(file);
+
+    // Applied from handleAsyncUpdate() once the analysis publishes
+    autoMasterPending = started;
+    return started;
+}
+
+void AutomasterAudioProcessor::handleAsyncUpdate()
+{
+    ReferenceLoader::Result loaded;
+    if (referenceLoader.takeResult(loaded))
+        applyLoadedReference(loaded);
+
+    // A scan fills in a missing reference but never replaces the user's
+    if (referenceLibrary.takeScanCompleted() && !hasReference())
+        loadBestMatchingReference();
+
+    if (autoMasterPending)
+    {
+        if (analysisEngine.takeOfflineAnalysisCompleted())
+        {
+            // One-shot: the next auto-master looks at the newest capture again
+            if (runAutoMaster(true))
+                analysisEngine.resetAccumulation();
+        }
+        else if (!analysisEngine.isOfflineAnalysisRunning())
+        {
+            // Cancelled, superseded by an accumulation, or nothing to analyze
+            autoMasterPending = false;
+        }
+    }
 }
 
 void AutomasterAudioProcessor::applyGeneratedParameters(const ParameterGenerator::GeneratedParameters& params, float lufsForAutoGain)
 {
+    const juce::ScopedValueSetter<bool> applying(applyingSnapshot, true);
+
     // Apply EQ - using setUserValueNotifingHost for Gin parameters
     lowShelfGain->setUserValueNotifingHost(params.eq.lowShelfGain);
     highShelfGain->setUserValueNotifingHost(params.eq.highShelfGain);
@@ -390,62 +566,126 @@ void AutomasterAudioProcessor::applyGeneratedParameters(const ParameterGenerator
 
         // Add headroom reduction compensation
         // If auto-headroom reduced the input by 6dB, we need 6dB more auto-gain
-        float headroomCompensation = masteringChain.getHeadroomReduction();
+        float headroomCompensation = getMasteringChain().getHeadroomReduction();
         autoGain += headroomCompensation;
 
         // Clamp to safe range
         autoGain = juce::jlimit(-12.0f, 18.0f, autoGain);
 
-        masteringChain.getLimiter().setAutoGainValue(autoGain);
-        masteringChain.getLimiter().setAutoGainEnabled(true);
+        getMasteringChain().getLimiter().setAutoGainValue(autoGain);
+        getMasteringChain().getLimiter().setAutoGainEnabled(true);
     }
+
+    lastAutoMasterSnapshot = captureSnapshot();
+    parameterHistory.record(lastAutoMasterSnapshot, ParameterHistory::Source::AutoMaster);
 }
 
 void AutomasterAudioProcessor::recordUserAdjustment()
 {
-    // Capture current parameter state as user's preferred settings
-    userCurrentParams.eq.lowShelfGain = lowShelfGain->getProcValue();
-    userCurrentParams.eq.highShelfGain = highShelfGain->getProcValue();
-    for (int i = 0; i < 4; ++i)
-        userCurrentParams.eq.bandGain[i] = bandGain[i]->getProcValue();
+    // The user's loudness preference is the output gain they added on top of
+    // the auto-gain the last auto-master chose
+    auto userFinal = captureSnapshot();
+    userFinal[ParameterSnapshot::LimiterAutoGain] = lastAutoMasterSnapshot[ParameterSnapshot::LimiterAutoGain]
+                                                  + userFinal[ParameterSnapshot::OutputGain]
+                                                  - lastAutoMasterSnapshot[ParameterSnapshot::OutputGain];
 
-    for (int i = 0; i < 3; ++i)
+    // Record difference for learning
+    learningSystem.recordUserAdjustment(lastAutoMasterSnapshot, userFinal, rulesEngine.getGenre());
+}
+
+void AutomasterAudioProcessor::parameterGestureChanged(int, bool gestureIsStarting)
+{
+    if (!gestureIsStarting && !applyingSnapshot)
+        parameterHistory.record(captureSnapshot(), ParameterHistory::Source::User);
+}
+
+ParameterSnapshot AutomasterAudioProcessor::captureSnapshot()
+{
+    ParameterSnapshot snapshot;
+
+    for (int i = 0; i < ParameterSnapshot::NUM_PARAMETERS; ++i)
+        snapshot[i] = snapshotParameters[static_cast<size_t>(i)]->getUserValue();
+
+    const auto& limiter = getMasteringChain().getLimiter();
+    snapshot[ParameterSnapshot::LimiterAutoGain] = limiter.isAutoGainEnabled() ? limiter.getAutoGainValue() : 0.0f;
+
+    return snapshot;
+}
+
+void AutomasterAudioProcessor::applySnapshot(const ParameterSnapshot& snapshot)
+{
+    const juce::ScopedValueSetter<bool> applying(applyingSnapshot, true);
+
+    // Only parameters that differ are touched, so the host sees the minimum of changes
+    for (int i = 0; i < ParameterSnapshot::NUM_PARAMETERS; ++i)
     {
-        userCurrentParams.comp.threshold[i] = compThreshold[i]->getProcValue();
-        userCurrentParams.comp.ratio[i] = compRatio[i]->getProcValue();
+        auto* param = snapshotParameters[static_cast<size_t>(i)];
+        if (param->getUserValue() != snapshot[i])
+            param->setUserValueNotifingHost(snapshot[i]);
     }
 
-    userCurrentParams.stereo.globalWidth = globalWidth->getProcValue();
-    userCurrentParams.limiter.autoGain = outputGain->getProcValue();
-    userCurrentParams.limiter.ceiling = ceiling->getProcValue();
+    auto& limiter = getMasteringChain().getLimiter();
+    limiter.setAutoGainValue(snapshot[ParameterSnapshot::LimiterAutoGain]);
+    limiter.setAutoGainEnabled(snapshot[ParameterSnapshot::LimiterAutoGain] != 0.0f);
+}
 
-    // Record difference for learning
-    learningSystem.recordUserAdjustment(lastGeneratedParams, userCurrentParams, rulesEngine.getGenre());
+bool AutomasterAudioProcessor::undoParameterChange()
+{
+    if (!parameterHistory.canUndo())
+        return false;
+
+    applySnapshot(parameterHistory.undo());
+    return true;
+}
+
+bool AutomasterAudioProcessor::redoParameterChange()
+{
+    if (!parameterHistory.canRedo())
+        return false;
+
+    applySnapshot(parameterHistory.redo());
+    return true;
 }
 
 void AutomasterAudioProcessor::storeState(int slot)
 {
-    if (slot >= 0 && slot < 4)
+    if (slot >= 0 && slot < ComparisonChains::NUM_SLOTS)
     {
-        juce::MemoryOutputStream stream(comparisonStates[slot].parameterState, false);
-        state.writeToStream(stream);
+        comparisonStates[slot].parameters = captureSnapshot();
         comparisonStates[slot].isValid = true;
+        comparisonChains.storeSlot(slot);
     }
 }
 
+void AutomasterAudioProcessor::clearState(int slot)
+{
+    // The selected slot always has a state; its chain is the audible one
+    if (slot < 0 || slot >= ComparisonChains::NUM_SLOTS || slot == comparisonChains.getSelectedSlot())
+        return;
+
+    comparisonStates[slot].isValid = false;
+    comparisonChains.releaseSlot(slot);
+}
+
 void AutomasterAudioProcessor::recallState(int slot)
 {
-    if (slot >= 0 && slot < 4 && comparisonStates[slot].isValid)
-    {
-        juce::MemoryInputStream stream(comparisonStates[slot].parameterState, false);
-        auto recalled = juce::ValueTree::readFromStream(stream);
-        if (recalled.isValid())
-        {
-            state.copyPropertiesAndChildrenFrom(recalled, nullptr);
-            // Trigger state update
-            stateUpdated();
-        }
-    }
+    const int previous = comparisonChains.getSelectedSlot();
+    if (slot < 0 || slot >= ComparisonChains::NUM_SLOTS || slot == previous)
+        return;
+
+    // Edits since the last store stay with the slot being left, whose chain
+    // keeps running with them; an empty slot starts as a copy of the current settings
+    storeState(previous);
+    if (!comparisonStates[slot].isValid)
+        storeState(slot);
+
+    // The slot's chain already runs its settings and crossfades in once warm;
+    // parameters only need to follow
+    comparisonChains.selectSlot(slot);
+    applySnapshot(comparisonStates[slot].parameters);
+    comparisonChains.attachParameters(slot);
+
+    parameterHistory.record(comparisonStates[slot].parameters, ParameterHistory::Source::Recall);
 }
 
 juce::AudioProcessorEditor* AutomasterAudioProcessor::createEditor()
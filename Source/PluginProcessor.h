@@ -1,15 +1,21 @@
 #pragma once
 
 #include <gin_plugin/gin_plugin.h>
-#include "DSP/MasteringChain.h"
+#include "DSP/ComparisonChains.h"
 #include "DSP/AnalysisEngine.h"
+#include "DSP/MeteringService.h"
 #include "DSP/ParameterGenerator.h"
+#include "DSP/ParameterHistory.h"
 #include "DSP/ReferenceProfile.h"
+#include "DSP/ReferenceLoader.h"
+#include "DSP/ReferenceLibrary.h"
 #include "AI/RulesEngine.h"
 #include "AI/LearningSystem.h"
 #include "AI/FeatureExtractor.h"
 
-class AutomasterAudioProcessor : public gin::Processor
+class AutomasterAudioProcessor : public gin::Processor,
+                                 private juce::AudioProcessorParameter::Listener,
+                                 private juce::AsyncUpdater
 {
 public:
     AutomasterAudioProcessor();
@@ -21,24 +27,61 @@ public:
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
 
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override { return true; }
 
-    // Module access for UI
-    MasteringChain& getMasteringChain() { return masteringChain; }
+    // Module access for UI (the chain of the selected comparison slot)
+    MasteringChain& getMasteringChain() { return comparisonChains.getSelectedChain(); }
     AnalysisEngine& getAnalysisEngine() { return analysisEngine; }
+    const MeteringService& getMeteringService() const { return metering; }
+    LoudnessCompliance::Report getComplianceReport() const { return metering.getComplianceReport(); }
     RulesEngine& getRulesEngine() { return rulesEngine; }
     LearningSystem& getLearningSystem() { return learningSystem; }
 
-    // Reference profile management
+    // Reference profile management. Loading decodes in the background and
+    // applies the profile when done; false if the file can't be opened.
     bool loadReferenceFile(const juce::File& file);
     void clearReference();
     const ReferenceProfile& getReferenceProfile() const { return currentReference; }
     bool hasReference() const { return currentReference.isProfileValid(); }
 
-    // Auto-master trigger
-    void triggerAutoMaster();
+    bool isReferenceLoading() const { return referenceLoader.isLoading(); }
+    float getReferenceLoadProgress() const { return referenceLoader.getProgress(); }
+    juce::String getLoadingReferenceName() const { return referenceLoader.getLoadingFile().getFileName(); }
+
+    // Reference library: a folder indexed in the background. When a scan
+    // finishes with no reference set, the one closest to the current mix
+    // is loaded.
+    bool scanReferenceLibrary(const juce::File& folder) { return referenceLibrary.scanFolder(folder); }
+    bool isReferenceLibraryScanning() const { return referenceLibrary.isScanning(); }
+    float getReferenceLibraryProgress() const { return referenceLibrary.getProgress(); }
+    const ReferenceLibrary& getReferenceLibrary() const { return referenceLibrary; }
+
+    // Loads the library reference that best matches the current analysis;
+    // false if the library is empty or nothing has been analysed
+    bool loadBestMatchingReference();
+
+    // The loaded reference's waveform pyramid; the version bumps whenever
+    // a reference is applied or cleared
+    std::shared_ptr<const WaveformPyramid> getReferenceWaveform() const { return referenceWaveform; }
+    juce::String getReferenceFileName() const { return referenceFile.getFileName(); }
+    double getReferenceDuration() const { return referenceDuration; }
+    int getReferenceVersion() const { return referenceVersion; }
+
+    // Auto-master trigger. Without an accumulated analysis it first analyzes
+    // the captured input in the background and applies when that finishes.
+    // True if parameters were applied now.
+    bool triggerAutoMaster();
+
+    // Auto-master from a bounce of the mix: analyzes the file in the
+    // background (by default only its loudest stretch) and applies when
+    // that finishes. False if the file can't be read.
+    bool autoMasterFromFile(const juce::File& file, bool loudestSectionOnly = true);
+    bool isOfflineAnalysisRunning() const { return analysisEngine.isOfflineAnalysisRunning(); }
+    float getOfflineAnalysisProgress() const { return analysisEngine.getOfflineAnalysisProgress(); }
     void applyGeneratedParameters(const ParameterGenerator::GeneratedParameters& params, float lufsForAutoGain = -100.0f);
 
     // Accumulation controls (Ozone-style workflow)
@@ -56,6 +99,18 @@ public:
     // A/B/C/D comparison states
     void storeState(int slot);
     void recallState(int slot);
+    void clearState(int slot);  // Stops the slot's chain; not the selected slot
+    int getSelectedSlot() const { return comparisonChains.getSelectedSlot(); }
+
+    // Undo/redo over user edits, auto-master runs and slot recalls
+    bool undoParameterChange();
+    bool redoParameterChange();
+    bool canUndoParameterChange() const { return parameterHistory.canUndo(); }
+    bool canRedoParameterChange() const { return parameterHistory.canRedo(); }
+
+    // Every parameter plus the limiter's auto-gain, in ParameterSnapshot order
+    ParameterSnapshot captureSnapshot();
+    void applySnapshot(const ParameterSnapshot& snapshot);
 
     // Get current generated parameters for UI display
     const ParameterGenerator::GeneratedParameters& getLastGeneratedParams() const
@@ -109,10 +164,28 @@ public:
     gin::Parameter::Ptr limiterBypass;
 
 private:
-    void updateProcessingFromParameters();
+    void updateProcessingFromParameters(MasteringChain& chain);
+    void applyLoadedReference(ReferenceLoader::Result& loaded);
+
+    // juce::AudioProcessorParameter::Listener: a finished gesture is one user adjustment
+    void parameterValueChanged(int, float) override {}
+    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override;
+
+    // juce::AsyncUpdater: an offline analysis, a reference load or a library scan finished
+    void handleAsyncUpdate() override;
 
-    // Processing
-    MasteringChain masteringChain;
+    // offlineAnalysisLanded: the analysis a pending auto-master waited for
+    // has just finished, so its accumulation is used as is
+    bool runAutoMaster(bool offlineAnalysisLanded);
+
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer);
+
+    // Processing: one chain per comparison slot
+    ComparisonChains comparisonChains;
+
+    // Metering: one pass per tap point, shared by the chains, analysis and UI
+    MeteringService metering;
 
     // Analysis
     AnalysisEngine analysisEngine;
@@ -124,18 +197,30 @@ private:
 
     // Reference
     ReferenceProfile currentReference;
+    ReferenceLoader referenceLoader;
+    ReferenceLibrary referenceLibrary;
+    std::shared_ptr<const WaveformPyramid> referenceWaveform;
+    juce::File referenceFile;
+    double referenceDuration = 0.0;
+    int referenceVersion = 0;
 
     // State
     ParameterGenerator::GeneratedParameters lastGeneratedParams;
-    ParameterGenerator::GeneratedParameters userCurrentParams;
+    ParameterSnapshot lastAutoMasterSnapshot;  // State right after the last auto-master, for learning
+    bool autoMasterPending = false;             // Waiting on the captured-input or file analysis
+
+    // Parameter history; programmatic changes are recorded as one entry, not per parameter
+    std::array<gin::Parameter*, ParameterSnapshot::NUM_PARAMETERS> snapshotParameters {};
+    ParameterHistory parameterHistory;
+    bool applyingSnapshot = false;
 
     // A/B/C/D comparison
     struct SavedState
     {
-        juce::MemoryBlock parameterState;
+        ParameterSnapshot parameters;
         bool isValid = false;
     };
-    std::array<SavedState, 4> comparisonStates;
+    std::array<SavedState, ComparisonChains::NUM_SLOTS> comparisonStates;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AutomasterAudioProcessor)
 };
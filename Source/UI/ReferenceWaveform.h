@@ -2,54 +2,90 @@
 
 #include "LookAndFeel.h"
 #include "../DSP/ReferenceProfile.h"
+#include "../DSP/WaveformPyramid.h"
 #include <juce_gui_basics/juce_gui_basics.h>
-#include <juce_audio_formats/juce_audio_formats.h>
+#include <memory>
+#include <vector>
 
 class ReferenceWaveform : public juce::Component
 {
 public:
-    ReferenceWaveform()
+    ReferenceWaveform() = default;
+
+    // A loaded reference, shown whole until zoomed with the mouse wheel
+    void setWaveform(std::shared_ptr<const WaveformPyramid> pyramid, const juce::String& name, double durationSeconds)
     {
-        formatManager.registerBasicFormats();
+        waveform = std::move(pyramid);
+        fileName = name;
+        duration = durationSeconds;
+        hasFile = waveform != nullptr && !waveform->isEmpty();
+        isLoading = false;
+        resetZoom();
+        repaint();
     }
 
-    void loadFile(const juce::File& file)
+    // Shown instead of the waveform while a reference decodes or a library
+    // indexes in the background. Progress 0-1; repaints on whole-percent
+    // changes only.
+    void setLoading(const juce::String& message, float progress)
     {
-        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
-
-        if (reader != nullptr)
-        {
-            // Read audio for waveform display
-            int maxSamples = static_cast<int>(std::min(reader->lengthInSamples,
-                                                        static_cast<juce::int64>(reader->sampleRate * 30)));
-
-            juce::AudioBuffer<float> buffer(reader->numChannels, maxSamples);
-            reader->read(&buffer, 0, maxSamples, 0, true, true);
+        if (isLoading && message == loadingMessage
+            && juce::roundToInt(progress * 100.0f) == juce::roundToInt(loadProgress * 100.0f))
+            return;
 
-            // Generate waveform thumbnail
-            generateWaveform(buffer);
+        isLoading = true;
+        loadingMessage = message;
+        loadProgress = progress;
+        repaint();
+    }
 
-            fileName = file.getFileName();
-            duration = reader->lengthInSamples / reader->sampleRate;
-            hasFile = true;
-        }
-        else
-        {
-            hasFile = false;
-        }
+    void stopLoading()
+    {
+        if (!isLoading)
+            return;
 
+        isLoading = false;
         repaint();
     }
 
     void clear()
     {
-        waveformPoints.clear();
+        waveform.reset();
         hasFile = false;
+        isLoading = false;
         fileName = "";
         duration = 0.0;
         repaint();
     }
 
+    // Zooms around the mouse; double-click shows the whole track again
+    void mouseWheelMove(const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel) override
+    {
+        if (!hasFile || getWidth() <= 0)
+            return;
+
+        const int64_t length = waveform->getLengthInSamples();
+        const double viewLength = static_cast<double>(viewEnd - viewStart);
+        const double anchor = static_cast<double>(viewStart) + viewLength * e.position.x / getWidth();
+        if (viewLength <= 0.0)
+            return;
+
+        // A reference shorter than the closest zoom just stays whole
+        const double zoomed = juce::jlimit(juce::jmin<double>(MIN_VIEW_SAMPLES, length), static_cast<double>(length),
+                                           viewLength * std::pow(2.0, -wheel.deltaY * 4.0));
+
+        const double start = juce::jlimit(0.0, static_cast<double>(length) - zoomed, anchor - (anchor - viewStart) * zoomed / viewLength);
+        viewStart = static_cast<int64_t>(start);
+        viewEnd = std::min(length, viewStart + static_cast<int64_t>(zoomed));
+        repaint();
+    }
+
+    void mouseDoubleClick(const juce::MouseEvent&) override
+    {
+        resetZoom();
+        repaint();
+    }
+
     void setProfile(const ReferenceProfile* profile)
     {
         referenceProfile = profile;
@@ -64,6 +100,15 @@ public:
         g.setColour(AutomasterColors::panelBg);
         g.fillRoundedRectangle(bounds, 4.0f);
 
+        if (isLoading)
+        {
+            g.setColour(AutomasterColors::textMuted);
+            g.setFont(13.0f);
+            g.drawText(loadingMessage + "... " + juce::String(juce::roundToInt(loadProgress * 100.0f)) + "%",
+                       bounds, juce::Justification::centred);
+            return;
+        }
+
         if (!hasFile)
         {
             // Empty state
@@ -74,58 +119,41 @@ public:
             return;
         }
 
-        // Draw waveform
+        // Draw waveform: one min/max/RMS column per pixel of the current view
         auto waveformBounds = bounds.reduced(5.0f, 20.0f);
+        const int numPixels = static_cast<int>(waveformBounds.getWidth());
 
-        // Waveform fill
-        g.setColour(AutomasterColors::primary.withAlpha(0.3f));
-        juce::Path waveformPath;
-
-        if (!waveformPoints.empty())
-        {
-            float xStep = waveformBounds.getWidth() / (waveformPoints.size() - 1);
-            float centerY = waveformBounds.getCentreY();
-
-            // Upper half
-            waveformPath.startNewSubPath(waveformBounds.getX(), centerY);
-            for (size_t i = 0; i < waveformPoints.size(); ++i)
-            {
-                float x = waveformBounds.getX() + i * xStep;
-                float y = centerY - waveformPoints[i] * waveformBounds.getHeight() * 0.5f;
-                waveformPath.lineTo(x, y);
-            }
-
-            // Lower half (mirror)
-            for (int i = static_cast<int>(waveformPoints.size()) - 1; i >= 0; --i)
-            {
-                float x = waveformBounds.getX() + i * xStep;
-                float y = centerY + waveformPoints[i] * waveformBounds.getHeight() * 0.5f;
-                waveformPath.lineTo(x, y);
-            }
-
-            waveformPath.closeSubPath();
-            g.fillPath(waveformPath);
-        }
-
-        // Waveform outline
-        g.setColour(AutomasterColors::primary);
-        if (!waveformPoints.empty())
+        if (numPixels > 1)
         {
-            juce::Path outlinePath;
-            float xStep = waveformBounds.getWidth() / (waveformPoints.size() - 1);
-            float centerY = waveformBounds.getCentreY();
+            peaks.resize(static_cast<size_t>(numPixels));
+            waveform->getRange(viewStart, viewEnd, peaks.data(), numPixels);
 
-            outlinePath.startNewSubPath(waveformBounds.getX(),
-                                         centerY - waveformPoints[0] * waveformBounds.getHeight() * 0.5f);
+            const float centerY = waveformBounds.getCentreY();
+            const float halfHeight = waveformBounds.getHeight() * 0.5f;
+            const auto xAt = [&](int pixel) { return waveformBounds.getX() + static_cast<float>(pixel); };
 
-            for (size_t i = 1; i < waveformPoints.size(); ++i)
+            // Envelope traced along the top, back along the bottom
+            const auto makeEnvelope = [&](auto upper, auto lower)
             {
-                float x = waveformBounds.getX() + i * xStep;
-                float y = centerY - waveformPoints[i] * waveformBounds.getHeight() * 0.5f;
-                outlinePath.lineTo(x, y);
-            }
-
-            g.strokePath(outlinePath, juce::PathStrokeType(1.0f));
+                juce::Path path;
+                path.startNewSubPath(xAt(0), centerY - upper(peaks[0]) * halfHeight);
+                for (int i = 1; i < numPixels; ++i)
+                    path.lineTo(xAt(i), centerY - upper(peaks[static_cast<size_t>(i)]) * halfHeight);
+                for (int i = numPixels - 1; i >= 0; --i)
+                    path.lineTo(xAt(i), centerY - lower(peaks[static_cast<size_t>(i)]) * halfHeight);
+                path.closeSubPath();
+                return path;
+            };
+
+            // Peak range
+            g.setColour(AutomasterColors::primary.withAlpha(0.3f));
+            g.fillPath(makeEnvelope([](const WaveformPyramid::Peak& p) { return p.max; },
+                                    [](const WaveformPyramid::Peak& p) { return p.min; }));
+
+            // RMS body
+            g.setColour(AutomasterColors::primary.withAlpha(0.6f));
+            g.fillPath(makeEnvelope([](const WaveformPyramid::Peak& p) { return p.rms; },
+                                    [](const WaveformPyramid::Peak& p) { return -p.rms; }));
         }
 
         // File name and duration
@@ -148,7 +176,7 @@ public:
             g.setFont(10.0f);
             juce::String profileInfo = juce::String::formatted(
                 "LUFS: %.1f  Width: %.2f  Crest: %.1fdB",
-                referenceProfile->getLoudnessRMS(),
+                referenceProfile->getIntegratedLoudness(),
                 referenceProfile->getStereoWidth(),
                 referenceProfile->getCrestFactor());
 
@@ -158,38 +186,22 @@ public:
     }
 
 private:
-    void generateWaveform(const juce::AudioBuffer<float>& buffer)
-    {
-        waveformPoints.clear();
-
-        // Downsample to ~200 points for display
-        int numPoints = 200;
-        int samplesPerPoint = buffer.getNumSamples() / numPoints;
-
-        if (samplesPerPoint < 1)
-            samplesPerPoint = 1;
+    static constexpr int64_t MIN_VIEW_SAMPLES = WaveformPyramid::BASE_SAMPLES * 16;
 
-        for (int i = 0; i < numPoints; ++i)
-        {
-            int startSample = i * samplesPerPoint;
-            int endSample = std::min(startSample + samplesPerPoint, buffer.getNumSamples());
-
-            float maxVal = 0.0f;
-            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
-            {
-                for (int s = startSample; s < endSample; ++s)
-                {
-                    maxVal = std::max(maxVal, std::abs(buffer.getSample(ch, s)));
-                }
-            }
-
-            waveformPoints.push_back(maxVal);
-        }
+    void resetZoom()
+    {
+        viewStart = 0;
+        viewEnd = waveform != nullptr ? waveform->getLengthInSamples() : 0;
     }
 
-    juce::AudioFormatManager formatManager;
-    std::vector<float> waveformPoints;
+    std::shared_ptr<const WaveformPyramid> waveform;
+    std::vector<WaveformPyramid::Peak> peaks;  // Paint scratch, one per pixel
+    int64_t viewStart = 0;                     // Visible samples
+    int64_t viewEnd = 0;
     bool hasFile = false;
+    bool isLoading = false;
+    juce::String loadingMessage;
+    float loadProgress = 0.0f;
     juce::String fileName;
     double duration = 0.0;
     const ReferenceProfile* referenceProfile = nullptr;